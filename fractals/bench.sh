@@ -0,0 +1,226 @@
+#!/bin/sh
+#
+# Name: Matt Hamrick
+# ID: 1000433109
+#
+# Description:
+#  thread-scaling benchmark suite for mandel and mandelseries. It renders the same view with mandel
+#  for every combination of thread count (-n), image size and max iterations, then renders the
+#  50-frame zoom series with mandelseries for every process count, and with mandel -Z for the same
+#  number of threads. Every configuration is run a few times, and the median and 95th percentile
+#  times (nearest rank) are printed and saved to a CSV file, along with the speedup over the first
+#  thread or process count.
+#
+#  If a baseline CSV is there, every configuration whose median is more than BENCH_TOLERANCE percent
+#  slower than the baseline's is flagged as a regression, and the script exits with an error.
+#  Running it with --baseline saves the results as the new baseline instead.
+#
+#  mandelseries renders its frames at a fixed view (600x600, -m 7000) and pauses for a second once
+#  the last mandel process has started, which is included in its times.
+#
+#  Row-by-row bands are also compared with bands walked in Z-ordered tiles (-z) on a wide image,
+#  where a row no longer fits in cache. If perf is installed and the CPU's counters can be read,
+#  the cache references and misses of both runs are counted with perf stat and saved to a second
+#  CSV file, so the difference in cache misses shows up alongside the difference in time.
+#  -z stays experimental (off by default, and not used by -Z) until this shows it's a gain.
+#
+# Usage:
+#  ./bench.sh [--baseline]
+#
+# What gets measured can be changed through the environment, e.g.:
+#  BENCH_THREADS="1 4 16" BENCH_SIZES=800 BENCH_MAXES="1000 5000" BENCH_RUNS=7 ./bench.sh
+#  BENCH_SERIES=0 ./bench.sh --baseline
+#  BENCH_TRAVERSAL_SIZE="16000 1000" BENCH_PERF=0 ./bench.sh
+#
+
+MANDEL=${MANDEL:-./mandel}
+MANDELSERIES=${MANDELSERIES:-./mandelseries}
+BENCH_ARGS=${BENCH_ARGS:-"-x -.163013 -y -1.03265 -s .0005"}
+BENCH_THREADS=${BENCH_THREADS:-"1 2 4 8"}
+BENCH_SIZES=${BENCH_SIZES:-"500 1000"}
+BENCH_MAXES=${BENCH_MAXES:-"500 2000"}
+BENCH_RUNS=${BENCH_RUNS:-5}
+BENCH_SERIES=${BENCH_SERIES:-1}
+BENCH_PROCS=${BENCH_PROCS:-"1 2 4 8"}
+BENCH_SERIES_RUNS=${BENCH_SERIES_RUNS:-3}
+BENCH_CSV=${BENCH_CSV:-bench.csv}
+BENCH_BASELINE=${BENCH_BASELINE:-bench-baseline.csv}
+BENCH_TOLERANCE=${BENCH_TOLERANCE:-10}
+BENCH_TRAVERSAL=${BENCH_TRAVERSAL:-1}
+BENCH_TRAVERSAL_SIZE=${BENCH_TRAVERSAL_SIZE:-"8000 1000"}
+BENCH_TRAVERSAL_MAX=${BENCH_TRAVERSAL_MAX:-200}
+BENCH_TRAVERSAL_ARGS=${BENCH_TRAVERSAL_ARGS:-"-x -0.5 -s 1.5"}
+BENCH_PERF=${BENCH_PERF:-1}
+BENCH_CACHE_CSV=${BENCH_CACHE_CSV:-bench-cache.csv}
+
+SAVE_BASELINE=0
+if [ "$1" = "--baseline" ]; then
+  SAVE_BASELINE=1
+elif [ -n "$1" ]; then
+  echo "usage: $0 [--baseline]"
+  exit 1
+fi
+
+if [ ! -x "$MANDEL" ]; then
+  echo "error: $MANDEL not found, run make first"
+  exit 1
+fi
+if [ "$BENCH_SERIES" -ne 0 ] && [ ! -x "$MANDELSERIES" ]; then
+  echo "error: $MANDELSERIES not found, run make mandelseries first"
+  exit 1
+fi
+
+# mandelseries runs ./mandel and writes its frames to the current directory, so the series
+# are rendered in a scratch directory with a link to mandel
+WORKDIR=$(mktemp -d /tmp/bench.XXXXXX)
+MANDEL_PATH=$(cd "$(dirname "$MANDEL")" && pwd)/$(basename "$MANDEL")
+MANDELSERIES_PATH=$(cd "$(dirname "$MANDELSERIES")" && pwd)/$(basename "$MANDELSERIES")
+ln -s "$MANDEL_PATH" $WORKDIR/mandel
+RESULTS=$WORKDIR/results.csv
+echo "program,workers,size,max,runs,median_usec,p95_usec,min_usec,speedup" > $RESULTS
+
+# runs a command BENCH_RUNS (or $RUNS) times in the scratch directory and prints the median, 95th
+# percentile and fastest of the times it reports, in usec. The time is taken from the line starting
+# with the given prefix
+time_runs()
+{
+  prefix=$1
+  shift
+  times=""
+  run=0
+  while [ $run -lt $RUNS ]; do
+    usec=$( cd $WORKDIR && "$@" | sed -n "s/^$prefix: Computed time taken (in usec): //p" )
+    if [ -z "$usec" ]; then
+      echo "error: no time reported by: $*" >&2
+      rm -rf $WORKDIR
+      exit 1
+    fi
+    times="$times $usec"
+    run=$(( run + 1 ))
+  done
+  printf "%s\n" $times | sort -n | awk '{ t[NR] = $1 } END {
+    median = NR % 2 ? t[(NR+1)/2] : ( t[NR/2] + t[NR/2+1] ) / 2
+    rank = int( 0.95 * NR ); if( rank < 0.95 * NR ) rank++
+    printf "%d %d %d\n", median, t[rank], t[1]
+  }'
+}
+
+# prints the cache references and misses perf stat counts for a command, or nothing if they can't be counted
+cache_counts()
+{
+  ( cd $WORKDIR && perf stat -x, -e cache-references,cache-misses -- "$@" 2>&1 >/dev/null ) |
+    awk -F, '$3 ~ /^cache-references/ { refs = $1 } $3 ~ /^cache-misses/ { misses = $1 }
+      END { if( refs ~ /^[0-9]+$/ && misses ~ /^[0-9]+$/ ) printf "%d %d\n", refs, misses }'
+}
+
+# prints one result and adds it to the CSV. The speedup is against $BASE_MEDIAN, the median of the
+# first worker count in the group, which is set by the first result of every group
+record()
+{
+  program=$1 workers=$2 size=$3 max=$4
+  set -- $5
+  median=$1 p95=$2 fastest=$3
+  if [ "$workers" = "$FIRST_WORKERS" ]; then
+    BASE_MEDIAN=$median
+  fi
+  speedup=$( awk -v b=$BASE_MEDIAN -v m=$median 'BEGIN { printf "%.2f", b/m }' )
+  printf "%-13s %8s %6s %6s %14s %14s %8sx\n" $program $workers $size $max $median $p95 $speedup
+  echo "$program,$workers,$size,$max,$RUNS,$median,$p95,$fastest,$speedup" >> $RESULTS
+}
+
+printf "%-13s %8s %6s %6s %14s %14s %9s\n" program workers size max median_usec p95_usec speedup
+
+RUNS=$BENCH_RUNS
+FIRST_WORKERS=$( echo $BENCH_THREADS | cut -d' ' -f1 )
+for size in $BENCH_SIZES; do
+  for max in $BENCH_MAXES; do
+    for n in $BENCH_THREADS; do
+      record mandel $n $size $max "$( time_runs mandel "$MANDEL_PATH" $BENCH_ARGS -W $size -H $size -m $max -n $n -o bench.bmp -t )"
+    done
+  done
+done
+
+if [ "$BENCH_SERIES" -ne 0 ]; then
+  RUNS=$BENCH_SERIES_RUNS
+  FIRST_WORKERS=$( echo $BENCH_PROCS | cut -d' ' -f1 )
+  for n in $BENCH_PROCS; do
+    record mandelseries $n 600 7000 "$( time_runs mandelseries "$MANDELSERIES_PATH" $n )"
+  done
+  for n in $BENCH_PROCS; do
+    record mandel-Z $n 600 7000 "$( time_runs mandel "$MANDEL_PATH" -x -.163013 -y -1.03265 -s .000025 -m 7000 -W 600 -H 600 -Z 50 -n $n -o bench.bmp -t )"
+  done
+fi
+
+if [ "$BENCH_TRAVERSAL" -ne 0 ]; then
+  RUNS=$BENCH_RUNS
+  set -- $BENCH_TRAVERSAL_SIZE
+  width=$1 height=$2
+  n=$( echo $BENCH_THREADS | awk '{ print $NF }' )
+  traversal="$BENCH_TRAVERSAL_ARGS -W $width -H $height -m $BENCH_TRAVERSAL_MAX -n $n -o bench.bmp -t"
+
+  # the tiled run's speedup is against the row-by-row run
+  FIRST_WORKERS=$n
+  record mandel-rows $n ${width}x$height $BENCH_TRAVERSAL_MAX "$( time_runs mandel "$MANDEL_PATH" $traversal )"
+  FIRST_WORKERS=
+  record mandel-tiled $n ${width}x$height $BENCH_TRAVERSAL_MAX "$( time_runs mandel "$MANDEL_PATH" $traversal -z )"
+
+  if [ "$BENCH_PERF" -ne 0 ] && command -v perf > /dev/null; then
+    rows=$( cache_counts "$MANDEL_PATH" $traversal )
+    tiled=$( cache_counts "$MANDEL_PATH" $traversal -z )
+    if [ -n "$rows" ] && [ -n "$tiled" ]; then
+      echo "program,workers,size,max,cache_references,cache_misses,miss_percent" > "$BENCH_CACHE_CSV"
+      printf "%-13s %14s %14s %9s\n" program cache_refs cache_misses miss_pct
+      for result in "mandel-rows $rows" "mandel-tiled $tiled"; do
+        set -- $result
+        percent=$( awk -v r=$2 -v m=$3 'BEGIN { printf "%.2f", r ? m*100/r : 0 }' )
+        printf "%-13s %14s %14s %8s%%\n" $1 $2 $3 $percent
+        echo "$1,$n,${width}x$height,$BENCH_TRAVERSAL_MAX,$2,$3,$percent" >> "$BENCH_CACHE_CSV"
+      done
+      echo "cache counts saved to $BENCH_CACHE_CSV"
+    else
+      echo "perf couldn't read the cache counters here, skipping them"
+    fi
+  elif [ "$BENCH_PERF" -ne 0 ]; then
+    echo "perf isn't installed, skipping the cache counters"
+  fi
+fi
+
+cp $RESULTS "$BENCH_CSV"
+echo "results saved to $BENCH_CSV"
+
+if [ $SAVE_BASELINE -eq 1 ]; then
+  cp $RESULTS "$BENCH_BASELINE"
+  echo "baseline saved to $BENCH_BASELINE"
+  rm -rf $WORKDIR
+  exit 0
+fi
+
+if [ ! -f "$BENCH_BASELINE" ]; then
+  echo "no baseline in $BENCH_BASELINE to compare against, save one with $0 --baseline"
+  rm -rf $WORKDIR
+  exit 0
+fi
+
+# compare every configuration that's in both files by its median
+awk -F, -v tolerance=$BENCH_TOLERANCE '
+  FNR == 1 { next }
+  NR == FNR { baseline[$1","$2","$3","$4] = $6; next }
+  {
+    key = $1","$2","$3","$4
+    if( !( key in baseline ) ) next
+    compared++
+    change = ( $6 - baseline[key] ) * 100 / baseline[key]
+    if( change > tolerance ) {
+      dims = $3 ~ /x/ ? $3 : $3"x"$3
+      printf "REGRESSION: %s -n %s %s -m %s: median %d usec, %.1f%% slower than the baseline (%d usec)\n", $1, $2, dims, $4, $6, change, baseline[key]
+      regressions++
+    }
+  }
+  END {
+    printf "%d of %d configurations more than %s%% slower than the baseline\n", regressions, compared, tolerance
+    exit regressions > 0
+  }' "$BENCH_BASELINE" $RESULTS
+status=$?
+
+rm -rf $WORKDIR
+exit $status
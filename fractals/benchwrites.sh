@@ -0,0 +1,57 @@
+#!/bin/sh
+#
+# Name: Matt Hamrick
+# ID: 1000433109
+#
+# Description:
+#  benchmarks mandel's pixel write paths against each other. For each thread count it
+#  renders the same image with the old mutex-per-pixel writes (-L) and with the lock-free
+#  row writes, keeps the best of a few runs, and prints the throughput of both.
+#
+# Usage:
+#  ./benchwrites.sh [thread counts...]      (default: 1 2 4 8 16 32)
+#
+# The view, size and repetitions can be changed through the environment, e.g.:
+#  BENCH_ARGS="-s 2 -m 100" BENCH_SIZE=1000 BENCH_RUNS=5 ./benchwrites.sh 1 4 16
+#
+
+MANDEL=${MANDEL:-./mandel}
+BENCH_ARGS=${BENCH_ARGS:-"-s 2 -m 50"}
+BENCH_SIZE=${BENCH_SIZE:-1500}
+BENCH_RUNS=${BENCH_RUNS:-3}
+THREADS=${*:-"1 2 4 8 16 32"}
+
+if [ ! -x "$MANDEL" ]; then
+  echo "error: $MANDEL not found, run make first"
+  exit 1
+fi
+
+PIXELS=$(( BENCH_SIZE * BENCH_SIZE ))
+OUTFILE=$(mktemp /tmp/benchwrites.XXXXXX)
+
+# runs mandel BENCH_RUNS times with the given extra flags and prints the fastest time in usec
+best_time()
+{
+  best=""
+  run=0
+  while [ $run -lt $BENCH_RUNS ]; do
+    usec=$( $MANDEL $BENCH_ARGS -W $BENCH_SIZE -H $BENCH_SIZE -o $OUTFILE -t "$@" | sed -n 's/^mandel: Computed time taken (in usec): //p' )
+    if [ -z "$best" ] || [ "$usec" -lt "$best" ]; then
+      best=$usec
+    fi
+    run=$(( run + 1 ))
+  done
+  echo $best
+}
+
+echo "mandel $BENCH_ARGS -W $BENCH_SIZE -H $BENCH_SIZE, best of $BENCH_RUNS runs"
+printf "%8s %14s %14s %14s %14s %8s\n" threads locked_usec locked_Mpx/s lockfree_usec lockfree_Mpx/s speedup
+for n in $THREADS; do
+  locked=$( best_time -n $n -L )
+  lockfree=$( best_time -n $n )
+  awk -v n=$n -v l=$locked -v f=$lockfree -v p=$PIXELS 'BEGIN {
+    printf "%8d %14d %14.2f %14d %14.2f %7.2fx\n", n, l, p/l, f, p/f, l/f
+  }'
+done
+
+rm -f $OUTFILE
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
 
 #include "bitmap.h"
 
@@ -18,7 +21,7 @@ struct bitmap * bitmap_create( int w, int h )
 	m = malloc(sizeof *m);
 	if(!m) return 0;
 
-	m->data = malloc(w*h*sizeof(int));
+	m->data = malloc((size_t)w*h*sizeof(int));
 	if(!m->data) {
 		free(m);
 		return 0;
@@ -38,8 +41,8 @@ void bitmap_delete( struct bitmap *m )
 
 void bitmap_reset( struct bitmap *m, int value )
 {
-	int i;
-	for(i=0;i<(m->width*m->height);i++) {
+	size_t i, size = (size_t)m->width*m->height;
+	for(i=0;i<size;i++) {
 		m->data[i] = value;
 	}
 }
@@ -51,7 +54,7 @@ int bitmap_get( struct bitmap *m, int x, int y )
 	while(x<0)         x+=m->width;
 	while(y<0)         y+=m->height;
 
-	return m->data[y*m->width+x];
+	return m->data[(size_t)y*m->width+x];
 }
 
 void bitmap_set( struct bitmap *m, int x, int y, int value )
@@ -61,7 +64,7 @@ void bitmap_set( struct bitmap *m, int x, int y, int value )
 	while(x<0)         x+=m->width;
 	while(y<0)         y+=m->height;
 
-	m->data[y*m->width+x] = value;
+	m->data[(size_t)y*m->width+x] = value;
 }
 
 int bitmap_width( struct bitmap *m )
@@ -98,39 +101,80 @@ struct bmp_header {
 	int	ncolors;
 	int	icolors;
 };
+#pragma pack()
+
+struct bitmap_stream {
+	int fd;
+	int width;
+	int height;
+	size_t rowsize;
+	unsigned char *scanlines;
+	size_t scanrows;
+};
+
+/* the size fields only hold 32 bits, so they're left at 0 for images too big for them */
+static void bitmap_header_init( struct bmp_header *header, int w, int h )
+{
+	unsigned long long bytes = (unsigned long long)w*h*3;
+
+	memset(header,0,sizeof(*header));
+	header->magic1 = 'B';
+	header->magic2 = 'M';
+	header->size   = bytes<=0xffffffffULL ? (int)(unsigned)bytes : 0;
+	header->offset = sizeof(*header);
+	header->infosize = sizeof(*header)-14;
+	header->width = w;
+	header->height = h;
+	header->planes = 1;
+	header->bits = 24;
+	header->compression = 0;
+	header->imagesize = header->size;
+	header->xres = 1000;
+	header->yres = 1000;
+}
+
+/* each scanline is padded to a multiple of four bytes, with the bytes it starts with */
+static size_t bitmap_pad_length( int w )
+{
+	int padlength = 4 - ((size_t)w*3)%4;
+	if(padlength==4) padlength=0;
+	return padlength;
+}
 
 int bitmap_save( struct bitmap *m, const char *path )
 {
 	FILE *file;
-	struct bmp_header header;
-	int i, j;
-	unsigned char *scanline, *s;
+	int written;
 
 	file = fopen(path,"wb");
 	if(!file) return 0;
 
-	memset(&header,0,sizeof(header));
-	header.magic1 = 'B';
-	header.magic2 = 'M';
-	header.size   = m->width*m->height*3;
-	header.offset = sizeof(header);
-	header.infosize = sizeof(header)-14;
-	header.width = m->width;
-	header.height = m->height;
-	header.planes = 1;
-	header.bits = 24;
-	header.compression = 0;
-	header.imagesize = m->width*m->height*3;
-	header.xres = 1000;
-	header.yres = 1000;
+	written = bitmap_write(m,file);
+
+	fclose(file);
+	return written;
+}
+
+long long bitmap_file_size( int w, int h )
+{
+	return (long long)sizeof(struct bmp_header) + ((long long)w*3 + bitmap_pad_length(w))*h;
+}
+
+int bitmap_write( struct bitmap *m, FILE *file )
+{
+	struct bmp_header header;
+	int i, j;
+	unsigned char *scanline, *s;
+
+	bitmap_header_init(&header,m->width,m->height);
 
 	fwrite(&header,1,sizeof(header),file);
 
 	/* if the scanline is not a multiple of four, round it up. */
-	int padlength = 4 - (m->width*3)%4;
-	if(padlength==4) padlength=0;
+	size_t padlength = bitmap_pad_length(m->width);
 
-	scanline = malloc(header.width*3);
+	scanline = malloc((size_t)m->width*3);
+	if(!scanline) return 0;
 
 	for(j=0;j<m->height;j++) {
 		s = scanline;
@@ -140,23 +184,22 @@ int bitmap_save( struct bitmap *m, const char *path )
 			*s++ = GET_GREEN(rgba);
 			*s++ = GET_RED(rgba);
 		}
-		fwrite(scanline,1,m->width*3,file);
+		fwrite(scanline,1,(size_t)m->width*3,file);
 		fwrite(scanline,1,padlength,file);
 	}
 
 	free(scanline);
 
-	fclose(file);
-	return 1;
+	return !ferror(file);
 }
 
 struct bitmap * bitmap( const char *path )
 {
 	FILE *file;
-	int size;
+	size_t size;
 	struct bitmap *m;
 	struct bmp_header header;
-	int i;
+	size_t i;
 
 	file = fopen(path,"rb");
 	if(!file) return 0;
@@ -181,7 +224,7 @@ struct bitmap * bitmap( const char *path )
 		return 0;
 	}
 
-	size = header.width*header.height;
+	size = (size_t)header.width*header.height;
 	for(i=0;i<size;i++) {
 		int r,g,b;
 		b = fgetc(file);
@@ -197,3 +240,92 @@ struct bitmap * bitmap( const char *path )
 	fclose(file);
 	return m;
 }
+
+struct bitmap_stream * bitmap_stream_open( const char *path, int w, int h )
+{
+	struct bitmap_stream *s;
+	struct bmp_header header;
+
+	s = malloc(sizeof *s);
+	if(!s) return 0;
+
+	s->fd = open(path,O_WRONLY|O_CREAT|O_TRUNC,0666);
+	if(s->fd<0) {
+		free(s);
+		return 0;
+	}
+
+	s->width = w;
+	s->height = h;
+	s->rowsize = (size_t)w*3 + bitmap_pad_length(w);
+	s->scanlines = 0;
+	s->scanrows = 0;
+
+	/* the file gets its full size up front, so rows can be written to it in any order */
+	bitmap_header_init(&header,w,h);
+	if(pwrite(s->fd,&header,sizeof(header),0)!=sizeof(header) ||
+	   ftruncate(s->fd,(off_t)sizeof(header) + (off_t)s->rowsize*h)!=0) {
+		int saved = errno;
+		close(s->fd);
+		free(s);
+		errno = saved;
+		return 0;
+	}
+
+	return s;
+}
+
+int bitmap_stream_write( struct bitmap_stream *s, int y, int rows, const int *data )
+{
+	size_t i, j, total = s->rowsize*rows;
+	unsigned char *p;
+	off_t offset = (off_t)sizeof(struct bmp_header) + (off_t)s->rowsize*y;
+
+	if(y<0 || rows<0 || y+rows>s->height) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	if((size_t)rows>s->scanrows) {
+		p = realloc(s->scanlines,total);
+		if(!p) return 0;
+		s->scanlines = p;
+		s->scanrows = rows;
+	}
+
+	/* the same bytes bitmap_save() writes for these rows */
+	for(j=0;j<(size_t)rows;j++) {
+		unsigned char *line = s->scanlines + j*s->rowsize;
+		const int *row = data + j*s->width;
+		p = line;
+		for(i=0;i<(size_t)s->width;i++) {
+			*p++ = GET_BLUE(row[i]);
+			*p++ = GET_GREEN(row[i]);
+			*p++ = GET_RED(row[i]);
+		}
+		memcpy(p,line,s->rowsize-(size_t)s->width*3);
+	}
+
+	p = s->scanlines;
+	while(total>0) {
+		ssize_t written = pwrite(s->fd,p,total,offset);
+		if(written<0) {
+			if(errno==EINTR) continue;
+			return 0;
+		}
+		p += written;
+		offset += written;
+		total -= written;
+	}
+
+	return 1;
+}
+
+int bitmap_stream_close( struct bitmap_stream *s )
+{
+	int result = close(s->fd)==0;
+
+	free(s->scanlines);
+	free(s);
+	return result;
+}
@@ -2,6 +2,8 @@
 #ifndef BITMAP_H
 #define BITMAP_H
 
+#include <stdio.h>
+
 struct bitmap * bitmap_create( int w, int h );
 void            bitmap_delete( struct bitmap *b );
 struct bitmap * bitmap_load( const char *file );
@@ -14,6 +16,25 @@ int   bitmap_height( struct bitmap *b );
 void  bitmap_reset( struct bitmap *b, int value );
 int  *bitmap_data( struct bitmap *b );
 
+/*
+bitmap_write writes the same bytes bitmap_save() does to a file that's already open,
+such as a socket, and bitmap_file_size says how many bytes that will be for a w x h image.
+*/
+
+int       bitmap_write( struct bitmap *b, FILE *file );
+long long bitmap_file_size( int w, int h );
+
+/*
+A bitmap stream writes an image straight into its BMP file a band of rows at a time,
+for images too big to hold in memory all at once. Rows can be written in any order
+(row 0 is the first one after the header, the same as bitmap_save()), and the bytes
+that end up in the file are exactly the ones bitmap_save() would have written.
+*/
+
+struct bitmap_stream * bitmap_stream_open( const char *file, int w, int h );
+int                    bitmap_stream_write( struct bitmap_stream *s, int y, int rows, const int *data );
+int                    bitmap_stream_close( struct bitmap_stream *s );
+
 #ifndef MAKE_RGBA
 /** Create a 32-bit RGBA value from 8-bit red, green, blue, and alpha values */
 #define MAKE_RGBA(r,g,b,a) ( (((int)(a))<<24) | (((int)(r))<<16) | (((int)(g))<<8) | (((int)(b))<<0) )
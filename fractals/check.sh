@@ -0,0 +1,78 @@
+#!/bin/sh
+#
+# Name: Matt Hamrick
+# ID: 1000433109
+#
+# Description:
+#  checks that mandel's escape-time kernels and interior checks don't change the image. For
+#  every view it renders a reference with the scalar kernel, then renders the view again with
+#  every kernel (-K) on its own and with the cardioid/bulb check (-c), the periodicity check (-P)
+#  and both, and compares each image with the reference byte for byte. Kernels the CPU can't
+#  run are skipped. Exits with an error if any image differs.
+#
+# Usage:
+#  ./check.sh
+#
+# What gets checked can be changed through the environment, e.g.:
+#  CHECK_KERNELS="scalar avx2" CHECK_SIZE="640 480" CHECK_THREADS=8 ./check.sh
+#
+
+MANDEL=${MANDEL:-./mandel}
+CHECK_KERNELS=${CHECK_KERNELS:-"scalar sse2 avx2 avx512"}
+CHECK_SIZE=${CHECK_SIZE:-"300 200"}
+CHECK_THREADS=${CHECK_THREADS:-3}
+
+if [ ! -x "$MANDEL" ]; then
+  echo "error: $MANDEL not found, run make first"
+  exit 1
+fi
+
+WIDTH=${CHECK_SIZE% *}
+HEIGHT=${CHECK_SIZE#* }
+REFERENCE=$(mktemp /tmp/check.XXXXXX)
+OUTFILE=$(mktemp /tmp/check.XXXXXX)
+trap 'rm -f "$REFERENCE" "$OUTFILE"' EXIT
+
+failed=0
+
+# kernels the CPU can't run are refused by -K, so they're left out up front
+kernels=""
+for kernel in $CHECK_KERNELS; do
+  if $MANDEL -K $kernel -W 1 -H 1 -o "$OUTFILE" >/dev/null 2>&1; then
+    kernels="$kernels $kernel"
+  else
+    echo "skip  -K $kernel: not supported here"
+  fi
+done
+
+# renders a view with every kernel and check, and compares each image with its scalar reference
+check_view() {
+  if ! $MANDEL "$@" -K scalar -W $WIDTH -H $HEIGHT -o "$REFERENCE" >/dev/null; then
+    echo "FAIL  $*: the scalar reference didn't render"
+    failed=$((failed + 1))
+    return
+  fi
+
+  for kernel in $kernels; do
+    for checks in "" "-c" "-P" "-c -P"; do
+      if $MANDEL "$@" -K $kernel $checks -W $WIDTH -H $HEIGHT -n $CHECK_THREADS -o "$OUTFILE" >/dev/null &&
+        cmp -s "$OUTFILE" "$REFERENCE"; then
+        echo "ok    $* -K $kernel $checks"
+      else
+        echo "FAIL  $* -K $kernel $checks"
+        failed=$((failed + 1))
+      fi
+    done
+  done
+}
+
+# the whole set, a seahorse valley view and a spiral
+check_view -x -0.5 -s 1.5 -m 1000
+check_view -x -.163013 -y -1.03265 -s .0005 -m 2000
+check_view -x -0.7453 -y 0.1127 -s 6.5e-4 -m 3000
+
+if [ $failed -gt 0 ]; then
+  echo "check: $failed images differ from the scalar reference"
+  exit 1
+fi
+echo "check: every image matches the scalar reference"
@@ -0,0 +1,499 @@
+/*
+ * Name: Matt Hamrick
+ * ID: 1000433109
+ * 
+ * Description:
+ *  turns the raw iteration counts saved by mandel -I into a BMP, with any of a few palettes
+ *  and optional smooth (fractional iteration) coloring, without computing the image again.
+ *  The rows are split into bands across -n threads, and the per-pixel loops are written so
+ *  the compiler can vectorize them (and builds an AVX2 copy that's picked at runtime).
+ * 
+ * Same colors mandel itself would have produced:
+ * ./mandel -s .000025 -y -1.03265 -m 7000 -x -.163013 -W 600 -H 600 -I mandel.iter
+ * ./colorize -i mandel.iter -o gray.bmp
+ * 
+ * Smooth coloring with a repeating palette:
+ * ./colorize -i mandel.iter -o fire.bmp -p fire -s -c 200 -n 4
+ * 
+ */
+
+#include "bitmap.h"
+#include "iterfile.h"
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/time.h>
+
+// enable/disable debug output
+bool DBG = false;
+
+// enable/disable timing output
+bool TIMING = false;
+
+// a palette is a gradient through these colors, evenly spaced from one end to the other
+#define MAX_PALETTE_STOPS 8
+struct palette{
+  const char * name;
+  int numStops;
+  int stops[MAX_PALETTE_STOPS];
+  // the color for points that never escaped
+  int interior;
+};
+
+// gray has to stay first: it's the default, and matches mandel's own iteration_to_color()
+const struct palette PALETTES[] = {
+  { "gray", 2, { MAKE_RGBA(0,0,0,0), MAKE_RGBA(255,255,255,0) }, MAKE_RGBA(255,255,255,0) },
+  { "fire", 5, { MAKE_RGBA(0,0,0,0), MAKE_RGBA(128,0,0,0), MAKE_RGBA(255,64,0,0), MAKE_RGBA(255,200,0,0), MAKE_RGBA(255,255,255,0) }, MAKE_RGBA(0,0,0,0) },
+  { "ocean", 4, { MAKE_RGBA(0,0,32,0), MAKE_RGBA(0,64,160,0), MAKE_RGBA(0,200,255,0), MAKE_RGBA(255,255,255,0) }, MAKE_RGBA(0,0,0,0) },
+  { "rainbow", 7, { MAKE_RGBA(255,0,0,0), MAKE_RGBA(255,160,0,0), MAKE_RGBA(255,255,0,0), MAKE_RGBA(0,255,0,0),
+                    MAKE_RGBA(0,160,255,0), MAKE_RGBA(128,0,255,0), MAKE_RGBA(255,0,0,0) }, MAKE_RGBA(0,0,0,0) },
+};
+#define NUM_PALETTES ( (int) ( sizeof(PALETTES) / sizeof(PALETTES[0]) ) )
+
+// this struct holds the arguments that will get passed to the colorizeBand function
+struct colorizeBandParams{
+  struct iterfile * theIterations;
+  struct bitmap * theBitmap;
+  // the color for every whole iteration count from 0 to max+1
+  const int * lut;
+  int interior;
+  bool smooth;
+  int rowStart;
+  int rowEnd;
+};
+
+// function declarations (implementations after main())
+static int * buildLut( const struct palette * pal, int max, int cycle );
+static int paletteColor( const struct palette * pal, double position );
+void * colorizeBand( void * );
+static void colorizeRow( const int * iters, const float * magnitudes, int * pixels, int width, int max, const int * lut, int interior, bool smooth );
+static long elapsedUsec( struct timeval * start, struct timeval * end );
+
+void show_help()
+{
+  int i;
+  printf("Use: colorize [options]\n");
+  printf("Where options are:\n");
+  printf("-i <file>    Iteration file saved by mandel -I. (default=mandel.iter)\n");
+  printf("-o <file>    Set output file. (default=colorize.bmp)\n");
+  printf("-p <palette> Palette to color with:");
+  for( i=0 ; i<NUM_PALETTES ; i++ )
+  {
+    printf(" %s", PALETTES[i].name);
+  }
+  printf(". (default=gray)\n");
+  printf("-s           Smooth coloring, using |z| at escape to blend between iteration counts.\n");
+  printf("-c <iters>   Repeat the palette every this many iterations. (default=once over 0 to max)\n");
+  printf("-n <threads> Number of threads to use. (default=1)\n");
+  printf("-h           Show this help text.\n");
+  printf("\nSome examples are:\n");
+  printf("colorize -i mandel.iter -o gray.bmp\n");
+  printf("colorize -i mandel.iter -o fire.bmp -p fire -s -c 200 -n 4\n\n");
+}
+
+int main( int argc, char *argv[] )
+{
+  // declare the vars that hold time values, just in case timing has been enabled
+  struct timeval colorizeStart;
+  struct timeval colorizeEnd;
+
+  const char * infile = "mandel.iter";
+  const char * outfile = "colorize.bmp";
+  const struct palette * pal = &PALETTES[0];
+  bool smooth = false;
+  int cycle = 0;
+  int numThreads = 1;
+
+  char c;
+  while((c = getopt(argc,argv,"i:o:p:c:n:shdt"))!=-1) {
+    switch(c) {
+      case 'i':
+        infile = optarg;
+        break;
+      case 'o':
+        outfile = optarg;
+        break;
+      case 'p':
+      {
+        int i;
+        pal = NULL;
+        for( i=0 ; i<NUM_PALETTES ; i++ )
+        {
+          if( strcmp( optarg, PALETTES[i].name ) == 0 )
+          {
+            pal = &PALETTES[i];
+          }
+        }
+        if( pal == NULL )
+        {
+          printf("Invalid value for parameter -p, please try again. Please use colorize -h to see the help output.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      }
+      case 's':
+        smooth = true;
+        break;
+      case 'c':
+        cycle = atoi(optarg);
+        break;
+      case 'n':
+        numThreads = atoi(optarg);
+        break;
+      case 'd':
+        DBG = true;
+        break;
+      case 't':
+        TIMING = true;
+        break;
+      case 'h':
+        show_help();
+        exit(1);
+        break;
+    }
+  }
+
+  if( numThreads < 1 )
+  {
+    printf("Invalid value for parameter -n, please try again. Please use colorize -h to see the help output.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if( cycle < 0 )
+  {
+    printf("Invalid value for parameter -c, please try again. Please use colorize -h to see the help output.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // iterfile_load() has already said what's wrong with a file it could read but not make sense of, 
+  // and errno is only set when the file couldn't be read at all
+  errno = 0;
+  struct iterfile * iterations = iterfile_load(infile);
+  if( iterations == NULL )
+  {
+    if( errno != 0 )
+    {
+      fprintf(stderr,"colorize: couldn't read %s: %s\n",infile,strerror(errno));
+    }
+    else
+    {
+      fprintf(stderr,"colorize: couldn't read %s\n",infile);
+    }
+    exit(EXIT_FAILURE);
+  }
+
+  int width = iterfile_width(iterations);
+  int height = iterfile_height(iterations);
+  int max = iterfile_max(iterations);
+
+  printf("colorize: infile=%s width=%d height=%d max=%d palette=%s smooth=%s cycle=%d numThreads=%d outfile=%s\n",
+    infile,width,height,max,pal->name,smooth ? "yes" : "no",cycle,numThreads,outfile);
+
+  struct bitmap * bm = bitmap_create(width,height);
+  int * lut = buildLut(pal,max,cycle);
+  struct colorizeBandParams * bandArgsArr = (struct colorizeBandParams *) calloc( numThreads, sizeof(struct colorizeBandParams) );
+  pthread_t * threadsArr = (pthread_t *) calloc( numThreads, sizeof(pthread_t) );
+  if( bm == NULL || lut == NULL || bandArgsArr == NULL || threadsArr == NULL )
+  {
+    printf("There was a problem. Please try again.\n");
+    if(DBG)
+    {
+      printf("ERROR -> main(): allocating the bitmap, lookup table or thread arrays failed\n");
+    }
+    exit(EXIT_FAILURE);
+  }
+
+  if(TIMING)
+  {
+    gettimeofday( &colorizeStart, NULL );
+  }
+
+  // every thread gets an even band of rows, with the last one taking whatever is left over
+  int i;
+  for( i=0 ; i<numThreads ; i++ )
+  {
+    bandArgsArr[i].theIterations = iterations;
+    bandArgsArr[i].theBitmap = bm;
+    bandArgsArr[i].lut = lut;
+    bandArgsArr[i].interior = pal->interior;
+    bandArgsArr[i].smooth = smooth;
+    bandArgsArr[i].rowStart = (int) ( (long) i * height / numThreads );
+    bandArgsArr[i].rowEnd = (int) ( (long) (i+1) * height / numThreads );
+  }
+
+  if( numThreads > 1 )
+  {
+    for( i=0 ; i<numThreads ; i++ )
+    {
+      int returnCode = pthread_create( &threadsArr[i], NULL, colorizeBand, (void *) &bandArgsArr[i] );
+      if( returnCode != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+        if(DBG)
+        {
+          printf( "ERROR -> main(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+        }
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    for( i=0 ; i<numThreads ; i++ )
+    {
+      int joinResult = pthread_join( threadsArr[i], NULL );
+      if( DBG && joinResult != 0 )
+      {
+        printf( "ERROR -> main(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+      }
+    }
+  }
+  else
+  {
+    colorizeBand( (void *) &bandArgsArr[0] );
+  }
+
+  if(TIMING)
+  {
+    gettimeofday( &colorizeEnd, NULL );
+  }
+
+  if(!bitmap_save(bm,outfile)) {
+    fprintf(stderr,"colorize: couldn't write to %s: %s\n",outfile,strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  if(TIMING)
+  {
+    printf( "colorize: Computed time taken (in usec): %ld\n", elapsedUsec( &colorizeStart, &colorizeEnd ) );
+  }
+
+  free(threadsArr);
+  free(bandArgsArr);
+  free(lut);
+  bitmap_delete(bm);
+  iterfile_delete(iterations);
+
+  if(DBG)
+  {
+    printf("DEBUG: main() exiting...\n");
+  }
+  exit(EXIT_SUCCESS);
+} // main()
+
+/*
+ * function: 
+ *  buildLut
+ * 
+ * description: 
+ *  Works out the color of every whole iteration count from 0 to max+1 once, so coloring a pixel
+ *    is a table lookup (or a blend of two neighbouring entries when smoothing).
+ *  Without a cycle the palette is stretched once over 0 to max. The gray palette then uses
+ *    exactly the same integer math as mandel's iteration_to_color(), so it reproduces mandel's image.
+ * 
+ * parameters:
+ *  const struct palette * pal: the palette to color with
+ *  int max: the max iterations the image was computed with
+ *  int cycle: how many iterations the palette repeats over, or 0 to stretch it over 0 to max
+ * 
+ * returns: 
+ *  int *: the max+2 colors, or NULL if they couldn't be allocated
+ */
+static int * buildLut( const struct palette * pal, int max, int cycle )
+{
+  int * lut = (int *) malloc( ( (size_t) max + 2 ) * sizeof(int) );
+  if( lut == NULL )
+  {
+    return NULL;
+  }
+
+  int i;
+  for( i=0 ; i<=max+1 ; i++ )
+  {
+    if( cycle > 0 )
+    {
+      lut[i] = paletteColor( pal, (double) ( i % cycle ) / cycle );
+    }
+    else if( pal == &PALETTES[0] )
+    {
+      int gray = 255 * ( i < max ? i : max ) / max;
+      lut[i] = MAKE_RGBA(gray,gray,gray,0);
+    }
+    else
+    {
+      lut[i] = paletteColor( pal, i < max ? (double) i / max : 1.0 );
+    }
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: buildLut(): %d colors from the %s palette\n", max+2, pal->name );
+  }
+  return lut;
+} // buildLut()
+
+/*
+ * function: 
+ *  paletteColor
+ * 
+ * description: 
+ *  Returns the color at a position along a palette's gradient, blending the two nearest stops.
+ * 
+ * parameters:
+ *  const struct palette * pal: the palette
+ *  double position: where along the gradient, from 0 (the first stop) to 1 (the last)
+ * 
+ * returns: 
+ *  int: the RGBA color
+ */
+static int paletteColor( const struct palette * pal, double position )
+{
+  double scaled = position * ( pal->numStops - 1 );
+  int stop = (int) scaled;
+  if( stop >= pal->numStops - 1 )
+  {
+    return pal->stops[pal->numStops - 1];
+  }
+
+  double blend = scaled - stop;
+  int from = pal->stops[stop];
+  int to = pal->stops[stop+1];
+  int r = (int) ( GET_RED(from) + blend * ( GET_RED(to) - GET_RED(from) ) + 0.5 );
+  int g = (int) ( GET_GREEN(from) + blend * ( GET_GREEN(to) - GET_GREEN(from) ) + 0.5 );
+  int b = (int) ( GET_BLUE(from) + blend * ( GET_BLUE(to) - GET_BLUE(from) ) + 0.5 );
+  return MAKE_RGBA(r,g,b,0);
+} // paletteColor()
+
+/*
+ * function: 
+ *  colorizeBand
+ * 
+ * description: 
+ *  Thread entry point (also called directly when only one thread is used) that colors the rows
+ *    rowStart up to (but not including) rowEnd, one row at a time.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type colorizeBandParams
+ * 
+ * returns: 
+ *  void *
+ */
+void * colorizeBand( void * args )
+{
+  struct colorizeBandParams * params = args;
+  int width = iterfile_width( params->theIterations );
+  int max = iterfile_max( params->theIterations );
+  int * iters = iterfile_iters( params->theIterations );
+  float * magnitudes = iterfile_magnitudes( params->theIterations );
+  int * pixels = bitmap_data( params->theBitmap );
+
+  int j;
+  for( j=params->rowStart ; j<params->rowEnd ; j++ )
+  {
+    size_t offset = (size_t) j * width;
+    colorizeRow( iters + offset, magnitudes + offset, pixels + offset, width, max, params->lut, params->interior, params->smooth );
+  }
+
+  return NULL;
+} // colorizeBand()
+
+/*
+ * function: 
+ *  colorizeRow
+ * 
+ * description: 
+ *  Colors one row of pixels. Points that never escaped get the palette's interior color and the
+ *    rest are looked up by their iteration count.
+ *  With smoothing, the count n becomes the fractional n + 1 - log2(log2|z|), which runs continuously
+ *    from one count to the next, and the pixel is blended between the two table entries around it.
+ *    Pixels without a known magnitude (0) just use their count. The logarithms use a quick
+ *    polynomial (good to about 0.005) on the float's bits, which unlike logf() vectorizes.
+ *  Compiled twice, for AVX2 and for the baseline instruction set, and the right one is picked at runtime.
+ * 
+ * parameters:
+ *  const int * iters: the iteration counts of the row
+ *  const float * magnitudes: |z| at escape for each pixel of the row, or 0 if unknown
+ *  int * pixels: receives the colors
+ *  int width: the number of pixels in the row
+ *  int max: the max iterations the image was computed with
+ *  const int * lut: the color of every count from 0 to max+1
+ *  int interior: the color for points that never escaped
+ *  bool smooth: whether to blend between counts
+ * 
+ * returns: 
+ *  void
+ */
+__attribute__((target_clones("avx2","default")))
+static void colorizeRow( const int * iters, const float * magnitudes, int * pixels, int width, int max, const int * lut, int interior, bool smooth )
+{
+  int i;
+  if( !smooth )
+  {
+    for( i=0 ; i<width ; i++ )
+    {
+      pixels[i] = iters[i] >= max ? interior : lut[ iters[i] < 0 ? 0 : iters[i] ];
+    }
+    return;
+  }
+
+  for( i=0 ; i<width ; i++ )
+  {
+    int n = iters[i] < 0 ? 0 : iters[i];
+    float magnitude = magnitudes[i] > 2.0f ? magnitudes[i] : 2.0f;
+
+    // log2 of |z| (which is over 2, so this is over 1), then log2 of that
+    int bits;
+    float mantissa;
+    memcpy( &bits, &magnitude, sizeof(bits) );
+    float log2Magnitude = (float) ( ( ( bits >> 23 ) & 255 ) - 128 );
+    bits = ( bits & 0x007fffff ) | 0x3f800000;
+    memcpy( &mantissa, &bits, sizeof(mantissa) );
+    log2Magnitude += ( -0.34484843f * mantissa + 2.02466578f ) * mantissa - 0.67487759f;
+
+    memcpy( &bits, &log2Magnitude, sizeof(bits) );
+    float log2Log2Magnitude = (float) ( ( ( bits >> 23 ) & 255 ) - 128 );
+    bits = ( bits & 0x007fffff ) | 0x3f800000;
+    memcpy( &mantissa, &bits, sizeof(mantissa) );
+    log2Log2Magnitude += ( -0.34484843f * mantissa + 2.02466578f ) * mantissa - 0.67487759f;
+
+    // the fractional count lands between n-1 and n+1; unknown magnitudes (clamped to 2 above) give exactly n
+    float smoothCount = magnitudes[i] > 2.0f ? n + 1 - log2Log2Magnitude : n;
+    int low = (int) smoothCount;
+    low = low < 0 ? 0 : ( low > max ? max : low );
+    float blend = smoothCount - low;
+    blend = blend < 0 ? 0 : ( blend > 1 ? 1 : blend );
+
+    int from = lut[low];
+    int to = lut[low+1];
+    int r = GET_RED(from) + (int) ( blend * ( GET_RED(to) - GET_RED(from) ) );
+    int g = GET_GREEN(from) + (int) ( blend * ( GET_GREEN(to) - GET_GREEN(from) ) );
+    int b = GET_BLUE(from) + (int) ( blend * ( GET_BLUE(to) - GET_BLUE(from) ) );
+    int color = MAKE_RGBA(r,g,b,0);
+
+    pixels[i] = n >= max ? interior : color;
+  }
+} // colorizeRow()
+
+/*
+ * function: 
+ *  elapsedUsec
+ * 
+ * description: 
+ *  Returns the number of microseconds between two gettimeofday() readings.
+ * 
+ * parameters:
+ *  struct timeval * start: the earlier reading
+ *  struct timeval * end: the later reading
+ * 
+ * returns: 
+ *  long: the elapsed time in microseconds
+ */
+static long elapsedUsec( struct timeval * start, struct timeval * end )
+{
+  return ( end->tv_sec - start->tv_sec ) * 1000000L + ( end->tv_usec - start->tv_usec );
+} // elapsedUsec()
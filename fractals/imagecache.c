@@ -0,0 +1,251 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include "imagecache.h"
+
+#define IMAGECACHE_SUFFIX ".iter"
+#define IMAGECACHE_STATS "stats"
+
+struct imagecache {
+	char *dir;
+	long long limit;
+	struct imagecache_stats run;
+};
+
+/* a file in the directory, for picking the least recently used ones to evict */
+struct imagecache_entry {
+	char *name;
+	long long bytes;
+	struct timespec used;
+};
+
+static char * imagecache_path( struct imagecache *c, const char *name, const char *suffix )
+{
+	size_t size = strlen(c->dir)+strlen(name)+strlen(suffix)+2;
+	char *path = malloc(size);
+
+	if(path) snprintf(path,size,"%s/%s%s",c->dir,name,suffix);
+	return path;
+}
+
+struct imagecache * imagecache_open( const char *dir, long long limit )
+{
+	struct imagecache *c;
+
+	if(mkdir(dir,0777)!=0 && errno!=EEXIST) return 0;
+
+	c = calloc(1,sizeof *c);
+	if(!c) return 0;
+
+	c->dir = strdup(dir);
+	if(!c->dir) {
+		free(c);
+		return 0;
+	}
+	c->limit = limit;
+
+	return c;
+}
+
+/* the running totals in the stats file, or all 0 if it's empty */
+static void imagecache_read_totals( FILE *file, struct imagecache_stats *s )
+{
+	memset(s,0,sizeof *s);
+	rewind(file);
+	if(fscanf(file,"%lld %lld %lld",&s->hits,&s->misses,&s->evictions)!=3) {
+		memset(s,0,sizeof *s);
+	}
+}
+
+void imagecache_close( struct imagecache *c )
+{
+	struct imagecache_stats totals;
+	char *path = imagecache_path(c,IMAGECACHE_STATS,"");
+	int fd = path ? open(path,O_RDWR|O_CREAT,0666) : -1;
+	FILE *file = fd>=0 ? fdopen(fd,"r+") : 0;
+
+	/* the totals only ever grow, so writing them over the old ones never leaves any of those behind */
+	if(file) {
+		flock(fd,LOCK_EX);
+		imagecache_read_totals(file,&totals);
+		rewind(file);
+		fprintf(file,"%lld %lld %lld\n",totals.hits+c->run.hits,totals.misses+c->run.misses,
+			totals.evictions+c->run.evictions);
+		fclose(file);
+	} else if(fd>=0) {
+		close(fd);
+	}
+
+	free(path);
+	free(c->dir);
+	free(c);
+}
+
+/* every cached file in the directory, and how many bytes they add up to. Returns how many there are, or -1 */
+static int imagecache_scan( struct imagecache *c, struct imagecache_entry **entries, long long *bytes )
+{
+	DIR *dir;
+	struct dirent *d;
+	struct stat info;
+	struct imagecache_entry *grown;
+	size_t length, suffix = strlen(IMAGECACHE_SUFFIX);
+	int n = 0, size = 0;
+
+	*entries = 0;
+	*bytes = 0;
+
+	dir = opendir(c->dir);
+	if(!dir) return -1;
+
+	while((d = readdir(dir))) {
+		length = strlen(d->d_name);
+		if(length<=suffix || strcmp(d->d_name+length-suffix,IMAGECACHE_SUFFIX)!=0) continue;
+
+		/* another process may have evicted it since it was listed */
+		if(fstatat(dirfd(dir),d->d_name,&info,0)!=0) continue;
+
+		if(n==size) {
+			size = size ? size*2 : 64;
+			grown = realloc(*entries,size*sizeof **entries);
+			if(!grown) break;
+			*entries = grown;
+		}
+		(*entries)[n].name = strdup(d->d_name);
+		if(!(*entries)[n].name) break;
+		(*entries)[n].bytes = info.st_size;
+		(*entries)[n].used = info.st_mtim;
+		*bytes += info.st_size;
+		n++;
+	}
+
+	closedir(dir);
+	return n;
+}
+
+static void imagecache_free_entries( struct imagecache_entry *entries, int n )
+{
+	int i;
+
+	for(i=0;i<n;i++) free(entries[i].name);
+	free(entries);
+}
+
+static int imagecache_compare_used( const void *a, const void *b )
+{
+	const struct imagecache_entry *x = a, *y = b;
+
+	if(x->used.tv_sec!=y->used.tv_sec) return x->used.tv_sec<y->used.tv_sec ? -1 : 1;
+	if(x->used.tv_nsec!=y->used.tv_nsec) return x->used.tv_nsec<y->used.tv_nsec ? -1 : 1;
+	return 0;
+}
+
+/* deletes the least recently used files until the rest fit in the limit */
+static void imagecache_evict( struct imagecache *c )
+{
+	struct imagecache_entry *entries;
+	long long bytes;
+	char *path;
+	int i, n;
+
+	n = imagecache_scan(c,&entries,&bytes);
+	if(n<0) return;
+
+	if(bytes>c->limit) {
+		qsort(entries,n,sizeof *entries,imagecache_compare_used);
+		for(i=0;i<n && bytes>c->limit;i++) {
+			path = imagecache_path(c,entries[i].name,"");
+			if(path && unlink(path)==0) c->run.evictions++;
+			bytes -= entries[i].bytes;
+			free(path);
+		}
+	}
+
+	imagecache_free_entries(entries,n);
+}
+
+struct iterfile * imagecache_get( struct imagecache *c, const char *key, int w, int h, int max )
+{
+	struct iterfile *f = 0;
+	char *path = imagecache_path(c,key,IMAGECACHE_SUFFIX);
+
+	if(path) f = iterfile_load(path);
+
+	if(f && (iterfile_width(f)!=w || iterfile_height(f)!=h || iterfile_max(f)!=max)) {
+		iterfile_delete(f);
+		f = 0;
+	}
+
+	/* touching it makes it the most recently used */
+	if(f) {
+		c->run.hits++;
+		utimensat(AT_FDCWD,path,0,0);
+	} else {
+		c->run.misses++;
+	}
+
+	free(path);
+	return f;
+}
+
+int imagecache_put( struct imagecache *c, const char *key, struct iterfile *f )
+{
+	char suffix[32];
+	char *temp, *path;
+	int saved;
+
+	snprintf(suffix,sizeof suffix,".tmp%ld",(long)getpid());
+	temp = imagecache_path(c,key,suffix);
+	path = imagecache_path(c,key,IMAGECACHE_SUFFIX);
+
+	saved = temp && path && iterfile_save(f,temp) && rename(temp,path)==0;
+	if(!saved && temp) unlink(temp);
+
+	free(temp);
+	free(path);
+
+	if(saved) imagecache_evict(c);
+	return saved;
+}
+
+void imagecache_stats( struct imagecache *c, struct imagecache_stats *run, struct imagecache_stats *total )
+{
+	struct imagecache_entry *entries;
+	long long bytes;
+	char *path;
+	FILE *file;
+	int n;
+
+	n = imagecache_scan(c,&entries,&bytes);
+	if(n<0) {
+		n = 0;
+	} else {
+		imagecache_free_entries(entries,n);
+	}
+
+	*run = c->run;
+	run->entries = n;
+	run->bytes = bytes;
+
+	memset(total,0,sizeof *total);
+	path = imagecache_path(c,IMAGECACHE_STATS,"");
+	file = path ? fopen(path,"r") : 0;
+	if(file) {
+		flock(fileno(file),LOCK_SH);
+		imagecache_read_totals(file,total);
+		fclose(file);
+	}
+	free(path);
+
+	total->hits += run->hits;
+	total->misses += run->misses;
+	total->evictions += run->evictions;
+	total->entries = run->entries;
+	total->bytes = run->bytes;
+}
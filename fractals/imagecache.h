@@ -0,0 +1,37 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include "iterfile.h"
+
+/*
+An image cache is a directory of iteration files (see iterfile.h), one per rendered image,
+each named after the key it was put under, which is meant to be a hash of everything that
+decides the iteration counts of a render. So a view that has been rendered before can be
+loaded whole instead of computed.
+
+The files in the directory are kept under a limit in bytes by deleting the least recently
+used ones whenever a new one is put there. Every hit touches its file, so the modification
+times say which were used last. Several processes can share a directory: files are written
+under a temporary name and renamed into place.
+
+A process counts its own hits, misses and evictions, and imagecache_close adds them to the
+running totals kept in the "stats" file in the directory, for sizing the limit.
+imagecache_stats gives both, the totals including this process's so far. The entries and
+bytes in both are what the directory holds now.
+*/
+
+struct imagecache_stats {
+	long long hits;
+	long long misses;
+	long long evictions;
+	long long entries;
+	long long bytes;
+};
+
+struct imagecache * imagecache_open( const char *dir, long long limit );
+void                imagecache_close( struct imagecache *c );
+struct iterfile *   imagecache_get( struct imagecache *c, const char *key, int w, int h, int max );
+int                 imagecache_put( struct imagecache *c, const char *key, struct iterfile *f );
+void                imagecache_stats( struct imagecache *c, struct imagecache_stats *run, struct imagecache_stats *total );
+
+#endif
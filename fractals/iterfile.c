@@ -0,0 +1,286 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "iterfile.h"
+
+#define ITERFILE_VERSION 2
+
+struct iterfile {
+	int width;
+	int height;
+	int max;
+	int *iters;
+	float *magnitudes;
+	double *orbitx;
+	double *orbity;
+	double xmin, xmax, ymin, ymax;
+};
+
+#pragma pack(1)
+struct iterfile_header {
+	char	magic[4];
+	int	version;
+	int	width;
+	int	height;
+	int	max;
+};
+
+/* version 2 and later carry on with the orbit records and bounds */
+struct iterfile_orbit_header {
+	int	orbits;
+	double	xmin;
+	double	xmax;
+	double	ymin;
+	double	ymax;
+};
+
+struct iterfile_orbit {
+	int	index;
+	double	x;
+	double	y;
+};
+#pragma pack()
+
+struct iterfile * iterfile_create( int w, int h, int max )
+{
+	struct iterfile *f;
+
+	f = malloc(sizeof *f);
+	if(!f) return 0;
+
+	f->iters = calloc((size_t)w*h,sizeof(int));
+	f->magnitudes = calloc((size_t)w*h,sizeof(float));
+	if(!f->iters || !f->magnitudes) {
+		free(f->iters);
+		free(f->magnitudes);
+		free(f);
+		return 0;
+	}
+
+	f->orbitx = 0;
+	f->orbity = 0;
+	f->xmin = f->xmax = f->ymin = f->ymax = 0;
+	f->width = w;
+	f->height = h;
+	f->max = max;
+
+	return f;
+}
+
+void iterfile_delete( struct iterfile *f )
+{
+	free(f->iters);
+	free(f->magnitudes);
+	free(f->orbitx);
+	free(f->orbity);
+	free(f);
+}
+
+int iterfile_add_orbits( struct iterfile *f, double xmin, double xmax, double ymin, double ymax )
+{
+	size_t i, size = (size_t)f->width*f->height;
+
+	if(!f->orbitx) {
+		f->orbitx = malloc(size*sizeof(double));
+		f->orbity = malloc(size*sizeof(double));
+		if(!f->orbitx || !f->orbity) {
+			free(f->orbitx);
+			free(f->orbity);
+			f->orbitx = f->orbity = 0;
+			return 0;
+		}
+
+		/* nothing is known about any orbit yet */
+		for(i=0;i<size;i++) {
+			f->orbitx[i] = INFINITY;
+			f->orbity[i] = INFINITY;
+		}
+	}
+
+	f->xmin = xmin;
+	f->xmax = xmax;
+	f->ymin = ymin;
+	f->ymax = ymax;
+
+	return 1;
+}
+
+int iterfile_width( struct iterfile *f )
+{
+	return f->width;
+}
+
+int iterfile_height( struct iterfile *f )
+{
+	return f->height;
+}
+
+int iterfile_max( struct iterfile *f )
+{
+	return f->max;
+}
+
+int * iterfile_iters( struct iterfile *f )
+{
+	return f->iters;
+}
+
+void iterfile_set_max( struct iterfile *f, int max )
+{
+	f->max = max;
+}
+
+float * iterfile_magnitudes( struct iterfile *f )
+{
+	return f->magnitudes;
+}
+
+double * iterfile_orbit_x( struct iterfile *f )
+{
+	return f->orbitx;
+}
+
+double * iterfile_orbit_y( struct iterfile *f )
+{
+	return f->orbity;
+}
+
+void iterfile_bounds( struct iterfile *f, double *xmin, double *xmax, double *ymin, double *ymax )
+{
+	*xmin = f->xmin;
+	*xmax = f->xmax;
+	*ymin = f->ymin;
+	*ymax = f->ymax;
+}
+
+/* the pixels whose orbit is worth keeping: still at max, and not known to stay there */
+static int iterfile_orbit_kept( struct iterfile *f, size_t i )
+{
+	return f->iters[i]>=f->max && !isnan(f->orbitx[i]);
+}
+
+int iterfile_save( struct iterfile *f, const char *path )
+{
+	FILE *file;
+	struct iterfile_header header;
+	struct iterfile_orbit_header orbitheader;
+	struct iterfile_orbit orbit;
+	size_t i, size = (size_t)f->width*f->height;
+
+	file = fopen(path,"wb");
+	if(!file) return 0;
+
+	memcpy(header.magic,"MITR",4);
+	header.version = ITERFILE_VERSION;
+	header.width = f->width;
+	header.height = f->height;
+	header.max = f->max;
+
+	orbitheader.orbits = -1;
+	if(f->orbitx) {
+		orbitheader.orbits = 0;
+		for(i=0;i<size;i++) {
+			if(iterfile_orbit_kept(f,i)) orbitheader.orbits++;
+		}
+	}
+	orbitheader.xmin = f->xmin;
+	orbitheader.xmax = f->xmax;
+	orbitheader.ymin = f->ymin;
+	orbitheader.ymax = f->ymax;
+
+	if(fwrite(&header,sizeof(header),1,file)!=1 ||
+	   fwrite(&orbitheader,sizeof(orbitheader),1,file)!=1 ||
+	   fwrite(f->iters,sizeof(int),size,file)!=size ||
+	   fwrite(f->magnitudes,sizeof(float),size,file)!=size) {
+		fclose(file);
+		return 0;
+	}
+
+	for(i=0;f->orbitx && i<size;i++) {
+		if(!iterfile_orbit_kept(f,i)) continue;
+		orbit.index = (int)i;
+		orbit.x = f->orbitx[i];
+		orbit.y = f->orbity[i];
+		if(fwrite(&orbit,sizeof(orbit),1,file)!=1) {
+			fclose(file);
+			return 0;
+		}
+	}
+
+	return fclose(file)==0;
+}
+
+struct iterfile * iterfile_load( const char *path )
+{
+	FILE *file;
+	struct iterfile *f;
+	struct iterfile_header header;
+	struct iterfile_orbit_header orbitheader;
+	struct iterfile_orbit orbit;
+	size_t i, size;
+	int n;
+
+	file = fopen(path,"rb");
+	if(!file) return 0;
+
+	if(fread(&header,sizeof(header),1,file)!=1 || memcmp(header.magic,"MITR",4)!=0) {
+		printf("iterfile: %s is not an iteration file.\n",path);
+		fclose(file);
+		return 0;
+	}
+
+	/* version 1 files stop short of the orbits and bounds */
+	orbitheader.orbits = -1;
+	if(header.version<1 || header.version>ITERFILE_VERSION || header.width<1 || header.height<1 || header.max<1 ||
+	   (header.version>=2 && (fread(&orbitheader,sizeof(orbitheader),1,file)!=1 || orbitheader.orbits<-1))) {
+		printf("iterfile: sorry, %s has an unsupported version or size.\n",path);
+		fclose(file);
+		return 0;
+	}
+
+	f = iterfile_create(header.width,header.height,header.max);
+	if(!f) {
+		fclose(file);
+		return 0;
+	}
+
+	size = (size_t)header.width*header.height;
+	if(fread(f->iters,sizeof(int),size,file)!=size ||
+	   fread(f->magnitudes,sizeof(float),size,file)!=size) {
+		printf("iterfile: %s is truncated.\n",path);
+		iterfile_delete(f);
+		fclose(file);
+		return 0;
+	}
+
+	if(orbitheader.orbits>=0) {
+		if(!iterfile_add_orbits(f,orbitheader.xmin,orbitheader.xmax,orbitheader.ymin,orbitheader.ymax)) {
+			iterfile_delete(f);
+			fclose(file);
+			return 0;
+		}
+
+		/* pixels at max without a record of their own were known never to escape */
+		for(i=0;i<size;i++) {
+			f->orbitx[i] = NAN;
+			f->orbity[i] = NAN;
+		}
+
+		for(n=0;n<orbitheader.orbits;n++) {
+			if(fread(&orbit,sizeof(orbit),1,file)!=1 || orbit.index<0 || (size_t)orbit.index>=size) {
+				printf("iterfile: %s is truncated.\n",path);
+				iterfile_delete(f);
+				fclose(file);
+				return 0;
+			}
+			f->orbitx[orbit.index] = orbit.x;
+			f->orbity[orbit.index] = orbit.y;
+		}
+	}
+
+	fclose(file);
+	return f;
+}
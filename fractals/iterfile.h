@@ -0,0 +1,42 @@
+#ifndef ITERFILE_H
+#define ITERFILE_H
+
+/*
+An iteration file holds the raw result of a mandel render: the iteration count of
+every pixel, and |z| at the moment the pixel escaped, so the image can be colored
+again (smoothly, with any palette) without computing it again.
+
+It can also hold what's needed to carry on iterating the pixels that hadn't escaped
+when max was reached, so a later render with a higher max only has to continue those:
+the bounds of the image, and the orbit z of every pixel that is still at max. In memory
+the orbit of such a pixel is either its z after max iterations, NAN if it is known never
+to escape (the cardioid or periodicity check caught it), or INFINITY if its z isn't known
+and it has to be iterated again from the start.
+
+On disk it is a small header (the magic "MITR", a version, the width, height and max
+iterations and the number of orbit records, all 32-bit ints, then the image bounds
+xmin, xmax, ymin and ymax as doubles) followed by width*height 32-bit iteration counts,
+then width*height 32-bit float magnitudes, all row by row from the top, and finally the
+orbit records (a 32-bit pixel index then z as two doubles) for the pixels at max that can
+still escape, all in native byte order. A magnitude of 0 means the pixel never escaped or
+its magnitude isn't known. A record count of -1 means the file has no orbits or bounds.
+*/
+
+struct iterfile * iterfile_create( int w, int h, int max );
+void              iterfile_delete( struct iterfile *f );
+struct iterfile * iterfile_load( const char *file );
+int               iterfile_save( struct iterfile *f, const char *file );
+
+int    iterfile_width( struct iterfile *f );
+int    iterfile_height( struct iterfile *f );
+int    iterfile_max( struct iterfile *f );
+void   iterfile_set_max( struct iterfile *f, int max );
+int   *iterfile_iters( struct iterfile *f );
+float *iterfile_magnitudes( struct iterfile *f );
+
+int     iterfile_add_orbits( struct iterfile *f, double xmin, double xmax, double ymin, double ymax );
+double *iterfile_orbit_x( struct iterfile *f );
+double *iterfile_orbit_y( struct iterfile *f );
+void    iterfile_bounds( struct iterfile *f, double *xmin, double *xmax, double *ymin, double *ymax );
+
+#endif
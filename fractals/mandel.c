@@ -6,12 +6,37 @@
  *  modified mandel program (provided by instructor) that takes an additional
  *  -n parameter indicating how many threads to use to generate the output image
  * 
+ *  an optional -S parameter selects how the image is split up amongst those threads:
+ *  'band' (the default) gives each thread one fixed horizontal band, while 'steal' splits
+ *  the image into small tiles that idle threads steal from each other until the image is done.
+ *  'mariani' hands out the same tiles, but only computes the border of each one, filling it 
+ *  in when the border is uniform and subdividing it otherwise (Mariani-Silver)
+ *  an optional -p parameter selects the arithmetic: 'double' iterates every pixel directly, 'dd'
+ *  does the same in double-double arithmetic for mid-depth zooms, and 'perturb' iterates one 
+ *  reference orbit at the center in high precision and every pixel as a double-precision offset
+ *  from it, for zooms far past where doubles give out. 'auto' (the default) picks the cheapest
+ *  one that is still accurate for the pixel spacing of the image. 'float' iterates in single 
+ *  precision, which is faster but differs from double on a few boundary pixels, so it's only used when asked for
+ *  an optional -R flag renders progressively, every 8th pixel first and then ever finer grids
+ *  down to every pixel, and with -w the output file is rewritten as a preview after each pass
+ * 
  * Mandel command for the final image (with 3 total threads):
  * ./mandel -s .000025 -y -1.03265 -m 7000 -x -.163013 -W 600 -H 600 -n 3
  * 
+ * The same zoom path mandelseries renders, in one process with 8 threads:
+ * ./mandel -s .000025 -y -1.03265 -m 7000 -x -.163013 -W 600 -H 600 -n 8 -Z 50
+ * 
+ * Same image at 20000 iterations, only carrying on the pixels a first render (saved with -I mandel.iter) left unfinished:
+ * ./mandel -s .000025 -y -1.03265 -m 20000 -x -.163013 -W 600 -H 600 -n 3 -C mandel.iter
+ * 
+ * Same image, load-balanced across 32 threads with the work-stealing scheduler:
+ * ./mandel -s .000025 -y -1.03265 -m 7000 -x -.163013 -W 600 -H 600 -n 32 -S steal
+ * 
  */
 
 #include "bitmap.h"
+#include "iterfile.h"
+#include "imagecache.h"
 
 #include <getopt.h>
 #include <stdlib.h>
@@ -23,6 +48,19 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <limits.h>
+#include <ctype.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // enable/disable debug output
 bool DBG = false;
@@ -30,6 +68,298 @@ bool DBG = false;
 // enable/disable timing output
 bool TIMING = false;
 
+// the strategies computeImage() can use to split the image amongst threads
+enum schedulerType { SCHED_BAND, SCHED_STEAL, SCHED_MARIANI };
+
+// which strategy to use, selected with the -S parameter
+enum schedulerType SCHEDULER = SCHED_BAND;
+
+// the width & height, in pixels, of the tiles handed out by the work-stealing scheduler
+int TILE_SIZE = 32;
+
+// enable/disable walking each band in TILE_SIZE x TILE_SIZE tiles in Z-order (Morton order) instead 
+// of row by row, computing each tile into a buffer of its own and copying it into the bitmap at once.
+// It's off unless asked for: so far it hasn't measured any faster than rows (see the traversal part of bench.sh)
+bool TILED_BANDS = false;
+
+// the mariani scheduler stops subdividing once the inside of a rectangle is this many pixels 
+// across (or fewer) in either direction, and just computes what's left of it
+#define MARIANI_MIN_SIZE 4
+
+// where the raw iteration counts and escape magnitudes of the image go when -I is given, or NULL
+struct iterfile * RAW_OUTPUT = NULL;
+
+// with -k, images are kept in this directory as their raw iteration counts, named after a hash of everything that 
+// decides those counts, and an image that's in it already is colored from them instead of computed. The least 
+// recently used images are evicted to keep it under CACHE_LIMIT bytes (-q, in megabytes)
+const char * CACHE_DIR = NULL;
+long long CACHE_LIMIT = 256LL << 20;
+// the open -k cache, or NULL. The threads of a -F batch or a -D server share it under cacheMutex
+struct imagecache * CACHE = NULL;
+pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_KEY_LENGTH 33
+
+// bump this whenever a change to the escape-time code changes the counts it gives, so images cached before aren't used
+#define CACHE_KERNEL_VERSION 1
+
+// enable/disable re-rendering the image exhaustively afterwards and comparing every pixel
+bool VERIFY = false;
+
+// enable/disable computing only one of each pair of rows that mirror each other across the real axis, 
+// and copying it into the other. -Y turns it off
+bool MIRROR_SYMMETRY = true;
+
+// with -A every pixel whose color stands out from one of its neighbours by more than AA_EDGE_LEVELS 
+// in any channel is rendered again from an AA_SAMPLES x AA_SAMPLES grid of points around it, and set 
+// to their average color. 0 leaves the image aliased
+int AA_SAMPLES = 0;
+#define AA_EDGE_LEVELS 4
+#define AA_MAX_SAMPLES 16
+
+// enable/disable progressive rendering: the image is computed in passes, first every 
+// PROGRESSIVE_START_STEP'th pixel in each direction, then halving the step until it reaches 1.
+// If PREVIEW_FILE is set, a blocky preview of the image is saved to it after every pass
+bool PROGRESSIVE = false;
+#define PROGRESSIVE_START_STEP 8
+const char * PREVIEW_FILE = NULL;
+
+// with -B the image is streamed into the output file STREAM_ROWS rows at a time, instead of being held 
+// in memory whole and saved at the end, so its size isn't limited by memory. With -O (STREAM_OVERLAP) the 
+// whole image is held in memory as usual, but still written out PIPELINE_ROWS rows at a time while the rest 
+// is computed. STREAM_FILE is the open file and STREAM_HEIGHT the height of the whole image
+int STREAM_ROWS = 0;
+bool STREAM_OVERLAP = false;
+#define PIPELINE_ROWS 64
+struct bitmap_stream * STREAM_FILE = NULL;
+int STREAM_HEIGHT = 0;
+
+// the number of frames to render with -Z, zooming in from a scale of SERIES_START_SCALE down to 
+// the -s scale, or 0 to render just the one image
+int SERIES_FRAMES = 0;
+#define SERIES_START_SCALE 2
+
+// with -F every view listed in this manifest is rendered to its own file, in this one process
+const char * BATCH_FILE = NULL;
+
+// a thread that stays alive between images and runs whatever job it's handed next, so a series
+// of frames doesn't create and tear down a new set of threads for every one of them
+struct poolWorker{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  void * (*job)( void * );
+  void * jobArgs;
+  bool busy;
+  bool quit;
+};
+
+// the pool of persistent threads. While it's running, spawnWorker() and joinWorker() hand 
+// jobs to its threads instead of creating new ones
+struct workerPool{
+  struct poolWorker * workers;
+  int size;
+};
+struct workerPool WORKER_POOL = { NULL, 0 };
+
+// a finished frame being saved by a background thread while the next one is computed
+struct frameSave{
+  struct bitmap * theBitmap;
+  const char * filename;
+  bool saved;
+  int savedErrno;
+};
+
+// the arithmetic used to iterate the pixels, selected with the -p parameter
+enum precisionType { PRECISION_AUTO, PRECISION_DOUBLE, PRECISION_DOUBLEDOUBLE, PRECISION_PERTURB, PRECISION_FLOAT };
+enum precisionType PRECISION = PRECISION_AUTO;
+const char * PRECISION_NAMES[] = { "auto", "double", "dd", "perturb", "float" };
+
+// one view of a -F batch, and how far along it is. The tiles of the view are numbered from 
+// firstTile in the batch, and whichever thread finishes the last of them saves the bitmap.
+// With -k, a view found under key in the cache is colored from it up front and has no tiles, 
+// and the counts of any other view are gathered in counts for the cache
+struct batchJob{
+  double xcenter;
+  double ycenter;
+  char * xcenterText;
+  char * ycenterText;
+  double scale;
+  int max;
+  int width;
+  int height;
+  char * outfile;
+  enum precisionType precision;
+  int tilesAcross;
+  int tileCount;
+  long firstTile;
+  pthread_mutex_t lock;
+  bool started;
+  bool failed;
+  struct bitmap * theBitmap;
+  atomic_int tilesLeft;
+  atomic_long busyUsec;
+  struct timeval start;
+  struct timeval end;
+  bool saved;
+  int savedErrno;
+  char key[CACHE_KEY_LENGTH];
+  bool cached;
+  struct iterfile * counts;
+};
+
+// this struct holds the arguments that will get passed to the batchWorker function
+struct batchParams{
+  struct batchJob * jobs;
+  int jobCount;
+  long tileCount;
+  // the next tile of the whole batch to be handed out to a thread
+  atomic_long * nextTile;
+};
+
+// with -D mandel runs as a render server on this Unix domain socket instead of rendering one image.
+// Request lines longer than SERVER_LINE_LENGTH are refused whole, ids are cut to SERVER_ID_LENGTH-1 characters 
+// (serverReader() has that length in its sscanf() format), and views bigger than SERVER_MAX_PIXELS or with a 
+// max above SERVER_MAX_ITERATIONS are refused, so no single row of a tile can keep a thread from a cancel for long
+const char * SERVER_SOCKET = NULL;
+#define SERVER_BACKLOG 64
+#define SERVER_LINE_LENGTH 512
+#define SERVER_ID_LENGTH 64
+#define SERVER_MAX_PIXELS ( 1LL << 26 )
+#define SERVER_MAX_ITERATIONS 1000000
+
+// one connection to the server. Its reader thread holds a reference, and so does every request 
+// of it still queued. Answers are written to out under lock, so they never interleave
+struct serverClient{
+  int number;
+  FILE * in;
+  FILE * out;
+  pthread_mutex_t lock;
+  int refs;
+};
+
+// one RENDER request, queued until its last tile is done. Its tiles are handed out in order 
+// from nextTile, and tilesLeft counts the ones not yet finished, whether handed out or not. cancelled 
+// is only set under lock, but the threads computing its tiles read it between rows without it.
+// It's on SERVER's queue of every request until it's answered, and waits in line at its priority's 
+// level (see serverLevel) only while it has tiles left to hand out. With -k, its counts are gathered 
+// in counts and put in the cache under key once it's answered
+struct serverRequest{
+  char id[SERVER_ID_LENGTH];
+  int priority;
+  double xcenter;
+  double ycenter;
+  double scale;
+  int max;
+  int width;
+  int height;
+  struct serverClient * client;
+  struct bitmap * theBitmap;
+  int tilesAcross;
+  int tileCount;
+  int nextTile;
+  int tilesLeft;
+  atomic_bool cancelled;
+  struct timeval received;
+  struct timeval started;
+  struct serverRequest * prev;
+  struct serverRequest * next;
+  struct serverLevel * level;
+  struct serverRequest * waitingPrev;
+  struct serverRequest * waitingNext;
+  char key[CACHE_KEY_LENGTH];
+  struct iterfile * counts;
+};
+
+// the requests of one priority that still have tiles to hand out, oldest first. A level only 
+// exists while it has a request in it, so the first request of the first level is always next
+struct serverLevel{
+  int priority;
+  struct serverRequest * head;
+  struct serverRequest * tail;
+  struct serverLevel * next;
+};
+
+// the queue every request waits in, shared by all of the server's threads under lock. levels 
+// holds the ones with tiles left to hand out, highest priority first, so a thread finds the 
+// next tile without looking through the whole queue
+struct renderServer{
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  // broadcast when a client's connection is closed, for accept() to try again once it's run out of descriptors
+  pthread_cond_t clientGone;
+  struct serverRequest * queue;
+  struct serverLevel * levels;
+  long served;
+  bool shuttingDown;
+  int listenFd;
+};
+struct renderServer SERVER = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, false, -1 };
+
+// enable/disable reusing the previous frame of a -Z series: tiles that fell inside an area of one 
+// iteration count in the previous frame, and whose own border still has that count, are filled 
+// in without computing their inside
+bool SERIES_REUSE = false;
+
+// the raw iteration counts of the last frame computeImageStealing() rendered while SERIES_REUSE was on,
+// with the bounds and settings it was rendered at
+struct iterationFrame{
+  int * iters;
+  int width;
+  int height;
+  double xMin;
+  double xMax;
+  double yMin;
+  double yMax;
+  int max;
+  enum precisionType precision;
+};
+struct iterationFrame PREVIOUS_FRAME = { NULL, 0, 0, 0, 0, 0, 0, 0, PRECISION_AUTO };
+
+// the auto precision picks the first arithmetic whose limit the pixel spacing (relative to the 
+// size of the numbers being iterated) is still above. Double is good to ~1e-16 and double-double 
+// to ~1e-32, and every iteration can add about that much error again, so the limit is the rounding 
+// error of max iterations (the _ERROR_PER_ITERATION times max), but never below the _MIN_ spacing, 
+// which leaves a few digits of headroom for short orbits.
+// Float is never picked automatically: its error grows with max, and even shallow views with the 
+// default max come out different from double on a few boundary pixels, so it's only used with -p float
+#define DOUBLE_MIN_RELATIVE_SPACING 1e-13
+#define DOUBLE_ERROR_PER_ITERATION 2.2e-16
+#define DOUBLEDOUBLE_MIN_RELATIVE_SPACING 1e-27
+#define DOUBLEDOUBLE_ERROR_PER_ITERATION 4.9e-32
+
+// a double-double number: the unevaluated sum hi + lo, with |lo| at most half an ulp of hi,
+// which carries about 32 significant digits
+struct doubleDouble{
+  double hi;
+  double lo;
+};
+
+// the image center for the double-double kernel, which works on offsets from it
+struct doubleDouble DD_CENTER_X = { 0, 0 };
+struct doubleDouble DD_CENTER_Y = { 0, 0 };
+
+// a high-precision fixed-point number for the perturbation reference orbit: limb[0] holds the 
+// integer part and the remaining limbs hold the fraction, 32 bits each, most significant first.
+// Orbit values never get much past the escape radius of 2, so fixed-point is all that's needed.
+// 15 fraction limbs is 480 bits, which is enough for zooms down to a scale of about 1e-140
+#define HP_LIMBS 16
+struct hpNumber{
+  bool negative;
+  uint32_t limb[HP_LIMBS];
+};
+
+// the reference orbit for the perturbation kernel, rounded to doubles. x[0],y[0] is 0 and
+// x[1],y[1] is the image center; the orbit stops early if the center itself escapes
+struct referenceOrbit{
+  double * x;
+  double * y;
+  int length;
+};
+struct referenceOrbit REFERENCE_ORBIT = { NULL, NULL, 0 };
+
+// how many times the perturbation kernel had to rebase a pixel onto the start of the orbit
+atomic_long REBASED_PIXELS = 0;
+
 // this struct holds the arguments that will get passed to the computeBands function
 struct bandCreationParams{
   struct bitmap * theBitmap;
@@ -42,19 +372,376 @@ struct bandCreationParams{
   int bmpTotalHeight;
   int bandHeightBottom;
   int bandHeightTop;
+  // for every row of the image, the row it's a mirror image of, or -1 if it has to be computed. NULL if there are none
+  const int * mirrorOf;
   bool multithreaded;
   int tid; 
+  long busyUsec;
+};
+
+// a rectangle of pixels that one thread computes in one go.
+// the lower bounds are inclusive and the upper bounds are exclusive
+struct tile{
+  int xStart;
+  int xEnd;
+  int yStart;
+  int yEnd;
+  // only used by the mariani scheduler: whether the outermost pixels of the tile are already known
+  bool borderComputed;
+};
+
+// a double-ended queue of tiles owned by one worker thread. The owner pushes and pops
+// at the tail, while other threads steal from the head. Each deque has its own lock,
+// so threads only contend with each other when one of them is stealing.
+struct tileDeque{
+  pthread_mutex_t lock;
+  struct tile * tiles;
+  int capacity;
+  int head;
+  int tail;
+};
+
+// the state shared by all the work-stealing threads
+struct tileScheduler{
+  struct tileDeque * deques;
+  int numDeques;
+  // tiles that have been queued but not finished yet. When this reaches zero the image is done
+  atomic_int pendingTiles;
+  // set when the image is being given up on, so the threads stop without finishing it
+  atomic_bool abandoned;
+  // threads with nothing to take wait on changed until tiles are pushed (which bumps pushes) or the 
+  // image is done. Both are only changed under lock, so a thread can't miss the signal
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  atomic_long pushes;
+};
+
+// this struct holds the arguments that will get passed to the progressiveWorker function
+struct progressivePassParams{
+  struct bitmap * theBitmap;
+  double xMin;
+  double xMax;
+  double yMin;
+  double yMax;
+  int max;
+  int width;
+  int bmpTotalHeight;
+  // the spacing of the pixels computed by this pass, and whether the pixels in between get filled in
+  int step;
+  bool fillBlocks;
+  // the next row (counted in steps) to be handed out to a thread
+  atomic_int * nextRow;
 };
 
-// create and initialize the global mutex that controls access to the
-// main bitmap data structure, which controls the associated memory
+// this struct holds the state shared by the streamWorker threads and the streamWriter thread of a streamed image
+struct streamParams{
+  // the image's bitmap, or with -B the two band buffers that take turns
+  struct bitmap * bands[2];
+  bool wholeImage;
+  double xMin;
+  double xMax;
+  double yMin;
+  double yMax;
+  int max;
+  int width;
+  int bmpTotalHeight;
+  int bandRows;
+  int bandCount;
+  // the next row of the image to be handed out to a thread, and how many rows of each band are done
+  atomic_int nextRow;
+  atomic_int * bandRowsDone;
+  // lock and changed guard bandsWritten and the write error, and are signalled whenever a band is done or written
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  int bandsWritten;
+  bool writeFailed;
+  int writeErrno;
+  long writeUsec;
+  atomic_long waitUsec;
+};
+
+// this struct holds the arguments that will get passed to the resumeWorker function
+struct resumeParams{
+  struct iterfile * theState;
+  // the pixels left to iterate, as indices into the image: the first carriedOn of them carry on 
+  // from start iterations, and the rest start over from the beginning
+  int * points;
+  long carriedOn;
+  long pointCount;
+  int start;
+  double xMin;
+  double xMax;
+  double yMin;
+  double yMax;
+  int max;
+  int width;
+  int bmpTotalHeight;
+  // the next chunk of ROW_CHUNK points to be handed out to a thread
+  atomic_long * nextChunk;
+};
+
+// this struct holds the arguments that will get passed to the antialiasWorker function
+struct antialiasParams{
+  struct bitmap * theBitmap;
+  // the edge pixels to supersample, as indices into the image
+  int * points;
+  long pointCount;
+  double xMin;
+  double xMax;
+  double yMin;
+  double yMax;
+  int max;
+  int width;
+  int bmpTotalHeight;
+  // the next chunk of pixels to be handed out to a thread
+  atomic_long * nextChunk;
+};
+
+// this struct holds the arguments that will get passed to the stealWorker function
+struct tileWorkerParams{
+  struct bitmap * theBitmap;
+  double xMin;
+  double xMax;
+  double yMin;
+  double yMax;
+  int max;
+  int width;
+  int bmpTotalHeight;
+  struct tileScheduler * scheduler;
+  // only used by the mariani scheduler and -r: the iteration count for every pixel of the image
+  int * iterBuffer;
+  // only used by -r: the previous frame of the series, or NULL if there isn't a usable one
+  const struct iterationFrame * previousFrame;
+  // only used by the steal scheduler: the row each row of the image is a mirror image of, or -1 (see findMirrorRows())
+  const int * mirrorOf;
+  bool multithreaded;
+  int tid;
+  long busyUsec;
+  int tilesComputed;
+  int tilesStolen;
+  long pixelsFilled;
+  long pixelsReused;
+};
+
+// every thread writes a disjoint set of pixels straight into its own rows of the bitmap, so 
+// pixel writes normally take no lock at all. The -L parameter brings back the original 
+// write path, which locks this mutex around every bitmap_set(), so the two can be benchmarked
+bool LOCKED_WRITES = false;
 pthread_mutex_t bmpMutex = PTHREAD_MUTEX_INITIALIZER;
 
+// the escape-time kernels all share this signature: given the x,y coordinates of count 
+// pixels, store the number of iterations each one took.
+// A tolerance above zero turns on the periodicity check (see periodic_iterations_at_point()).
+// If magnitudes isn't NULL, it receives |z| for each pixel at the moment it escaped, or 0 if it didn't.
+// If orbitX and orbitY aren't NULL, they receive z for each pixel still inside after max iterations 
+// (NAN if the periodicity check showed it never escapes), and when start is above 0 the pixels 
+// carry on from the z in them, as if they had already been iterated start times
+typedef void (*escapeKernel)( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+
+// the kernel chosen by selectKernel() at startup, the best the CPU supports unless -K forced another,
+// and its single-precision counterpart, which renderFrame() swaps in for PRECISION_FLOAT
+escapeKernel ESCAPE_KERNEL = NULL;
+const char * ESCAPE_KERNEL_NAME = "scalar";
+escapeKernel FLOAT_KERNEL = NULL;
+const char * FLOAT_KERNEL_NAME = "scalar float";
+
+// the CPU features the escape-time kernels can need
+enum cpuFeature { FEATURE_NONE, FEATURE_SSE2, FEATURE_AVX2, FEATURE_AVX512F };
+
+// an escape-time kernel compiled into this binary, its single-precision version, and the CPU feature they need to run
+struct kernelEntry{
+  const char * name;
+  escapeKernel kernel;
+  const char * floatName;
+  escapeKernel floatKernel;
+  enum cpuFeature feature;
+};
+
+// the kernel to use no matter what the CPU supports best, selected with the -K parameter, or NULL for the best one
+const char * KERNEL_OVERRIDE = NULL;
+
+// how many pixels of a row are handed to the escape-time kernel at once
+#define ROW_CHUNK 64
+
+// enable/disable the analytic check that colors points inside the main cardioid and the 
+// period-2 bulb without iterating them, and count how many pixels it short-circuited
+bool INTERIOR_CHECK = false;
+atomic_long SHORT_CIRCUITED_PIXELS = 0;
+
+// enable/disable the periodicity check that stops iterating a point once its orbit has settled
+// into a cycle. Two orbit points count as the same if they're within this fraction of a pixel.
+// Looser tolerances stop a little sooner but start misjudging slowly-escaping points near the edge
+bool PERIODICITY_CHECK = false;
+#define PERIOD_TOLERANCE_FACTOR 1e-5
+
+// with -M every band, tile and thread records how many iterations it spent and how long it took,
+// and WORK_LOG is saved to WORK_LOG_FILE as CSV with a summary of how evenly the work was spread.
+// THREAD_ITERATIONS is the running total of iterations spent by the current thread
+const char * WORK_LOG_FILE = NULL;
+static __thread long long THREAD_ITERATIONS = 0;
+enum workKind { WORK_THREAD, WORK_BAND, WORK_TILE };
+const char * WORK_KIND_NAMES[] = { "thread", "band", "tile" };
+struct workRecord{
+  enum workKind kind;
+  int thread;
+  int xStart;
+  int yStart;
+  int xEnd;
+  int yEnd;
+  long long iterations;
+  long wallUsec;
+  long cpuUsec;
+};
+struct workLog{
+  pthread_mutex_t lock;
+  struct workRecord * records;
+  int count;
+  int capacity;
+};
+struct workLog WORK_LOG = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0 };
+
+// with -G the number of iterations every pixel cost is kept in COST_MAP, width x height,
+// and saved to COST_MAP_FILE as a heatmap of where the time went
+const char * COST_MAP_FILE = NULL;
+int * COST_MAP = NULL;
+
+// this struct holds a copy of every setting above that changes how an image gets computed, or what's gathered
+// while it is, so they can all be set aside, switched to the plain exhaustive way of computing an image, and 
+// put back in one go (see saveRenderOptions(), resetRenderOptions() and restoreRenderOptions())
+struct renderOptions{
+  enum schedulerType scheduler;
+  bool tiledBands;
+  bool progressive;
+  bool seriesReuse;
+  bool mirrorSymmetry;
+  int aaSamples;
+  bool interiorCheck;
+  bool periodicityCheck;
+  escapeKernel kernel;
+  const char * kernelName;
+  escapeKernel floatKernel;
+  const char * floatKernelName;
+  struct iterfile * rawOutput;
+  const char * workLogFile;
+  int * costMap;
+  bool timing;
+};
+
 // function declarations
 static int iteration_to_color( int i, int max );
 static int iterations_at_point( double x, double y, int max );
+static int periodic_iterations_at_point( double x, double y, int max, double tolerance );
+static int orbit_iterations_at_point( double x0, double y0, double * x, double * y, int iter, int max, double tolerance );
+static void computeRow( struct bitmap * bm, int j, int iStart, int iEnd, double xmin, double xmax, int width, double y, int max, struct iterfile * counts, bool lockWrites );
+static void computeRowIters( int * iters, float * magnitudes, double * orbitX, double * orbitY, int * costs, int iStart, int iEnd, double xmin, double xmax, int width, double y, int max );
+static double periodTolerance( double xmin, double xmax, int width );
+static void computePointIters( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY, int * costs );
+static float escape_magnitude_at_point( double x, double y, int iters );
+static bool inCardioidOrBulb( double x, double y );
+static bool selectKernel( const char * name );
+static bool cpuSupports( enum cpuFeature feature );
+static void escapeTimeScalar( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+#if defined(__x86_64__) || defined(__i386__)
+static void escapeTimeSSE2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static void escapeTimeAVX2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static void escapeTimeAVX512( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static void escapeTimeFloatSSE2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static void escapeTimeFloatAVX2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static void escapeTimeFloatAVX512( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+#endif
+static void escapeTimeFloatScalar( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static int float_iterations_at_point( float x, float y, int max, float tolerance, float * magnitude );
 bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int numThreads );
 void * computeBands( void * );
+static bool computeBandTiles( struct bandCreationParams * params );
+static void computeBandTile( struct bandCreationParams * params, struct tile * theTile, double * xs, double * ys, int * colors );
+static void mortonDecode( unsigned int code, int * x, int * y );
+bool computeImageStealing( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse );
+void * stealWorker( void * );
+static void computeTile( struct tileWorkerParams * params, struct tile * theTile );
+static int * findMirrorRows( double ymin, double ymax, int totalHeight, int * mirrored );
+static void mirrorRows( struct bitmap * bm, const int * mirrorOf, int width, int totalHeight );
+static bool isEdgePixel( const int * data, int i, int j, int width, int totalHeight );
+static bool antialiasEdges( struct bitmap * bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse );
+void * antialiasWorker( void * );
+static void computeRectangle( struct tileWorkerParams * params, struct tile * rect );
+static void computeIterSpan( struct tileWorkerParams * params, int j, int iStart, int iEnd );
+static void computeIterColumn( struct tileWorkerParams * params, int i, int jStart, int jEnd );
+static void computeReusedTile( struct tileWorkerParams * params, struct tile * theTile );
+static bool previousFrameUniform( struct tileWorkerParams * params, struct tile * theTile, int * iters );
+bool computeImageProgressive( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse );
+void * progressiveWorker( void * );
+static bool savePreview( struct bitmap * bm, const char * file );
+static struct iterfile * loadResumeState( const char * file, int width, int height, double xmin, double xmax, double ymin, double ymax, int max );
+static bool computeImageResumed( struct bitmap *bm, struct iterfile * state, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse );
+void * resumeWorker( void * );
+static bool computeImageStreamed( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse );
+void * streamWorker( void * );
+void * streamWriter( void * );
+static bool renderFrame( struct bitmap * bm, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, double scale, int max, int numThreads );
+static bool renderCached( struct bitmap * bm, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, 
+  double scale, int max, int numThreads, bool * hit );
+static struct iterfile * lookupCachedImage( const char * key, int width, int height, int max );
+static void storeCachedImage( const char * key, struct iterfile * counts );
+static void colorCachedImage( struct bitmap * bm, struct iterfile * counts, int max );
+static void closeCache( const char * outcome );
+static void cacheKey( char * key, enum precisionType precision, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, 
+  double scale, int width, int height, int max );
+static uint64_t hashText( uint64_t hash, const char * text );
+static bool renderSeries( const char * outfile, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, double finalScale, 
+  int width, int height, int max, int numThreads, long * mismatches );
+static void seriesFrameName( char * buffer, size_t size, const char * outfile, int frame );
+void * saveFrame( void * );
+static struct batchJob * loadManifest( const char * file, int * jobCount );
+static void freeManifest( struct batchJob * jobs, int jobCount );
+static bool renderBatch( const char * manifestFile, int numThreads );
+void * batchWorker( void * );
+static bool colorCachedView( struct batchJob * job );
+static bool serveRequests( const char * socketPath, int numThreads );
+void * serverReader( void * );
+void * serverWorker( void * );
+static void cancelRequest( struct serverRequest * request );
+static void finishCancelledRequests( void );
+static void unqueueRequest( struct serverRequest * request );
+static bool scheduleRequest( struct serverRequest * request );
+static void unscheduleRequest( struct serverRequest * request );
+static int countWords( const char * line );
+static void finishRequest( struct serverRequest * request );
+static void sendReply( struct serverClient * client, const char * format, ... );
+static void releaseClient( struct serverClient * client );
+static bool startWorkerPool( int size );
+static void stopWorkerPool( void );
+void * poolThread( void * );
+static int spawnWorker( int slot, pthread_t * thread, void * (*job)( void * ), void * jobArgs );
+static int joinWorker( int slot, pthread_t thread );
+static long verifyImage( struct bitmap * bm, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, double scale, int max, int threadsToUse );
+static void saveRenderOptions( struct renderOptions * options );
+static void resetRenderOptions( void );
+static void restoreRenderOptions( const struct renderOptions * options );
+static bool computeReferenceOrbit( const char * xText, const char * yText, int max );
+static enum precisionType selectPrecision( double xcenter, double ycenter, double scale, int width, int height, int max );
+static void hpFromCoordinate( const char * text, struct hpNumber * result );
+static void setDoubleDoubleCenter( const char * xText, const char * yText );
+static void escapeTimeDoubleDouble( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static void escapeTimePerturbation( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY );
+static bool hpFromString( const char * text, struct hpNumber * result );
+static void hpFromDouble( double value, struct hpNumber * result );
+static double hpToDouble( const struct hpNumber * a );
+static void hpAdd( const struct hpNumber * a, const struct hpNumber * b, struct hpNumber * result );
+static void hpSub( const struct hpNumber * a, const struct hpNumber * b, struct hpNumber * result );
+static void hpMul( const struct hpNumber * a, const struct hpNumber * b, struct hpNumber * result );
+static bool pushTile( struct tileDeque * deque, struct tile * theTile );
+static bool popTile( struct tileDeque * deque, struct tile * theTile );
+static bool stealTile( struct tileScheduler * scheduler, int thiefId, struct tile * theTile );
+static void announceTiles( struct tileScheduler * scheduler, bool pushed );
+static void waitForTiles( struct tileScheduler * scheduler, long pushesSeen );
+static void freeTileScheduler( struct tileScheduler * scheduler );
+static long elapsedUsec( struct timeval * start, struct timeval * end );
+static long threadCpuUsec( void );
+static void logWork( enum workKind kind, int thread, int xStart, int yStart, int xEnd, int yEnd, long long iterations, long wallUsec, long cpuUsec );
+static bool saveWorkLog( const char * file );
+static void printWorkSummary( void );
+static bool saveCostMap( const char * file, int width, int height );
 
 void show_help()
 {
@@ -67,12 +754,60 @@ void show_help()
   printf("-W <pixels>  Width of the image in pixels. (default=500)\n");
   printf("-H <pixels>  Height of the image in pixels. (default=500)\n");
   printf("-n <threads> Number of threads to use to create the image. (default=1)\n");
+  printf("-S <sched>   How to split the image amongst threads: band, steal or mariani. (default=band)\n");
+  printf("-T <pixels>  Tile size used by the steal and mariani schedulers and -z. (default=32)\n");
+  printf("-z           Walk each band in tiles, in Z-order, instead of row by row (experimental).\n");
+  printf("-c           Skip iterating points inside the main cardioid and period-2 bulb.\n");
+  printf("-P           Stop iterating points whose orbit has settled into a cycle.\n");
+  printf("-p <prec>    Arithmetic to iterate with: auto, float, double, dd or perturb. (default=auto)\n");
+  printf("-K <kernel>  Force an escape-time kernel: avx512, avx2, sse2 or scalar. (default=the best the CPU runs)\n");
+  printf("-R           Render progressively, coarse pixels first. Overrides -S.\n");
+  printf("-w           Also save a preview to the output file after each progressive pass.\n");
+  printf("-Z <frames>  Render a zoom series of this many frames, from a scale of 2 down to -s, to the\n");
+  printf("             output file name with the frame number added (mandel1.bmp, mandel2.bmp, ...).\n");
+  printf("-F <file>    Render every view listed in this manifest, one per line as: x y scale max width height outfile.\n");
+  printf("             The views share the threads, and their tiles are interleaved. -x, -y, -s, -m, -W, -H and -o are ignored.\n");
+  printf("-D <socket>  Run as a render server on this Unix domain socket until a client sends SHUTDOWN.\n");
+  printf("             Requests are lines of RENDER <id> <priority> <x> <y> <scale> <max> <width> <height>\n");
+  printf("             or CANCEL <id>, and are answered with OK <id> <bytes> and the BMP, CANCELLED <id>\n");
+  printf("             or ERR <id> <reason>. Views of more than 2^26 pixels or a max over 1000000 are refused.\n");
+  printf("             See mandelclient.\n");
+  printf("-r           Reuse uniform areas of the previous frame of a -Z series (uses tiles, like -S steal).\n");
+  printf("-I <file>    Also save the raw iteration counts, for recoloring with colorize or carrying on with -C.\n");
+  printf("-C <file>    Carry on from a file saved with -I for the same image at a lower -m, only\n");
+  printf("             iterating the pixels that hadn't escaped yet.\n");
+  printf("-B <rows>    Stream the image into the output file this many rows at a time, for images\n");
+  printf("             too big to hold in memory. Uses the band scheduler.\n");
+  printf("-O           Write the image out while it's still being computed. Uses the band scheduler.\n");
+  printf("-M <file>    Log the iterations and time every thread, band and tile took to this CSV file, and\n");
+  printf("             print how evenly the work was spread over the threads.\n");
+  printf("-G <file>    Also save a heatmap of how many iterations every pixel cost.\n");
+  printf("-A <n>       Anti-alias the edges: pixels that stand out from a neighbour are rendered again\n");
+  printf("             from n x n points (2-%d) and set to their average color.\n", AA_MAX_SAMPLES);
+  printf("-k <dir>     Keep the iteration counts of images in this directory, and color an image that's\n");
+  printf("             already there from them instead of computing it again. Works for every view of\n");
+  printf("             -F and every request to -D as well. Prints the hits and misses.\n");
+  printf("-q <MB>      Evict the least recently used images from the -k directory past this size. (default=256)\n");
+  printf("-Y           Compute both halves of a view that straddles the real axis, instead of mirroring rows.\n");
+  printf("-V           Verify the image against an exhaustive render, pixel by pixel.\n");
+  printf("-L           Lock the bitmap around every pixel write (the old write path, for benchmarking).\n");
   printf("-o <file>    Set output file. (default=mandel.bmp)\n");
   printf("-h           Show this help text.\n");
   printf("\nSome examples are:\n");
   printf("mandel -x -0.5 -y -0.5 -s 0.2\n");
   printf("mandel -x -.38 -y -.665 -s .05 -m 100 -n 3\n");
-  printf("mandel -x 0.286932 -y 0.014287 -s .0005 -m 1000\n\n");
+  printf("mandel -x -.163013 -y -1.03265 -s .000025 -m 7000 -n 32 -S steal -t\n");
+  printf("mandel -x -0.5 -s 1.5 -m 5000 -n 4 -S mariani -V\n");
+  printf("mandel -x -.163013 -y -1.03265 -s .000025 -m 7000 -n 8 -A 4\n");
+  printf("mandel -x -.163013 -y -1.03265 -s .000025 -m 7000 -n 8 -S steal -M work.csv -G cost.bmp\n");
+  printf("mandel -x 0.286932 -y 0.014287 -s .0005 -m 1000 -n 4 -R -w\n");
+  printf("mandel -x -.163013 -y -1.03265 -s .000025 -m 7000 -W 600 -H 600 -n 8 -Z 50\n");
+  printf("mandel -F views.txt -n 8 -t\n");
+  printf("mandel -x -.163013 -y -1.03265 -s .000025 -m 7000 -n 8 -k mandel-cache -q 1024 -t\n");
+  printf("mandel -D /tmp/mandel.sock -n 8 -c -P\n");
+  printf("mandel -x -.163013 -y -1.03265 -s .000025 -m 20000 -n 8 -C mandel.iter -I mandel.iter\n");
+  printf("mandel -x -1.7497219803063 -y 0.0000000000000003 -s 1e-12 -m 5000 -p perturb\n");
+  printf("mandel -x -0.5 -s 1.5 -W 60000 -H 60000 -m 1000 -n 8 -B 256 -o poster.bmp\n\n");
 }
 
 int main( int argc, char *argv[] )
@@ -87,22 +822,30 @@ int main( int argc, char *argv[] )
   const char *outfile = "mandel.bmp";
   double xcenter = 0;
   double ycenter = 0;
+  // the center coordinates exactly as typed, so the perturbation 
+  // reference orbit can use every digit instead of just a double's worth
+  const char * xcenterText = "0";
+  const char * ycenterText = "0";
   double scale = 4;
   int image_width = 500;
   int image_height = 500;
   int max = 1000;
   int numThreads = 1;
+  const char * rawFile = NULL;
+  const char * resumeFile = NULL;
 
   // For each command line argument given,
   // override the appropriate configuration value.
   char c;
-  while((c = getopt(argc,argv,"x:y:s:W:H:m:o:n:hdt"))!=-1) {
+  while((c = getopt(argc,argv,"x:y:s:W:H:m:o:n:S:T:p:K:Z:F:D:I:C:B:M:G:A:k:q:OrLcPVRYzwhdt"))!=-1) {
     switch(c) {
       case 'x':
         xcenter = atof(optarg);
+        xcenterText = optarg;
         break;
       case 'y':
         ycenter = atof(optarg);
+        ycenterText = optarg;
         break;
       case 's':
         scale = atof(optarg);
@@ -122,6 +865,138 @@ int main( int argc, char *argv[] )
       case 'n':
         numThreads = atoi(optarg);
         break;
+      case 'S':
+        if( strcmp( optarg, "band" ) == 0 )
+        {
+          SCHEDULER = SCHED_BAND;
+        }
+        else if( strcmp( optarg, "steal" ) == 0 )
+        {
+          SCHEDULER = SCHED_STEAL;
+        }
+        else if( strcmp( optarg, "mariani" ) == 0 )
+        {
+          SCHEDULER = SCHED_MARIANI;
+        }
+        else
+        {
+          printf("Invalid value for parameter -S, please try again. Please use mandel -h to see the help output.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'T':
+        TILE_SIZE = atoi(optarg);
+        break;
+      case 'z':
+        TILED_BANDS = true;
+        break;
+      case 'c':
+        INTERIOR_CHECK = true;
+        break;
+      case 'P':
+        PERIODICITY_CHECK = true;
+        break;
+      case 'p':
+        if( strcmp( optarg, "auto" ) == 0 )
+        {
+          PRECISION = PRECISION_AUTO;
+        }
+        else if( strcmp( optarg, "float" ) == 0 )
+        {
+          PRECISION = PRECISION_FLOAT;
+        }
+        else if( strcmp( optarg, "double" ) == 0 )
+        {
+          PRECISION = PRECISION_DOUBLE;
+        }
+        else if( strcmp( optarg, "dd" ) == 0 )
+        {
+          PRECISION = PRECISION_DOUBLEDOUBLE;
+        }
+        else if( strcmp( optarg, "perturb" ) == 0 )
+        {
+          PRECISION = PRECISION_PERTURB;
+        }
+        else
+        {
+          printf("Invalid value for parameter -p, please try again. Please use mandel -h to see the help output.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'K':
+        KERNEL_OVERRIDE = optarg;
+        break;
+      case 'F':
+        BATCH_FILE = optarg;
+        break;
+      case 'D':
+        SERVER_SOCKET = optarg;
+        break;
+      case 'Z':
+        SERIES_FRAMES = atoi(optarg);
+        if( SERIES_FRAMES < 1 )
+        {
+          printf("Invalid value for parameter -Z, please try again. Please use mandel -h to see the help output.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'I':
+        rawFile = optarg;
+        break;
+      case 'C':
+        resumeFile = optarg;
+        break;
+      case 'B':
+        STREAM_ROWS = atoi(optarg);
+        if( STREAM_ROWS < 1 )
+        {
+          printf("Invalid value for parameter -B, please try again. Please use mandel -h to see the help output.\n");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'O':
+        STREAM_OVERLAP = true;
+        break;
+      case 'M':
+        WORK_LOG_FILE = optarg;
+        break;
+      case 'G':
+        COST_MAP_FILE = optarg;
+        break;
+      case 'r':
+        SERIES_REUSE = true;
+        break;
+      case 'V':
+        VERIFY = true;
+        break;
+      case 'A':
+        AA_SAMPLES = atoi(optarg);
+        break;
+      case 'Y':
+        MIRROR_SYMMETRY = false;
+        break;
+      case 'k':
+        CACHE_DIR = optarg;
+        break;
+      case 'q':
+        // strtoll() saturates instead of overflowing, so anything too big to shift into bytes is caught
+        CACHE_LIMIT = strtoll( optarg, NULL, 10 );
+        if( CACHE_LIMIT < 1 || CACHE_LIMIT > LLONG_MAX >> 20 )
+        {
+          printf("Invalid value for parameter -q, please try again. Please use mandel -h to see the help output.\n");
+          exit(EXIT_FAILURE);
+        }
+        CACHE_LIMIT <<= 20;
+        break;
+      case 'R':
+        PROGRESSIVE = true;
+        break;
+      case 'w':
+        PREVIEW_FILE = "";
+        break;
+      case 'L':
+        LOCKED_WRITES = true;
+        break;
       case 'd':
         DBG = true;
         break;
@@ -141,131 +1016,539 @@ int main( int argc, char *argv[] )
     exit(EXIT_FAILURE);
   }
 
-  // Display the configuration of the image.
-  printf("mandel: x=%lf y=%lf scale=%lf max=%d height=%d width=%d numThreads=%d outfile=%s\n",xcenter,ycenter,scale,max,image_height,image_width,numThreads,outfile);
+  if( AA_SAMPLES != 0 && ( AA_SAMPLES < 2 || AA_SAMPLES > AA_MAX_SAMPLES ) )
+  {
+    printf("Invalid value for parameter -A, please try again. Please use mandel -h to see the help output.\n");
+    exit(EXIT_FAILURE);
+  }
 
-  // Create a bitmap of the appropriate size.
-  struct bitmap *bm = bitmap_create(image_width,image_height);
+  if( TILE_SIZE < 1 )
+  {
+    printf("Invalid value for parameter -T, please try again. Please use mandel -h to see the help output.\n");
+    exit(EXIT_FAILURE);
+  }
 
-  // Fill it with green, for debugging
-  bitmap_reset(bm,MAKE_RGBA(0,255,0,0));
+  // the server renders every request the same plain way, a tile at a time, and a batch doesn't apply to it
+  if( SERVER_SOCKET != NULL && ( BATCH_FILE != NULL || PRECISION == PRECISION_DOUBLEDOUBLE || PRECISION == PRECISION_PERTURB ) )
+  {
+    printf("mandel: -F, -p dd and -p perturb don't apply to -D, ignoring them\n");
+    BATCH_FILE = NULL;
+    if( PRECISION == PRECISION_DOUBLEDOUBLE || PRECISION == PRECISION_PERTURB )
+    {
+      PRECISION = PRECISION_AUTO;
+    }
+  }
 
-  // if this is being timed, get the time value before computation and store it
-  if(TIMING)
+  // a batch renders whole images straight into their own files, with the tiles of all of them mixed together.
+  // So does the server, for the images it's asked for
+  if( ( BATCH_FILE != NULL || SERVER_SOCKET != NULL ) && ( SERIES_FRAMES > 0 || PROGRESSIVE || SCHEDULER != SCHED_BAND || SERIES_REUSE || rawFile != NULL || resumeFile != NULL || 
+    STREAM_ROWS > 0 || STREAM_OVERLAP || WORK_LOG_FILE != NULL || COST_MAP_FILE != NULL || AA_SAMPLES > 0 || TILED_BANDS || VERIFY ) )
   {
-    gettimeofday( &computeStart, NULL );
+    printf("mandel: -Z, -R, -S, -r, -I, -C, -B, -O, -M, -G, -A, -z and -V don't apply to -F or -D, ignoring them\n");
+    SERIES_FRAMES = 0;
+    PROGRESSIVE = false;
+    PREVIEW_FILE = NULL;
+    SCHEDULER = SCHED_BAND;
+    SERIES_REUSE = false;
+    rawFile = NULL;
+    resumeFile = NULL;
+    STREAM_ROWS = 0;
+    STREAM_OVERLAP = false;
+    WORK_LOG_FILE = NULL;
+    COST_MAP_FILE = NULL;
+    AA_SAMPLES = 0;
+    TILED_BANDS = false;
+    VERIFY = false;
   }
 
-  // Compute the Mandelbrot image - this is where all the action happens
-  // it returns a bool depending on whether or not it was successful
-  bool imageComputed = false;
-  imageComputed = computeImage(bm,xcenter-scale,xcenter+scale,ycenter-scale,ycenter+scale,max,numThreads);
+  // there's only a previous frame to reuse in a series, and progressive rendering doesn't keep its counts
+  if( SERIES_REUSE && ( SERIES_FRAMES == 0 || PROGRESSIVE ) )
+  {
+    printf("mandel: -r only applies to a -Z series without -R, ignoring it\n");
+    SERIES_REUSE = false;
+  }
 
-  if( !imageComputed )
+  if( rawFile != NULL && SERIES_FRAMES > 0 )
   {
-    printf("There was a problem. Please try again.\n");
-    if(DBG)
-    {
-      printf("ERROR -> main(): computeImage() returned false, no image created...\n");
-    }
-    exit(EXIT_FAILURE);
+    printf("mandel: -I only applies to a single image, ignoring it\n");
+    rawFile = NULL;
   }
 
-  // if this is being timed, get the time value after computation and store it
-  if(TIMING)
+  if( resumeFile != NULL && SERIES_FRAMES > 0 )
   {
-    gettimeofday( &computeEnd, NULL );
+    printf("mandel: -C only applies to a single image, ignoring it\n");
+    resumeFile = NULL;
   }
 
-  // Save the image in the stated file.
-  if(!bitmap_save(bm,outfile)) {
-    fprintf(stderr,"mandel: couldn't write to %s: %s\n",outfile,strerror(errno));
-    exit(EXIT_FAILURE);
+  if( ( STREAM_ROWS > 0 || STREAM_OVERLAP ) && SERIES_FRAMES > 0 )
+  {
+    printf("mandel: -B and -O only apply to a single image, ignoring them\n");
+    STREAM_ROWS = 0;
+    STREAM_OVERLAP = false;
   }
 
-  // if this is being timed, calculate & output the time taken in microseconds to run the computation
-  if(TIMING)
+  // -O writes the image a band of rows at a time, which only the band scheduler finishes in order
+  if( STREAM_OVERLAP && STREAM_ROWS == 0 && ( PROGRESSIVE || SCHEDULER != SCHED_BAND || resumeFile != NULL ) )
   {
-    int computationTime = ( ( computeEnd.tv_sec - computeStart.tv_sec ) * 1000000 + ( computeEnd.tv_usec - computeStart.tv_usec ) );
-    printf( "mandel: Computed time taken (in usec): %d\n", computationTime );
+    printf("mandel: -O only applies to the band scheduler, ignoring it\n");
+    STREAM_OVERLAP = false;
   }
 
-  if(DBG)
+  // a streamed image is never all in memory at once, so nothing that needs the whole of it applies
+  if( STREAM_ROWS > 0 && ( PROGRESSIVE || SCHEDULER != SCHED_BAND || VERIFY || rawFile != NULL || resumeFile != NULL ) )
   {
-    printf("DEBUG: main() exiting...\n");
+    printf("mandel: -R, -S, -V, -I and -C don't apply to a streamed image, ignoring them\n");
+    PROGRESSIVE = false;
+    PREVIEW_FILE = NULL;
+    SCHEDULER = SCHED_BAND;
+    VERIFY = false;
+    rawFile = NULL;
+    resumeFile = NULL;
   }
-  exit(EXIT_SUCCESS);
-} // main()
 
-/*
- * function: 
- *  computeImage
- * 
- * description: 
- *  Called by main() to start the process of creating the pixels and setting the memory for the bmp output.
- *  It checks if the user requested single- or multi-threading, and instantiates the apropriate number of 
- *    bandCreationParams structs to hold the information needed so computeBands can generate the actual image pixels.
- *  This is the function that creates threads, if needed, and wait for those threads to complete before returning 
- *    to main().
- * 
- * parameters:
- *  struct bitmap *bm: the pointer to the space allocated for the bitmap
- *  double xmin: the scaled left-bound of the requested image on the x-axis
- *  double xmax: the scaled right-bound of the requested image on the x-axis
- *  double ymin: the scaled lower-bound of the requested image on the y-axis
- *  double ymax: the scaled upper-bound of the requested image on the y-axis
- *  int max: max # of recurrence relations to iterate
- *  int threadsToUse: the number of threads to perform the computation
- * 
- * returns: 
- *  bool: true if there were no catastrophic errors during computation, otherwise false
- */
-bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
-{
-  if(DBG)
+  if( ( WORK_LOG_FILE != NULL || COST_MAP_FILE != NULL ) && SERIES_FRAMES > 0 )
   {
-    printf("DEBUG: computeImage() starting...\n");
+    printf("mandel: -M and -G only apply to a single image, ignoring them\n");
+    WORK_LOG_FILE = NULL;
+    COST_MAP_FILE = NULL;
   }
-  
-  // grab the width and height of the image
-  int width = bitmap_width(bm);
-  int totalHeight = bitmap_height(bm);
 
-  // declare a pointer var to hold all thread IDs just in case multithreading is used (memory will get allocated later)
-  pthread_t * threadsArr;
+  // the work log is kept by the threads of the band, steal and mariani schedulers as they finish their bands and tiles
+  if( WORK_LOG_FILE != NULL && ( PROGRESSIVE || resumeFile != NULL || STREAM_ROWS > 0 || STREAM_OVERLAP ) )
+  {
+    printf("mandel: -M only applies to the band, steal and mariani schedulers without -R, -C, -B or -O, ignoring it\n");
+    WORK_LOG_FILE = NULL;
+  }
 
-  // singlethreading and multithreading are drastically different scenarios, 
-  // so this conditional determines what logic gets executed
-  if( threadsToUse > 1 )
+  if( COST_MAP_FILE != NULL && STREAM_ROWS > 0 )
   {
-    // multithreaded
+    printf("mandel: -G doesn't apply to a streamed image, ignoring it\n");
+    COST_MAP_FILE = NULL;
+  }
 
-    if(DBG)
-    {
-      printf("DEBUG: computeImage(): using multithreading with %d threads..\n", threadsToUse);
-    }
+  // the edges are found by comparing every pixel with its neighbours, so the whole image has to be there
+  if( AA_SAMPLES > 0 && ( PROGRESSIVE || resumeFile != NULL || STREAM_ROWS > 0 || STREAM_OVERLAP ) )
+  {
+    printf("mandel: -A only applies to the band, steal and mariani schedulers without -R, -C, -B or -O, ignoring it\n");
+    AA_SAMPLES = 0;
+  }
 
-    // instantiate and allocate memory for the array that will hold all  
-    // struct pointers for computeBands() parameters
-    struct bandCreationParams * multithreadedArgsArr;
-    multithreadedArgsArr = (struct bandCreationParams *) calloc( threadsToUse, sizeof(struct bandCreationParams) );
+  // the reference -V renders has no business anti-aliasing itself, and without that every edge pixel would differ
+  if( VERIFY && AA_SAMPLES > 0 )
+  {
+    printf("mandel: -V can't check an anti-aliased image, ignoring it\n");
+    VERIFY = false;
+  }
 
-    // check to ensure calloc() was successful by checking for null pointer return
-    // return to main if it failed
-    if(multithreadedArgsArr == NULL)
-    {
-      if(DBG)
-      {
-        printf("ERROR -> computeImage(): calloc() for multithreadedArgsArr returned NULL\n");
-      }
-      return false;
-    }
+  // -z hasn't shown a gain over rows yet, so it's kept to single images where it can be measured on its own
+  if( TILED_BANDS && ( SERIES_FRAMES > 0 || PROGRESSIVE || SCHEDULER != SCHED_BAND || SERIES_REUSE || resumeFile != NULL || STREAM_ROWS > 0 || STREAM_OVERLAP ) )
+  {
+    printf("mandel: -z only applies to a single image with the band scheduler, without -R, -r, -C, -B or -O, ignoring it\n");
+    TILED_BANDS = false;
+  }
 
-    // since the number of threads may not cleanly divide the number of 
-    // height pixels, store the modulus of them.
-    int modRemainder = totalHeight % threadsToUse;
+  // the cache holds the counts of whole images, which are only ever colored the plain way, and there's no work to log or map on a hit
+  if( CACHE_DIR != NULL && ( SERIES_FRAMES > 0 || rawFile != NULL || resumeFile != NULL || STREAM_ROWS > 0 || STREAM_OVERLAP || 
+    WORK_LOG_FILE != NULL || COST_MAP_FILE != NULL || AA_SAMPLES > 0 ) )
+  {
+    printf("mandel: -k only applies to a single image, a -F batch or a -D server, without -I, -C, -B, -O, -M, -G or -A, ignoring it\n");
+    CACHE_DIR = NULL;
+  }
 
-    // subtract the modulus remainder fromn the overall bmp height 
+  // previews go to the output file, which can only be set once all the options have been read
+  if( PREVIEW_FILE != NULL )
+  {
+    PREVIEW_FILE = outfile;
+  }
+
+  // pick the fastest escape-time kernel this CPU can run, unless one was forced with -K
+  if( !selectKernel( KERNEL_OVERRIDE ) )
+  {
+    printf("Invalid value for parameter -K, %s isn't a kernel this build and CPU can run. Please use mandel -h to see the help output.\n", KERNEL_OVERRIDE);
+    exit(EXIT_FAILURE);
+  }
+
+  // the cache is opened up front, so the server and a batch look up every image they render in it too
+  if( CACHE_DIR != NULL )
+  {
+    CACHE = imagecache_open( CACHE_DIR, CACHE_LIMIT );
+    if( CACHE == NULL )
+    {
+      fprintf(stderr,"mandel: couldn't use %s as a cache: %s\n",CACHE_DIR,strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // the server runs until it's told to shut down
+  if( SERVER_SOCKET != NULL )
+  {
+    if( !serveRequests( SERVER_SOCKET, numThreads ) )
+    {
+      printf("There was a problem. Please try again.\n");
+      exit(EXIT_FAILURE);
+    }
+    closeCache( NULL );
+    exit(EXIT_SUCCESS);
+  }
+
+  // a batch works out the arithmetic for each of its views, and renders them all in this one process
+  if( BATCH_FILE != NULL )
+  {
+    bool batchRendered = renderBatch( BATCH_FILE, numThreads );
+    closeCache( NULL );
+    if( !batchRendered )
+    {
+      printf("There was a problem. Please try again.\n");
+      exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+  }
+
+  // a series works out the arithmetic again for every frame, since the scale changes as it zooms in
+  enum precisionType requestedPrecision = PRECISION;
+
+  // work out which arithmetic this image needs, unless the user picked one
+  if( PRECISION == PRECISION_AUTO )
+  {
+    PRECISION = selectPrecision( xcenter, ycenter, scale, image_width, image_height, max );
+  }
+  else if(DBG)
+  {
+    if( PRECISION == PRECISION_FLOAT )
+    {
+      printf( "DEBUG: main(): using float precision because -p float was given; auto never picks it, since it drifts from double as max grows\n" );
+    }
+    else
+    {
+      printf( "DEBUG: main(): using %s precision because -p %s was given\n", PRECISION_NAMES[PRECISION], PRECISION_NAMES[PRECISION] );
+    }
+  }
+
+  // the double-double and perturbation kernels work on offsets from the image center rather than absolute 
+  // coordinates, which the cardioid and periodicity checks don't understand, so those are switched off for them
+  if( SERIES_FRAMES == 0 && PRECISION != PRECISION_DOUBLE && PRECISION != PRECISION_FLOAT && ( INTERIOR_CHECK || PERIODICITY_CHECK ) )
+  {
+    printf("mandel: the -c and -P checks don't apply to -p %s, ignoring them\n", PRECISION_NAMES[PRECISION]);
+    INTERIOR_CHECK = false;
+    PERIODICITY_CHECK = false;
+  }
+
+  // Display the configuration of the image.
+  printf("mandel: x=%lf y=%lf scale=%lf max=%d height=%d width=%d numThreads=%d outfile=%s\n",xcenter,ycenter,scale,max,image_height,image_width,numThreads,outfile);
+
+  // a zoom series renders all of its frames in this one process, then it's done
+  if( SERIES_FRAMES > 0 )
+  {
+    PRECISION = requestedPrecision;
+    long seriesMismatches = 0;
+    if( !renderSeries( outfile, xcenter, ycenter, xcenterText, ycenterText, scale, image_width, image_height, max, numThreads, &seriesMismatches ) )
+    {
+      printf("There was a problem. Please try again.\n");
+      exit(EXIT_FAILURE);
+    }
+    if( seriesMismatches > 0 )
+    {
+      exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+  }
+
+  // when the image is written while it's computed, open the file the bands go into first
+  if( STREAM_ROWS > 0 || STREAM_OVERLAP )
+  {
+    STREAM_HEIGHT = image_height;
+    STREAM_FILE = bitmap_stream_open(outfile,image_width,image_height);
+    if( STREAM_FILE == NULL )
+    {
+      fprintf(stderr,"mandel: couldn't write to %s: %s\n",outfile,strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // Create a bitmap of the appropriate size, or when streaming, just big enough for one band of rows
+  struct bitmap *bm;
+  if( STREAM_ROWS > 0 )
+  {
+    bm = bitmap_create(image_width,STREAM_ROWS < image_height ? STREAM_ROWS : image_height);
+  }
+  else
+  {
+    bm = bitmap_create(image_width,image_height);
+  }
+
+  if( bm == NULL )
+  {
+    printf("There was a problem. Please try again.\n");
+    if(DBG)
+    {
+      printf("ERROR -> main(): bitmap_create() returned NULL, the image may be too big to hold in memory (see -B)\n");
+    }
+    exit(EXIT_FAILURE);
+  }
+
+  // Fill it with green, for debugging
+  bitmap_reset(bm,MAKE_RGBA(0,255,0,0));
+
+  // an earlier render of this same image at a lower max only needs its unfinished pixels carried on
+  struct iterfile * resumeState = NULL;
+  if( resumeFile != NULL )
+  {
+    resumeState = loadResumeState( resumeFile, image_width, image_height, 
+      xcenter-scale, xcenter+scale, ycenter-scale, ycenter+scale, max );
+  }
+
+  // the raw counts are gathered alongside the pixels while the image is computed, 
+  // or when carrying on, they're the ones the earlier render left behind
+  if( rawFile != NULL && resumeState != NULL )
+  {
+    RAW_OUTPUT = resumeState;
+  }
+  else if( rawFile != NULL )
+  {
+    RAW_OUTPUT = iterfile_create(image_width,image_height,max);
+    if( RAW_OUTPUT == NULL )
+    {
+      printf("There was a problem. Please try again.\n");
+      if(DBG)
+      {
+        printf("ERROR -> main(): iterfile_create() for the raw iteration counts returned NULL\n");
+      }
+      exit(EXIT_FAILURE);
+    }
+
+    // only double precision orbits can be carried on from later
+    if( PRECISION == PRECISION_DOUBLE && !iterfile_add_orbits( RAW_OUTPUT, xcenter-scale, xcenter+scale, ycenter-scale, ycenter+scale ) )
+    {
+      printf("There was a problem. Please try again.\n");
+      if(DBG)
+      {
+        printf("ERROR -> main(): iterfile_add_orbits() couldn't allocate the orbits\n");
+      }
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // the cost of every pixel starts at 0, which is what pixels that are filled in or carried over cost
+  if( COST_MAP_FILE != NULL )
+  {
+    COST_MAP = calloc( (size_t) image_width * image_height, sizeof(int) );
+    if( COST_MAP == NULL )
+    {
+      printf("There was a problem. Please try again.\n");
+      if(DBG)
+      {
+        printf("ERROR -> main(): calloc() for the cost map returned NULL\n");
+      }
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // looking the image up in the cache is timed along with computing it, but opening the cache isn't
+  bool cacheHit = false;
+
+  // if this is being timed, get the time value before computation and store it
+  if(TIMING)
+  {
+    gettimeofday( &computeStart, NULL );
+  }
+
+  // Compute the Mandelbrot image - this is where all the action happens
+  // it returns a bool depending on whether or not it was successful
+  bool imageComputed;
+  if( resumeState != NULL )
+  {
+    imageComputed = computeImageResumed(bm,resumeState,xcenter-scale,xcenter+scale,ycenter-scale,ycenter+scale,max,numThreads);
+  }
+  else if( CACHE != NULL )
+  {
+    imageComputed = renderCached(bm,xcenter,ycenter,xcenterText,ycenterText,scale,max,numThreads,&cacheHit);
+  }
+  else
+  {
+    imageComputed = renderFrame(bm,xcenter,ycenter,xcenterText,ycenterText,scale,max,numThreads);
+  }
+
+  if( !imageComputed )
+  {
+    printf("There was a problem. Please try again.\n");
+    if(DBG)
+    {
+      printf("ERROR -> main(): computeImage() returned false, no image created...\n");
+    }
+    exit(EXIT_FAILURE);
+  }
+
+  // if this is being timed, get the time value after computation and store it
+  if(TIMING)
+  {
+    gettimeofday( &computeEnd, NULL );
+  }
+
+  // Save the image in the stated file. An image written while it was computed is in it already, and just needs closing
+  if( STREAM_FILE != NULL ) {
+    if(!bitmap_stream_close(STREAM_FILE)) {
+      fprintf(stderr,"mandel: couldn't write to %s: %s\n",outfile,strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+    STREAM_FILE = NULL;
+  }
+  else if(!bitmap_save(bm,outfile)) {
+    fprintf(stderr,"mandel: couldn't write to %s: %s\n",outfile,strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  if( RAW_OUTPUT != NULL && !iterfile_save(RAW_OUTPUT,rawFile) ) {
+    fprintf(stderr,"mandel: couldn't write to %s: %s\n",rawFile,strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  if( WORK_LOG_FILE != NULL ) {
+    if(!saveWorkLog(WORK_LOG_FILE)) {
+      fprintf(stderr,"mandel: couldn't write to %s: %s\n",WORK_LOG_FILE,strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+    printWorkSummary();
+  }
+
+  if( COST_MAP != NULL && !saveCostMap(COST_MAP_FILE,image_width,image_height) ) {
+    fprintf(stderr,"mandel: couldn't write to %s: %s\n",COST_MAP_FILE,strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  // if this is being timed, calculate & output the time taken in microseconds to run the computation
+  if(TIMING)
+  {
+    int computationTime = (int) elapsedUsec( &computeStart, &computeEnd );
+    printf( "mandel: Computed time taken (in usec): %d\n", computationTime );
+    if( INTERIOR_CHECK )
+    {
+      printf( "mandel: pixels short-circuited by the cardioid/bulb check: %ld of %ld\n", 
+        atomic_load( &SHORT_CIRCUITED_PIXELS ), (long) image_width * image_height );
+    }
+    if( PRECISION == PRECISION_PERTURB )
+    {
+      printf( "mandel: perturbation reference orbit length: %d, pixel rebases: %ld\n", 
+        REFERENCE_ORBIT.length, atomic_load( &REBASED_PIXELS ) );
+    }
+  }
+
+  // how this run went, and how the cache has done over every run that used it, for sizing it
+  closeCache( cacheHit ? "hit" : "miss" );
+
+  // if verification was requested, render the image again the slow and simple way and compare
+  if(VERIFY)
+  {
+    long mismatches = verifyImage(bm,xcenter,ycenter,xcenterText,ycenterText,scale,max,numThreads);
+    if( mismatches < 0 )
+    {
+      printf("There was a problem. Please try again.\n");
+      exit(EXIT_FAILURE);
+    }
+    printf( "mandel: verify: %ld of %ld pixels differ from the exhaustive render\n", mismatches, (long) image_width * image_height );
+    if( mismatches > 0 )
+    {
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if(DBG)
+  {
+    printf("DEBUG: main() exiting...\n");
+  }
+  exit(EXIT_SUCCESS);
+} // main()
+
+/*
+ * function: 
+ *  computeImage
+ * 
+ * description: 
+ *  Called by main() to start the process of creating the pixels and setting the memory for the bmp output.
+ *  It checks if the user requested single- or multi-threading, and instantiates the apropriate number of 
+ *    bandCreationParams structs to hold the information needed so computeBands can generate the actual image pixels.
+ *  This is the function that creates threads, if needed, and wait for those threads to complete before returning 
+ *    to main().
+ *  If the steal or mariani scheduler was requested with -S, or frames of a series are being reused with -r, 
+ *    the work is handed off to computeImageStealing() instead.
+ *  If progressive rendering was requested with -R, the work is handed off to computeImageProgressive() instead.
+ *  If the image is being streamed into its file with -B, the work is handed off to computeImageStreamed() instead.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the pointer to the space allocated for the bitmap
+ *  double xmin: the scaled left-bound of the requested image on the x-axis
+ *  double xmax: the scaled right-bound of the requested image on the x-axis
+ *  double ymin: the scaled lower-bound of the requested image on the y-axis
+ *  double ymax: the scaled upper-bound of the requested image on the y-axis
+ *  int max: max # of recurrence relations to iterate
+ *  int threadsToUse: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors during computation, otherwise false
+ */
+bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
+{
+  if(DBG)
+  {
+    printf("DEBUG: computeImage() starting...\n");
+  }
+
+  // streaming, progressive rendering and the work-stealing scheduler have their own thread management, so let them take over entirely
+  if( STREAM_FILE != NULL )
+  {
+    return computeImageStreamed( bm, xmin, xmax, ymin, ymax, max, threadsToUse );
+  }
+  if( PROGRESSIVE )
+  {
+    return computeImageProgressive( bm, xmin, xmax, ymin, ymax, max, threadsToUse );
+  }
+  if( SCHEDULER == SCHED_STEAL || SCHEDULER == SCHED_MARIANI || SERIES_REUSE )
+  {
+    return computeImageStealing( bm, xmin, xmax, ymin, ymax, max, threadsToUse );
+  }
+  
+  // grab the width and height of the image
+  int width = bitmap_width(bm);
+  int totalHeight = bitmap_height(bm);
+
+  // rows that mirror another row across the real axis are copied from it once the rest is done
+  int mirrored;
+  int * mirrorOf = findMirrorRows( ymin, ymax, totalHeight, &mirrored );
+
+  // declare a pointer var to hold all thread IDs just in case multithreading is used (memory will get allocated later)
+  pthread_t * threadsArr;
+
+  // singlethreading and multithreading are drastically different scenarios, 
+  // so this conditional determines what logic gets executed
+  if( threadsToUse > 1 )
+  {
+    // multithreaded
+
+    if(DBG)
+    {
+      printf("DEBUG: computeImage(): using multithreading with %d threads..\n", threadsToUse);
+    }
+
+    // instantiate and allocate memory for the array that will hold all  
+    // struct pointers for computeBands() parameters
+    struct bandCreationParams * multithreadedArgsArr;
+    multithreadedArgsArr = (struct bandCreationParams *) calloc( threadsToUse, sizeof(struct bandCreationParams) );
+
+    // check to ensure calloc() was successful by checking for null pointer return
+    // return to main if it failed
+    if(multithreadedArgsArr == NULL)
+    {
+      if(DBG)
+      {
+        printf("ERROR -> computeImage(): calloc() for multithreadedArgsArr returned NULL\n");
+      }
+      return false;
+    }
+
+    // since the number of threads may not cleanly divide the number of 
+    // height pixels, store the modulus of them.
+    int modRemainder = totalHeight % threadsToUse;
+
+    // subtract the modulus remainder fromn the overall bmp height 
     // to get a number that will cleanly divide by the number of threads. 
     // The modRemainder will later be re-added to the final thread's 
     // upper-bound height.
@@ -289,10 +1572,12 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
 
     // start the loop that spins-off threads
     int i;
+    int nextBandRow = 0;
     for( i=0 ; i<threadsToUse ; i++ )
     {
       // assign all the threadArgs struct values
       multithreadedArgsArr[i].theBitmap = bm;
+      multithreadedArgsArr[i].mirrorOf = mirrorOf;
       multithreadedArgsArr[i].multithreaded = true;
       multithreadedArgsArr[i].tid = i;
       multithreadedArgsArr[i].bandXMin = xmin;
@@ -321,6 +1606,23 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
         multithreadedArgsArr[i].bandHeightTop += modRemainder;
       }
 
+      // when rows are mirrored, the bands are cut so each one has the same number of rows left to actually compute
+      if( mirrorOf != NULL )
+      {
+        int computedRows = totalHeight - mirrored;
+        int bandRows = (int) ( (long) (i+1) * computedRows / threadsToUse - (long) i * computedRows / threadsToUse );
+        multithreadedArgsArr[i].bandHeightBottom = nextBandRow;
+        while( nextBandRow < totalHeight && bandRows > 0 )
+        {
+          if( mirrorOf[nextBandRow] < 0 )
+          {
+            bandRows--;
+          }
+          nextBandRow++;
+        }
+        multithreadedArgsArr[i].bandHeightTop = i == threadsToUse - 1 ? totalHeight - 1 : nextBandRow - 1;
+      }
+
       if(DBG)
       {
         printf( "DEBUG: computeImage(): band/thread %d height upper bound = %d\n", i, multithreadedArgsArr[i].bandHeightTop );
@@ -328,7 +1630,7 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
 
       // everything is ready, proceed with creating a thread to do the computation work.
       // store the TID in the threadsArr array for later joining
-      int returnCode = pthread_create( &threadsArr[i], NULL, computeBands, (void *) &multithreadedArgsArr[i]);
+      int returnCode = spawnWorker( i, &threadsArr[i], computeBands, (void *) &multithreadedArgsArr[i]);
 
       // check for non-success return code, alert the user and return to main() if so
       if( returnCode != 0 )
@@ -348,7 +1650,7 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
     int joinResult;
     for( k=0 ; k<threadsToUse ; k++ )
     {
-      joinResult = pthread_join( threadsArr[k], NULL );
+      joinResult = joinWorker( k, threadsArr[k] );
       if( DBG && joinResult != 0 )
       {
         printf( "ERROR -> computeImage(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
@@ -359,10 +1661,29 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
         printf( "DEBUG: computeImage(): thread %d exited... \n", k );
       }
 
+      // if this is being timed, show how long each band kept its thread busy, and how many of its rows 
+      // it actually computed rather than leaving to be mirrored
+      if(TIMING)
+      {
+        int bandRows = multithreadedArgsArr[k].bandHeightTop - multithreadedArgsArr[k].bandHeightBottom + 1;
+        int bandMirrored = 0;
+        int j;
+        for( j=multithreadedArgsArr[k].bandHeightBottom ; mirrorOf != NULL && j<=multithreadedArgsArr[k].bandHeightTop ; j++ )
+        {
+          if( mirrorOf[j] >= 0 )
+          {
+            bandMirrored++;
+          }
+        }
+        printf( "mandel: thread %d busy time (in usec): %ld, rows computed: %d, rows mirrored: %d\n", k, multithreadedArgsArr[k].busyUsec,
+          bandRows - bandMirrored, bandMirrored );
+      }
+
     }
 
-    // release the threadsArr array memory since we're finished with it
+    // release the threadsArr and multithreadedArgsArr array memory since we're finished with them
     free(threadsArr);
+    free(multithreadedArgsArr);
 
   } // if( threadsToUse > 1 )
   else
@@ -379,6 +1700,7 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
     struct bandCreationParams singleThreadArgs;
 
     singleThreadArgs.theBitmap = bm;
+    singleThreadArgs.mirrorOf = mirrorOf;
     singleThreadArgs.multithreaded = false;
     singleThreadArgs.tid = 0;
     singleThreadArgs.bandXMin = xmin;
@@ -401,9 +1723,22 @@ bool computeImage( struct bitmap *bm, double xmin, double xmax, double ymin, dou
 
   } // else
 
-  // we no longer need the mutex that locks the bmp memory, destroy it
-  pthread_mutex_destroy(&bmpMutex);
-
+  if( mirrorOf != NULL )
+  {
+    mirrorRows( bm, mirrorOf, width, totalHeight );
+    free( mirrorOf );
+    if(TIMING)
+    {
+      printf( "mandel: rows mirrored across the real axis: %d of %d\n", mirrored, totalHeight );
+    }
+  }
+
+  // the edges can only be told apart once every band is done, since they run across band boundaries
+  if( AA_SAMPLES > 0 && !antialiasEdges( bm, xmin, xmax, ymin, ymax, max, threadsToUse ) )
+  {
+    return false;
+  }
+
   if(DBG)
   {
     printf("DEBUG: computeImage() exiting..\n");
@@ -466,81 +1801,7090 @@ void * computeBands( void * args )
     }
   }
   
-  // declare counters for the for loops below
-  int i,j;
+  // declare the counter for the for loop below
+  int j;
+
+  // note when this band started so the time it kept the thread busy can be reported
+  struct timeval bandStart;
+  struct timeval bandEnd;
+  gettimeofday( &bandStart, NULL );
+  long cpuStart = WORK_LOG_FILE != NULL ? threadCpuUsec() : 0;
+  long long itersStart = THREAD_ITERATIONS;
 
-  // For every pixel in the image...
-  for( j=heightLowerBound ; j<=heightUpperBound ; j++) 
+  // the tiled walk covers the same rows, a tile at a time. If its buffers can't be had, the rows are computed as usual
+  if( !TILED_BANDS || !computeBandTiles( params ) )
   {
-    for( i=0 ; i<width ; i++) 
+    // For every row in the band...
+    for( j=heightLowerBound ; j<=heightUpperBound ; j++) 
     {
-      // Determine the point in x,y space for that pixel.
-      double x = xmin + i*(xmax-xmin)/width;
+      // Determine the y coordinate of the row, then compute and set all of its pixels.
+      // the rows of the band belong to this thread alone, so the mutex is only 
+      // needed if the old locked write path was requested for benchmarking.
+      if( params->mirrorOf != NULL && params->mirrorOf[j] >= 0 )
+      {
+        continue;
+      }
       double y = ymin + j*(ymax-ymin)/totalHeight;
+      computeRow( bm, j, 0, width, xmin, xmax, width, y, max, RAW_OUTPUT, multithreading && LOCKED_WRITES );
+    } // for
+  }
+
+  gettimeofday( &bandEnd, NULL );
+  params->busyUsec = elapsedUsec( &bandStart, &bandEnd );
+
+  // a band is all the work its thread gets, so it goes in the log as both
+  if( WORK_LOG_FILE != NULL )
+  {
+    long cpuUsec = threadCpuUsec() - cpuStart;
+    long long iterations = THREAD_ITERATIONS - itersStart;
+    logWork( WORK_BAND, threadId, 0, heightLowerBound, width, heightUpperBound+1, iterations, params->busyUsec, cpuUsec );
+    logWork( WORK_THREAD, threadId, 0, heightLowerBound, width, heightUpperBound+1, iterations, params->busyUsec, cpuUsec );
+  }
+
+  // the calculation is finished at this point. Return rather than pthread_exit() when multithreading, 
+  // since the thread may belong to WORKER_POOL and have more frames to compute
+  if(DBG)
+  {
+    if( multithreading )
+    {
+      printf( "DEBUG: computeBands() thread %d: exiting..\n", threadId );
+    }
+    else
+    {
+      printf( "DEBUG: computeBands() exiting..\n" );
+    }
+  }
+
+  return NULL;
+} // computeBands()
+
+/*
+ * function: 
+ *  computeBandTiles
+ * 
+ * description: 
+ *  Computes a band in TILE_SIZE x TILE_SIZE tiles (-z) instead of a row at a time, visiting the tiles 
+ *    in Z-order (Morton order) so tiles that are close in the image are also close in time. Each 
+ *    tile is computed into a buffer of its own and copied into the bitmap once it's finished, 
+ *    so a tile's pixels are only ever touched in cache-sized pieces. Whether that saves any cache 
+ *    misses is still to be shown: on the machines measured so far it's been no faster than rows.
+ *  A band is usually many more tiles across than down, so its tiles are walked as a row of squares, 
+ *    each a power of two tiles on a side and visited in Z-order in turn. Morton codes that land 
+ *    past the edge of the band are skipped.
+ * 
+ * parameters:
+ *  struct bandCreationParams * params: the band to compute, as handed to computeBands()
+ * 
+ * returns: 
+ *  bool: true if the band was computed, false if the tile buffers couldn't be allocated
+ */
+static bool computeBandTiles( struct bandCreationParams * params )
+{
+  int width = params->bandWidth;
+  int bandRows = params->bandHeightTop - params->bandHeightBottom + 1;
+  if( bandRows < 1 )
+  {
+    return true;
+  }
+
+  int tileWidth = TILE_SIZE < width ? TILE_SIZE : width;
+  int tileHeight = TILE_SIZE < bandRows ? TILE_SIZE : bandRows;
+  int tilesAcross = ( width + TILE_SIZE - 1 ) / TILE_SIZE;
+  int tilesDown = ( bandRows + TILE_SIZE - 1 ) / TILE_SIZE;
+
+  // the coordinates of the tile's columns and rows, and its colors, row by row
+  double * xs = malloc( tileWidth * sizeof(double) );
+  double * ys = malloc( tileHeight * sizeof(double) );
+  int * colors = malloc( (size_t) tileWidth * tileHeight * sizeof(int) );
+  if( xs == NULL || ys == NULL || colors == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> computeBandTiles(): malloc() for the tile buffers returned NULL\n");
+    }
+    free(xs);
+    free(ys);
+    free(colors);
+    return false;
+  }
 
-      // Compute the iterations at that point.
-      int iters = iterations_at_point(x,y,max);
+  // the squares run along whichever way the band is longer
+  int shorter = tilesAcross < tilesDown ? tilesAcross : tilesDown;
+  int longer = tilesAcross < tilesDown ? tilesDown : tilesAcross;
+  int side = 1;
+  while( side < shorter )
+  {
+    side <<= 1;
+  }
 
-      // Set the pixel in the bitmap.
-      // If using multithreading, lock the mutex first since this call alters the global bmp memory, 
-      // which is shared amongst the threads.
-      if( multithreading )
+  int square;
+  for( square=0 ; square*side<longer ; square++ )
+  {
+    long code;
+    for( code=0 ; code<(long) side*side ; code++ )
+    {
+      int tx, ty;
+      mortonDecode( (unsigned int) code, &tx, &ty );
+      if( tilesAcross >= tilesDown )
       {
-        pthread_mutex_lock(&bmpMutex);
-        bitmap_set(bm,i,j,iters);
-        pthread_mutex_unlock(&bmpMutex);
+        tx += square * side;
       }
       else
       {
-        bitmap_set(bm,i,j,iters);
+        ty += square * side;
       }
-      
-    } // inner for
-  } // outer for
+      if( tx >= tilesAcross || ty >= tilesDown )
+      {
+        continue;
+      }
+
+      struct tile theTile;
+      theTile.xStart = tx * TILE_SIZE;
+      theTile.xEnd = theTile.xStart + TILE_SIZE < width ? theTile.xStart + TILE_SIZE : width;
+      theTile.yStart = params->bandHeightBottom + ty * TILE_SIZE;
+      theTile.yEnd = theTile.yStart + TILE_SIZE <= params->bandHeightTop ? theTile.yStart + TILE_SIZE : params->bandHeightTop + 1;
+      theTile.borderComputed = false;
+      computeBandTile( params, &theTile, xs, ys, colors );
+    }
+  }
 
-  // the calculation is finished at this point, so exit the thread if using multithreading
-  if( multithreading )
+  free(xs);
+  free(ys);
+  free(colors);
+  return true;
+} // computeBandTiles()
+
+/*
+ * function: 
+ *  computeBandTile
+ * 
+ * description: 
+ *  Computes one tile of a band for computeBandTiles(). The x coordinate of every column and the y 
+ *    coordinate of every row of the tile are worked out once up front, with the same expressions 
+ *    computeRow() uses so the image comes out identical, and then handed straight to the kernel 
+ *    ROW_CHUNK pixels at a time without a divide per pixel.
+ *  The colors go into the tile's own buffer and are copied into the bitmap a row of the tile at a time 
+ *    once the whole tile is done. With -I and -G the raw counts, magnitudes, orbits and costs are 
+ *    written straight into their place in the image.
+ * 
+ * parameters:
+ *  struct bandCreationParams * params: the band the tile belongs to
+ *  struct tile * theTile: the rectangle of pixels to compute
+ *  double * xs: room for the x coordinates of the tile's columns
+ *  double * ys: room for the y coordinates of the tile's rows
+ *  int * colors: room for the tile's colors
+ * 
+ * returns: 
+ *  void
+ */
+static void computeBandTile( struct bandCreationParams * params, struct tile * theTile, double * xs, double * ys, int * colors )
+{
+  double xmin = params->bandXMin;
+  double xmax = params->bandXMax;
+  double ymin = params->bandYMin;
+  double ymax = params->bandYMax;
+  int max = params->bandMax;
+  int width = params->bandWidth;
+  int totalHeight = params->bmpTotalHeight;
+  int tileWidth = theTile->xEnd - theTile->xStart;
+  double tolerance = periodTolerance( xmin, xmax, width );
+  int * rawIters = RAW_OUTPUT != NULL ? iterfile_iters(RAW_OUTPUT) : NULL;
+  float * rawMagnitudes = RAW_OUTPUT != NULL ? iterfile_magnitudes(RAW_OUTPUT) : NULL;
+  double * rawOrbitX = RAW_OUTPUT != NULL ? iterfile_orbit_x(RAW_OUTPUT) : NULL;
+  double * rawOrbitY = RAW_OUTPUT != NULL ? iterfile_orbit_y(RAW_OUTPUT) : NULL;
+  double rowYs[ROW_CHUNK];
+
+  int i, j, k;
+  for( i=theTile->xStart ; i<theTile->xEnd ; i++ )
   {
-    if(DBG)
+    xs[i-theTile->xStart] = xmin + i*(xmax-xmin)/width;
+  }
+  for( j=theTile->yStart ; j<theTile->yEnd ; j++ )
+  {
+    ys[j-theTile->yStart] = ymin + j*(ymax-ymin)/totalHeight;
+  }
+
+  for( j=theTile->yStart ; j<theTile->yEnd ; j++ )
+  {
+    if( params->mirrorOf != NULL && params->mirrorOf[j] >= 0 )
     {
-      printf( "DEBUG: computeBands() thread %d: exiting..\n", threadId );
+      continue;
+    }
+
+    int * row = colors + (size_t) ( j - theTile->yStart ) * tileWidth;
+    for( k=0 ; k<ROW_CHUNK && k<tileWidth ; k++ )
+    {
+      rowYs[k] = ys[j-theTile->yStart];
+    }
+
+    for( i=theTile->xStart ; i<theTile->xEnd ; i+=ROW_CHUNK )
+    {
+      int count = theTile->xEnd - i < ROW_CHUNK ? theTile->xEnd - i : ROW_CHUNK;
+      size_t p = (size_t) j * width + i;
+      int * iters = row + ( i - theTile->xStart );
+      computePointIters( xs + ( i - theTile->xStart ), rowYs, count, 0, max, tolerance, iters, 
+        rawMagnitudes != NULL ? rawMagnitudes + p : NULL, rawOrbitX != NULL ? rawOrbitX + p : NULL, 
+        rawOrbitY != NULL ? rawOrbitY + p : NULL, COST_MAP != NULL ? COST_MAP + p : NULL );
+      if( rawIters != NULL )
+      {
+        memcpy( rawIters + p, iters, count * sizeof(int) );
+      }
+      for( k=0 ; k<count ; k++ )
+      {
+        iters[k] = iteration_to_color( iters[k], max );
+      }
     }
-    pthread_exit(NULL);
   }
 
-  if(DBG)
+  // the tile belongs to this thread alone, so the mutex is only needed for the old locked write path
+  bool lockWrites = params->multithreaded && LOCKED_WRITES;
+  if( lockWrites )
   {
-    printf( "DEBUG: computeBands() exiting..\n" );
+    pthread_mutex_lock(&bmpMutex);
   }
-
-  // only singlethreading scenarios get to this point, so return the null ptr
-  return NULL;
-} // computeBands()
+  int * bmpData = bitmap_data( params->theBitmap );
+  for( j=theTile->yStart ; j<theTile->yEnd ; j++ )
+  {
+    if( params->mirrorOf == NULL || params->mirrorOf[j] < 0 )
+    {
+      memcpy( bmpData + (size_t) j * width + theTile->xStart, colors + (size_t) ( j - theTile->yStart ) * tileWidth, tileWidth * sizeof(int) );
+    }
+  }
+  if( lockWrites )
+  {
+    pthread_mutex_unlock(&bmpMutex);
+  }
+} // computeBandTile()
 
 /*
-Return the number of iterations at point x, y
-in the Mandelbrot space, up to a maximum of max.
-*/
+ * function: 
+ *  mortonDecode
+ * 
+ * description: 
+ *  Splits a Z-order (Morton) code back into its x and y, x being the even bits of the code and 
+ *    y the odd ones, so counting codes up from 0 walks a grid one 2x2 block at a time, 
+ *    then one block of those blocks at a time, and so on.
+ * 
+ * parameters:
+ *  unsigned int code: the Morton code
+ *  int * x: receives the x coordinate
+ *  int * y: receives the y coordinate
+ * 
+ * returns: 
+ *  void
+ */
+static void mortonDecode( unsigned int code, int * x, int * y )
+{
+  unsigned int bits[2] = { code, code >> 1 };
+  int k;
+  for( k=0 ; k<2 ; k++ )
+  {
+    unsigned int v = bits[k] & 0x55555555u;
+    v = ( v | ( v >> 1 ) ) & 0x33333333u;
+    v = ( v | ( v >> 2 ) ) & 0x0f0f0f0fu;
+    v = ( v | ( v >> 4 ) ) & 0x00ff00ffu;
+    v = ( v | ( v >> 8 ) ) & 0x0000ffffu;
+    bits[k] = v;
+  }
+  *x = (int) bits[0];
+  *y = (int) bits[1];
+} // mortonDecode()
 
-static int iterations_at_point( double x, double y, int max )
+/*
+ * function: 
+ *  computeImageStealing
+ * 
+ * description: 
+ *  Called by computeImage() when the steal scheduler was requested with -S.
+ *  Instead of one fixed band per thread, the image is cut into TILE_SIZE x TILE_SIZE tiles. Each thread
+ *    starts with its own deque holding a contiguous run of those tiles, and once a thread runs out of 
+ *    work it steals tiles from the other threads' deques, so the expensive parts of the image end up
+ *    spread over every thread instead of stalling the one that happened to own them.
+ *  With the mariani scheduler the threads work on iteration counts instead of pixels, since borders have 
+ *    to be compared count-for-count; the counts are converted to colors once every thread is done.
+ *  Waits for all the threads to finish before returning, and reports per-thread busy time if timing is enabled.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the pointer to the space allocated for the bitmap
+ *  double xmin: the scaled left-bound of the requested image on the x-axis
+ *  double xmax: the scaled right-bound of the requested image on the x-axis
+ *  double ymin: the scaled lower-bound of the requested image on the y-axis
+ *  double ymax: the scaled upper-bound of the requested image on the y-axis
+ *  int max: max # of recurrence relations to iterate
+ *  int threadsToUse: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors during computation, otherwise false
+ */
+bool computeImageStealing( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
 {
-  double x0 = x;
-  double y0 = y;
+  int width = bitmap_width(bm);
+  int totalHeight = bitmap_height(bm);
 
-  int iter = 0;
+  // figure out how many tiles it takes to cover the image, rounding up so partial tiles at the edges are included
+  int tilesAcross = ( width + TILE_SIZE - 1 ) / TILE_SIZE;
+  int tilesDown = ( totalHeight + TILE_SIZE - 1 ) / TILE_SIZE;
+  int numTiles = tilesAcross * tilesDown;
 
-  while( (x*x + y*y <= 4) && iter < max ) {
+  if(DBG)
+  {
+    printf( "DEBUG: computeImageStealing(): %d threads sharing %d tiles of %dx%d pixels..\n", threadsToUse, numTiles, TILE_SIZE, TILE_SIZE );
+  }
 
-    double xt = x*x - y*y + x0;
-    double yt = 2*x*y + y0;
+  // allocate one deque per thread plus the parameters for each thread
+  struct tileScheduler scheduler;
+  scheduler.numDeques = threadsToUse;
+  scheduler.deques = (struct tileDeque *) calloc( threadsToUse, sizeof(struct tileDeque) );
+  struct tileWorkerParams * workerArgsArr = (struct tileWorkerParams *) calloc( threadsToUse, sizeof(struct tileWorkerParams) );
+  pthread_t * threadsArr = (pthread_t *) calloc( threadsToUse, sizeof(pthread_t) );
+  if( scheduler.deques == NULL || workerArgsArr == NULL || threadsArr == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> computeImageStealing(): calloc() for the scheduler arrays returned NULL\n");
+    }
+    free(scheduler.deques);
+    free(workerArgsArr);
+    free(threadsArr);
+    return false;
+  }
+  atomic_init( &scheduler.pendingTiles, numTiles );
+  atomic_init( &scheduler.abandoned, false );
+  atomic_init( &scheduler.pushes, 0 );
+  pthread_mutex_init( &scheduler.lock, NULL );
+  pthread_cond_init( &scheduler.changed, NULL );
 
-    x = xt;
-    y = yt;
+  int i;
+  for( i=0 ; i<threadsToUse ; i++ )
+  {
+    pthread_mutex_init( &scheduler.deques[i].lock, NULL );
+  }
 
-    iter++;
+  // the mariani scheduler needs somewhere to keep the raw counts while it compares borders, 
+  // and -r keeps them around afterwards for the next frame
+  int * iterBuffer = NULL;
+  if( SCHEDULER == SCHED_MARIANI || SERIES_REUSE )
+  {
+    iterBuffer = (int *) malloc( (size_t) width * totalHeight * sizeof(int) );
+    if( iterBuffer == NULL )
+    {
+      if(DBG)
+      {
+        printf("ERROR -> computeImageStealing(): malloc() for iterBuffer returned NULL\n");
+      }
+      freeTileScheduler( &scheduler );
+      free(workerArgsArr);
+      free(threadsArr);
+      return false;
+    }
+  }
+
+  // deal the tiles out in contiguous runs, walking each run backwards so that the owner (which pops 
+  // from the tail) works through its run top-to-bottom while thieves take from the far end of it
+  for( i=0 ; i<threadsToUse ; i++ )
+  {
+    int firstTile = (int) ( (long) i * numTiles / threadsToUse );
+    int lastTile = (int) ( (long) (i+1) * numTiles / threadsToUse ) - 1;
+    int k;
+    for( k=lastTile ; k>=firstTile ; k-- )
+    {
+      struct tile theTile;
+      theTile.xStart = ( k % tilesAcross ) * TILE_SIZE;
+      theTile.yStart = ( k / tilesAcross ) * TILE_SIZE;
+      theTile.xEnd = theTile.xStart + TILE_SIZE < width ? theTile.xStart + TILE_SIZE : width;
+      theTile.yEnd = theTile.yStart + TILE_SIZE < totalHeight ? theTile.yStart + TILE_SIZE : totalHeight;
+      theTile.borderComputed = false;
+      if( !pushTile( &scheduler.deques[i], &theTile ) )
+      {
+        if(DBG)
+        {
+          printf("ERROR -> computeImageStealing(): couldn't allocate room for the initial tiles\n");
+        }
+        freeTileScheduler( &scheduler );
+        free(workerArgsArr);
+        free(threadsArr);
+        free(iterBuffer);
+        return false;
+      }
+    }
+  }
+
+  // the steal scheduler computes rows straight into the bitmap, so it can leave out the rows that 
+  // mirror another one and copy them in afterwards, the same way the band scheduler does
+  int mirrored = 0;
+  int * mirrorOf = iterBuffer == NULL ? findMirrorRows( ymin, ymax, totalHeight, &mirrored ) : NULL;
+
+  // the previous frame can only stand in for this one if it was rendered the same way
+  const struct iterationFrame * previousFrame = NULL;
+  if( SERIES_REUSE && PREVIOUS_FRAME.iters != NULL && PREVIOUS_FRAME.max == max && PREVIOUS_FRAME.precision == PRECISION )
+  {
+    previousFrame = &PREVIOUS_FRAME;
+  }
+
+  for( i=0 ; i<threadsToUse ; i++ )
+  {
+    workerArgsArr[i].theBitmap = bm;
+    workerArgsArr[i].xMin = xmin;
+    workerArgsArr[i].xMax = xmax;
+    workerArgsArr[i].yMin = ymin;
+    workerArgsArr[i].yMax = ymax;
+    workerArgsArr[i].max = max;
+    workerArgsArr[i].width = width;
+    workerArgsArr[i].bmpTotalHeight = totalHeight;
+    workerArgsArr[i].scheduler = &scheduler;
+    workerArgsArr[i].iterBuffer = iterBuffer;
+    workerArgsArr[i].previousFrame = previousFrame;
+    workerArgsArr[i].mirrorOf = mirrorOf;
+    workerArgsArr[i].multithreaded = threadsToUse > 1;
+    workerArgsArr[i].tid = i;
+  }
+
+  if( threadsToUse > 1 )
+  {
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int returnCode = spawnWorker( i, &threadsArr[i], stealWorker, (void *) &workerArgsArr[i] );
+      if( returnCode != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+        if(DBG)
+        {
+          printf( "ERROR -> computeImageStealing(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+        }
+
+        // the threads already running stop after the tile they're on, and nothing of theirs is left behind
+        atomic_store( &scheduler.abandoned, true );
+        announceTiles( &scheduler, false );
+        int started;
+        for( started=0 ; started<i ; started++ )
+        {
+          joinWorker( started, threadsArr[started] );
+        }
+        freeTileScheduler( &scheduler );
+        free(workerArgsArr);
+        free(threadsArr);
+        free(iterBuffer);
+        free(mirrorOf);
+        return false;
+      }
+    }
+
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int joinResult = joinWorker( i, threadsArr[i] );
+      if( DBG && joinResult != 0 )
+      {
+        printf( "ERROR -> computeImageStealing(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+      }
+    }
+  }
+  else
+  {
+    // a single thread still goes through the deque so the tile traversal is the same either way
+    stealWorker( (void *) &workerArgsArr[0] );
+  }
+
+  if( mirrorOf != NULL )
+  {
+    mirrorRows( bm, mirrorOf, width, totalHeight );
+    free( mirrorOf );
+  }
+
+  // convert the counts into the colors the bitmap expects
+  if( iterBuffer != NULL )
+  {
+    int * bmpData = bitmap_data(bm);
+    size_t p;
+    for( p=0 ; p<(size_t) width * totalHeight ; p++ )
+    {
+      bmpData[p] = iteration_to_color( iterBuffer[p], max );
+    }
+    if( RAW_OUTPUT != NULL )
+    {
+      memcpy( iterfile_iters(RAW_OUTPUT), iterBuffer, (size_t) width * totalHeight * sizeof(int) );
+    }
+
+    // with -r the counts become the previous frame for the next one
+    if( SERIES_REUSE )
+    {
+      free( PREVIOUS_FRAME.iters );
+      PREVIOUS_FRAME.iters = iterBuffer;
+      PREVIOUS_FRAME.width = width;
+      PREVIOUS_FRAME.height = totalHeight;
+      PREVIOUS_FRAME.xMin = xmin;
+      PREVIOUS_FRAME.xMax = xmax;
+      PREVIOUS_FRAME.yMin = ymin;
+      PREVIOUS_FRAME.yMax = ymax;
+      PREVIOUS_FRAME.max = max;
+      PREVIOUS_FRAME.precision = PRECISION;
+    }
+    else
+    {
+      free(iterBuffer);
+    }
+  }
+
+  // if this is being timed, show how evenly the tiles were spread across the threads
+  if(TIMING)
+  {
+    long pixelsFilled = 0;
+    long pixelsReused = 0;
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      printf( "mandel: thread %d busy time (in usec): %ld, tiles computed: %d (%d stolen)\n", i, workerArgsArr[i].busyUsec,
+        workerArgsArr[i].tilesComputed, workerArgsArr[i].tilesStolen );
+      pixelsFilled += workerArgsArr[i].pixelsFilled;
+      pixelsReused += workerArgsArr[i].pixelsReused;
+    }
+
+    if( SCHEDULER == SCHED_MARIANI )
+    {
+      printf( "mandel: pixels filled in from uniform borders: %ld of %ld\n", pixelsFilled, (long) width * totalHeight );
+    }
+    if( SERIES_REUSE )
+    {
+      printf( "mandel: pixels filled in from the previous frame: %ld of %ld\n", pixelsReused, (long) width * totalHeight );
+    }
+    if( mirrored > 0 )
+    {
+      printf( "mandel: rows mirrored across the real axis: %d of %d\n", mirrored, totalHeight );
+    }
+  }
+
+  freeTileScheduler( &scheduler );
+  free(workerArgsArr);
+  free(threadsArr);
+
+  // the edges run across tiles, so they're only supersampled once every tile is done
+  if( AA_SAMPLES > 0 && !antialiasEdges( bm, xmin, xmax, ymin, ymax, max, threadsToUse ) )
+  {
+    return false;
+  }
+
+  if(DBG)
+  {
+    printf("DEBUG: computeImageStealing() exiting..\n");
+  }
+
+  return true;
+} // computeImageStealing()
+
+/*
+ * function: 
+ *  stealWorker
+ * 
+ * description: 
+ *  Entry point for the work-stealing threads (and called directly when only one thread is used).
+ *  Pops tiles off of its own deque until it's empty, then steals from the other threads' deques,
+ *    and keeps going until every queued tile in the image has been computed.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type 
+ *    tileWorkerParams, which also receives the busy time and tile counts for this thread.
+ * 
+ * returns: 
+ *  void *
+ */
+void * stealWorker( void * args )
+{
+  struct tileWorkerParams * params = args;
+  struct tileScheduler * scheduler = params->scheduler;
+  struct tileDeque * ownDeque = &scheduler->deques[params->tid];
+
+  if(DBG)
+  {
+    printf( "DEBUG: stealWorker() starting; current TID=%d\n", params->tid );
+  }
+
+  struct tile theTile;
+  struct timeval tileStart;
+  struct timeval tileEnd;
+  long threadCpuStart = WORK_LOG_FILE != NULL ? threadCpuUsec() : 0;
+  long long threadItersStart = THREAD_ITERATIONS;
+
+  // keep going until all tiles are finished, not just until the deques look empty, since a tile 
+  // that's being computed by another thread still counts as outstanding work
+  while( atomic_load( &scheduler->pendingTiles ) > 0 && !atomic_load( &scheduler->abandoned ) )
+  {
+    // read before looking, so a push that happens after an empty look is still noticed
+    long pushesSeen = atomic_load( &scheduler->pushes );
+    bool stolen = false;
+    if( !popTile( ownDeque, &theTile ) )
+    {
+      if( !stealTile( scheduler, params->tid, &theTile ) )
+      {
+        // nothing to take right now, sleep until another thread queues some or the image is done
+        waitForTiles( scheduler, pushesSeen );
+        continue;
+      }
+      stolen = true;
+    }
+
+    gettimeofday( &tileStart, NULL );
+    long tileCpuStart = WORK_LOG_FILE != NULL ? threadCpuUsec() : 0;
+    long long tileItersStart = THREAD_ITERATIONS;
+    if( params->iterBuffer == NULL )
+    {
+      computeTile( params, &theTile );
+    }
+    else if( SERIES_REUSE && !theTile.borderComputed )
+    {
+      computeReusedTile( params, &theTile );
+    }
+    else
+    {
+      computeRectangle( params, &theTile );
+    }
+    gettimeofday( &tileEnd, NULL );
+
+    // with mariani, the tile's record also covers the pieces of it this thread subdivided into 
+    // and computed itself because they couldn't be pushed, but not the ones it pushed
+    if( WORK_LOG_FILE != NULL )
+    {
+      logWork( WORK_TILE, params->tid, theTile.xStart, theTile.yStart, theTile.xEnd, theTile.yEnd, THREAD_ITERATIONS - tileItersStart, 
+        elapsedUsec( &tileStart, &tileEnd ), threadCpuUsec() - tileCpuStart );
+    }
+
+    params->busyUsec += elapsedUsec( &tileStart, &tileEnd );
+    params->tilesComputed++;
+    if( stolen )
+    {
+      params->tilesStolen++;
+    }
+
+    if( atomic_fetch_sub( &scheduler->pendingTiles, 1 ) == 1 )
+    {
+      announceTiles( scheduler, false );
+    }
+  }
+
+  // the thread's wall time is the time it spent on tiles, while its CPU time also counts looking for them
+  if( WORK_LOG_FILE != NULL )
+  {
+    logWork( WORK_THREAD, params->tid, 0, 0, params->width, params->bmpTotalHeight, THREAD_ITERATIONS - threadItersStart, 
+      params->busyUsec, threadCpuUsec() - threadCpuStart );
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: stealWorker() thread %d: exiting after %d tiles..\n", params->tid, params->tilesComputed );
+  }
+
+  return NULL;
+} // stealWorker()
+
+/*
+ * function: 
+ *  computeTile
+ * 
+ * description: 
+ *  Computes every pixel inside one tile and sets them in the bitmap, mapping pixels to 
+ *    x,y space the same way computeBands() does so both schedulers produce identical images.
+ * 
+ * parameters:
+ *  struct tileWorkerParams * params: the image-wide parameters for the thread doing the work
+ *  struct tile * theTile: the rectangle of pixels to compute
+ * 
+ * returns: 
+ *  void
+ */
+static void computeTile( struct tileWorkerParams * params, struct tile * theTile )
+{
+  struct bitmap * bm = params->theBitmap;
+  double xmin = params->xMin;
+  double xmax = params->xMax;
+  double ymin = params->yMin;
+  double ymax = params->yMax;
+  int max = params->max;
+  int width = params->width;
+  int totalHeight = params->bmpTotalHeight;
+
+  // tiles never overlap, so each part of a row belongs to this thread alone
+  int j;
+  for( j=theTile->yStart ; j<theTile->yEnd ; j++ )
+  {
+    if( params->mirrorOf != NULL && params->mirrorOf[j] >= 0 )
+    {
+      continue;
+    }
+    double y = ymin + j*(ymax-ymin)/totalHeight;
+    computeRow( bm, j, theTile->xStart, theTile->xEnd, xmin, xmax, width, y, max, RAW_OUTPUT, params->multithreaded && LOCKED_WRITES );
+  }
+} // computeTile()
+
+/*
+ * function: 
+ *  findMirrorRows
+ * 
+ * description: 
+ *  Finds the rows of an image that are mirror images of another row across the real axis, so 
+ *    only one of each pair has to be computed. The set is symmetric about the real axis, but a 
+ *    row is only taken as the mirror of another when its y (the same ymin + j*(ymax-ymin)/height 
+ *    the schedulers compute) is exactly the other row's y negated, since anything else would 
+ *    change the image. How many rows qualify depends on how the bounds round, not only on the 
+ *    view being centered.
+ *  Every row below the real axis (y < 0) is computed; rows above it are mirrored when they can be.
+ *  Only double and float precision qualify: the dd and perturbation kernels don't map y symmetrically.
+ * 
+ * parameters:
+ *  double ymin: the scaled lower-bound of the image on the y-axis
+ *  double ymax: the scaled upper-bound of the image on the y-axis
+ *  int totalHeight: the height of the image in pixels
+ *  int * mirrored: receives the number of rows that will be mirrored
+ * 
+ * returns: 
+ *  int *: for every row, the row it mirrors or -1, to be freed by the caller. NULL if no row mirrors another
+ */
+static int * findMirrorRows( double ymin, double ymax, int totalHeight, int * mirrored )
+{
+  *mirrored = 0;
+  if( !MIRROR_SYMMETRY || !( ymin < 0 && ymax > 0 ) || ( PRECISION != PRECISION_DOUBLE && PRECISION != PRECISION_FLOAT ) )
+  {
+    return NULL;
+  }
+
+  int * mirrorOf = malloc( (size_t) totalHeight * sizeof(int) );
+  if( mirrorOf == NULL )
+  {
+    return NULL;
+  }
+
+  int j, m;
+  for( j=0 ; j<totalHeight ; j++ )
+  {
+    mirrorOf[j] = -1;
+    double y = ymin + j*(ymax-ymin)/totalHeight;
+    if( y <= 0 )
+    {
+      continue;
+    }
+
+    // the row whose y is nearest -y, and its neighbours in case the rounding went the other way
+    int guess = (int) floor( (-y - ymin)*totalHeight/(ymax-ymin) + 0.5 );
+    for( m=guess-1 ; m<=guess+1 ; m++ )
+    {
+      if( m >= 0 && m < totalHeight && ymin + m*(ymax-ymin)/totalHeight == -y )
+      {
+        mirrorOf[j] = m;
+        (*mirrored)++;
+        break;
+      }
+    }
+  }
+
+  if(DBG)
+  {
+    printf("DEBUG: findMirrorRows() found %d of %d rows mirroring another\n", *mirrored, totalHeight);
+  }
+
+  if( *mirrored == 0 )
+  {
+    free( mirrorOf );
+    return NULL;
+  }
+  return mirrorOf;
+} // findMirrorRows()
+
+/*
+ * function: 
+ *  mirrorRows
+ * 
+ * description: 
+ *  Fills in the rows findMirrorRows() left out by copying the row each one mirrors. With -I the 
+ *    raw counts, magnitudes and orbits are copied too, with the orbit's y negated. -G's cost map 
+ *    is copied as well, so it shows what every pixel costs to compute, and stays symmetric like the image.
+ * 
+ * parameters:
+ *  struct bitmap * bm: the bitmap, with every row that isn't mirrored already computed
+ *  const int * mirrorOf: the row each row mirrors, or -1
+ *  int width: the width of the image in pixels
+ *  int totalHeight: the height of the image in pixels
+ * 
+ * returns: 
+ *  void
+ */
+static void mirrorRows( struct bitmap * bm, const int * mirrorOf, int width, int totalHeight )
+{
+  int * data = bitmap_data(bm);
+  int * rawIters = RAW_OUTPUT != NULL ? iterfile_iters(RAW_OUTPUT) : NULL;
+  float * rawMagnitudes = RAW_OUTPUT != NULL ? iterfile_magnitudes(RAW_OUTPUT) : NULL;
+  double * rawOrbitX = RAW_OUTPUT != NULL ? iterfile_orbit_x(RAW_OUTPUT) : NULL;
+  double * rawOrbitY = RAW_OUTPUT != NULL ? iterfile_orbit_y(RAW_OUTPUT) : NULL;
+
+  int j, i;
+  for( j=0 ; j<totalHeight ; j++ )
+  {
+    if( mirrorOf[j] < 0 )
+    {
+      continue;
+    }
+    size_t to = (size_t) j * width;
+    size_t from = (size_t) mirrorOf[j] * width;
+    memcpy( data + to, data + from, width * sizeof(int) );
+    if( COST_MAP != NULL )
+    {
+      memcpy( COST_MAP + to, COST_MAP + from, width * sizeof(int) );
+    }
+    if( rawIters != NULL )
+    {
+      memcpy( rawIters + to, rawIters + from, width * sizeof(int) );
+      memcpy( rawMagnitudes + to, rawMagnitudes + from, width * sizeof(float) );
+    }
+    if( rawOrbitX != NULL )
+    {
+      memcpy( rawOrbitX + to, rawOrbitX + from, width * sizeof(double) );
+      // NAN marks an orbit that never escapes, and an orbit that lands exactly on the axis 
+      // lands on +0 from either side, so only the rest change sign
+      for( i=0 ; i<width ; i++ )
+      {
+        double orbitY = rawOrbitY[from+i];
+        rawOrbitY[to+i] = isnan( orbitY ) || orbitY == 0 ? orbitY : -orbitY;
+      }
+    }
+  }
+} // mirrorRows()
+
+/*
+ * function: 
+ *  isEdgePixel
+ * 
+ * description: 
+ *  Tells whether a pixel of a finished image lies on an edge, where its iteration count jumps far 
+ *    enough from one of its eight neighbours' that the colors they map to differ by more than 
+ *    AA_EDGE_LEVELS in some channel. Differences the palette can't show don't count, so the smooth 
+ *    parts of the image stay at one sample no matter how their counts step.
+ * 
+ * parameters:
+ *  const int * data: the colors of the image, row by row
+ *  int i: the column of the pixel
+ *  int j: the row of the pixel
+ *  int width: the width of the image in pixels
+ *  int totalHeight: the height of the image in pixels
+ * 
+ * returns: 
+ *  bool: true if the pixel should be supersampled
+ */
+static bool isEdgePixel( const int * data, int i, int j, int width, int totalHeight )
+{
+  int color = data[(size_t) j * width + i];
+  int di, dj;
+  for( dj=-1 ; dj<=1 ; dj++ )
+  {
+    for( di=-1 ; di<=1 ; di++ )
+    {
+      int ni = i + di;
+      int nj = j + dj;
+      if( ( di == 0 && dj == 0 ) || ni < 0 || ni >= width || nj < 0 || nj >= totalHeight )
+      {
+        continue;
+      }
+      int neighbour = data[(size_t) nj * width + ni];
+      if( abs( GET_RED(color) - GET_RED(neighbour) ) > AA_EDGE_LEVELS ||
+          abs( GET_GREEN(color) - GET_GREEN(neighbour) ) > AA_EDGE_LEVELS ||
+          abs( GET_BLUE(color) - GET_BLUE(neighbour) ) > AA_EDGE_LEVELS )
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+} // isEdgePixel()
+
+/*
+ * function: 
+ *  antialiasEdges
+ * 
+ * description: 
+ *  Anti-aliases a finished 1x image (-A). Every pixel isEdgePixel() picks out is rendered again from an 
+ *    AA_SAMPLES x AA_SAMPLES grid of points spread evenly over the pixel around its original sample 
+ *    point, and set to the average of their colors. Only the edge pixels are iterated again, so the 
+ *    cost grows with how much boundary the view holds rather than with its area.
+ *  The edge pixels are found first, from the image as it was before any of them changed, then handed 
+ *    out to the threads in chunks off of a shared counter, the same as a resumed render does.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the finished image, which gets its edge pixels replaced
+ *  double xmin: the scaled left-bound of the image on the x-axis
+ *  double xmax: the scaled right-bound of the image on the x-axis
+ *  double ymin: the scaled lower-bound of the image on the y-axis
+ *  double ymax: the scaled upper-bound of the image on the y-axis
+ *  int max: max # of recurrence relations to iterate
+ *  int threadsToUse: the number of threads to supersample with
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors, otherwise false
+ */
+static bool antialiasEdges( struct bitmap * bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
+{
+  int width = bitmap_width(bm);
+  int totalHeight = bitmap_height(bm);
+  const int * data = bitmap_data(bm);
+
+  int * points = malloc( (size_t) width * totalHeight * sizeof(int) );
+  pthread_t * threadsArr = calloc( threadsToUse, sizeof(pthread_t) );
+  if( points == NULL || threadsArr == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> antialiasEdges(): malloc() for the edge pixels returned NULL\n");
+    }
+    free(points);
+    free(threadsArr);
+    return false;
+  }
+
+  long pointCount = 0;
+  int i, j;
+  for( j=0 ; j<totalHeight ; j++ )
+  {
+    for( i=0 ; i<width ; i++ )
+    {
+      if( isEdgePixel( data, i, j, width, totalHeight ) )
+      {
+        points[pointCount++] = j * width + i;
+      }
+    }
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: antialiasEdges(): supersampling %ld edge pixels of %ld with %dx%d points each\n", 
+      pointCount, (long) width * totalHeight, AA_SAMPLES, AA_SAMPLES );
+  }
+
+  atomic_long nextChunk;
+  atomic_init( &nextChunk, 0 );
+
+  struct antialiasParams antialias;
+  antialias.theBitmap = bm;
+  antialias.points = points;
+  antialias.pointCount = pointCount;
+  antialias.xMin = xmin;
+  antialias.xMax = xmax;
+  antialias.yMin = ymin;
+  antialias.yMax = ymax;
+  antialias.max = max;
+  antialias.width = width;
+  antialias.bmpTotalHeight = totalHeight;
+  antialias.nextChunk = &nextChunk;
+
+  if( threadsToUse > 1 && pointCount > 0 )
+  {
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int returnCode = spawnWorker( i, &threadsArr[i], antialiasWorker, (void *) &antialias );
+      if( returnCode != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+        if(DBG)
+        {
+          printf( "ERROR -> antialiasEdges(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+        }
+        return false;
+      }
+    }
+
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int joinResult = joinWorker( i, threadsArr[i] );
+      if( DBG && joinResult != 0 )
+      {
+        printf( "ERROR -> antialiasEdges(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+      }
+    }
+  }
+  else
+  {
+    antialiasWorker( (void *) &antialias );
+  }
+
+  if(TIMING)
+  {
+    printf( "mandel: edge pixels supersampled %dx%d: %ld of %ld\n", AA_SAMPLES, AA_SAMPLES, pointCount, (long) width * totalHeight );
+  }
+
+  free(points);
+  free(threadsArr);
+  return true;
+} // antialiasEdges()
+
+/*
+ * function: 
+ *  antialiasWorker
+ * 
+ * description: 
+ *  Entry point for the threads of the anti-aliasing pass (and called directly when only one thread is used).
+ *  Takes chunks of ROW_CHUNK edge pixels off of the shared counter and streams the sample points of all 
+ *    of them through computePointIters() ROW_CHUNK at a time, so the SIMD lanes stay full whatever -A is. 
+ *    Each pixel is then set to the average color of its samples.
+ *  The edge pixels were all picked before any thread started, so it doesn't matter that their 
+ *    neighbours change underneath them.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type 
+ *    antialiasParams, which is shared by all the threads.
+ * 
+ * returns: 
+ *  void *
+ */
+void * antialiasWorker( void * args )
+{
+  struct antialiasParams * antialias = args;
+  int * data = bitmap_data( antialias->theBitmap );
+  int width = antialias->width;
+  int samples = AA_SAMPLES * AA_SAMPLES;
+  double tolerance = periodTolerance( antialias->xMin, antialias->xMax, width * AA_SAMPLES );
+
+  double xs[ROW_CHUNK];
+  double ys[ROW_CHUNK];
+  int iters[ROW_CHUNK];
+  int costs[ROW_CHUNK];
+  int owners[ROW_CHUNK];
+  long red[ROW_CHUNK];
+  long green[ROW_CHUNK];
+  long blue[ROW_CHUNK];
+  long alpha[ROW_CHUNK];
+  long pixelCost[ROW_CHUNK];
+
+  while( true )
+  {
+    long first = atomic_fetch_add( antialias->nextChunk, 1 ) * ROW_CHUNK;
+    long last = first + ROW_CHUNK < antialias->pointCount ? first + ROW_CHUNK : antialias->pointCount;
+    if( first >= last )
+    {
+      break;
+    }
+
+    int count = (int) ( last - first );
+    int k;
+    for( k=0 ; k<count ; k++ )
+    {
+      red[k] = green[k] = blue[k] = alpha[k] = pixelCost[k] = 0;
+    }
+
+    // every sample of every pixel in the chunk, a kernel's worth at a time
+    long sample = 0;
+    long sampleCount = (long) count * samples;
+    while( sample < sampleCount )
+    {
+      int batch = 0;
+      for( ; sample < sampleCount && batch < ROW_CHUNK ; sample++, batch++ )
+      {
+        int owner = (int) ( sample / samples );
+        int s = (int) ( sample % samples );
+        int p = antialias->points[first+owner];
+        double i = p % width + ( s % AA_SAMPLES + 0.5 ) / AA_SAMPLES - 0.5;
+        double j = p / width + ( s / AA_SAMPLES + 0.5 ) / AA_SAMPLES - 0.5;
+        xs[batch] = antialias->xMin + i*(antialias->xMax-antialias->xMin)/width;
+        ys[batch] = antialias->yMin + j*(antialias->yMax-antialias->yMin)/antialias->bmpTotalHeight;
+        owners[batch] = owner;
+      }
+
+      computePointIters( xs, ys, batch, 0, antialias->max, tolerance, iters, NULL, NULL, NULL, COST_MAP != NULL ? costs : NULL );
+
+      for( k=0 ; k<batch ; k++ )
+      {
+        int color = iteration_to_color( iters[k], antialias->max );
+        red[owners[k]] += GET_RED(color);
+        green[owners[k]] += GET_GREEN(color);
+        blue[owners[k]] += GET_BLUE(color);
+        alpha[owners[k]] += GET_ALPHA(color);
+        if( COST_MAP != NULL )
+        {
+          pixelCost[owners[k]] += costs[k];
+        }
+      }
+    }
+
+    // each edge pixel belongs to exactly one chunk, so nothing else writes it
+    for( k=0 ; k<count ; k++ )
+    {
+      int p = antialias->points[first+k];
+      data[p] = MAKE_RGBA( ( red[k] + samples/2 ) / samples, ( green[k] + samples/2 ) / samples, 
+        ( blue[k] + samples/2 ) / samples, ( alpha[k] + samples/2 ) / samples );
+      if( COST_MAP != NULL )
+      {
+        COST_MAP[p] += (int) pixelCost[k];
+      }
+    }
+  }
+
+  return NULL;
+} // antialiasWorker()
+
+/*
+ * function: 
+ *  computeRectangle
+ * 
+ * description: 
+ *  The mariani scheduler's tile function (Mariani-Silver subdivision). Makes sure the border of 
+ *    the rectangle is computed, and if every border pixel has the same iteration count, fills the 
+ *    inside of the rectangle with that count without computing it. Otherwise the rectangle is cut 
+ *    in two across its longer side: the dividing line is computed, and the two halves (whose 
+ *    borders are now all known) are pushed onto this thread's deque, where any idle thread can 
+ *    steal them. Rectangles that are too thin to be worth subdividing are just computed.
+ *  Neighbouring rectangles never share pixels, and a rectangle's children are only pushed once 
+ *    their borders are written, so no two threads ever write the same pixel.
+ * 
+ * parameters:
+ *  struct tileWorkerParams * params: the image-wide parameters for the thread doing the work
+ *  struct tile * rect: the rectangle of pixels to compute
+ * 
+ * returns: 
+ *  void
+ */
+static void computeRectangle( struct tileWorkerParams * params, struct tile * rect )
+{
+  int * buffer = params->iterBuffer;
+  int width = params->width;
+  int left = rect->xStart;
+  int right = rect->xEnd - 1;
+  int top = rect->yStart;
+  int bottom = rect->yEnd - 1;
+  int i,j;
+
+  // the tiles the image starts out as don't have their borders computed yet
+  if( !rect->borderComputed )
+  {
+    computeIterSpan( params, top, left, right+1 );
+    if( bottom != top )
+    {
+      computeIterSpan( params, bottom, left, right+1 );
+    }
+    computeIterColumn( params, left, top+1, bottom );
+    if( right != left )
+    {
+      computeIterColumn( params, right, top+1, bottom );
+    }
+  }
+
+  // a rectangle that's all border is already finished
+  if( right - left < 2 || bottom - top < 2 )
+  {
+    return;
+  }
+
+  // check whether every pixel around the border has the same count
+  int * topRow = buffer + (size_t) top * width;
+  int * bottomRow = buffer + (size_t) bottom * width;
+  int borderIters = topRow[left];
+  bool uniform = true;
+  for( i=left ; i<=right && uniform ; i++ )
+  {
+    uniform = topRow[i] == borderIters && bottomRow[i] == borderIters;
+  }
+  for( j=top+1 ; j<bottom && uniform ; j++ )
+  {
+    int * row = buffer + (size_t) j * width;
+    uniform = row[left] == borderIters && row[right] == borderIters;
+  }
+
+  if( uniform )
+  {
+    for( j=top+1 ; j<bottom ; j++ )
+    {
+      int * row = buffer + (size_t) j * width;
+      for( i=left+1 ; i<right ; i++ )
+      {
+        row[i] = borderIters;
+      }
+    }
+    params->pixelsFilled += (long) ( right - left - 1 ) * ( bottom - top - 1 );
+    return;
+  }
+
+  // too thin to be worth subdividing any further, so compute whatever is left
+  if( right - left - 1 <= MARIANI_MIN_SIZE || bottom - top - 1 <= MARIANI_MIN_SIZE )
+  {
+    for( j=top+1 ; j<bottom ; j++ )
+    {
+      computeIterSpan( params, j, left+1, right );
+    }
+    return;
+  }
+
+  // cut the rectangle across its longer side, computing the line the two halves share
+  struct tile firstHalf = *rect;
+  struct tile secondHalf = *rect;
+  firstHalf.borderComputed = true;
+  secondHalf.borderComputed = true;
+  if( right - left >= bottom - top )
+  {
+    int mid = ( left + right ) / 2;
+    computeIterColumn( params, mid, top+1, bottom );
+    firstHalf.xEnd = mid + 1;
+    secondHalf.xStart = mid;
+  }
+  else
+  {
+    int mid = ( top + bottom ) / 2;
+    computeIterSpan( params, mid, left+1, right );
+    firstHalf.yEnd = mid + 1;
+    secondHalf.yStart = mid;
+  }
+
+  // count the halves as outstanding work before pushing them, so the image can't be 
+  // considered finished in between. The first half is pushed last so this thread pops it next.
+  // If there's no room to queue a half, just handle it right here instead
+  atomic_fetch_add( &params->scheduler->pendingTiles, 2 );
+  struct tileDeque * ownDeque = &params->scheduler->deques[params->tid];
+  if( !pushTile( ownDeque, &secondHalf ) )
+  {
+    computeRectangle( params, &secondHalf );
+    atomic_fetch_sub( &params->scheduler->pendingTiles, 1 );
+  }
+  if( !pushTile( ownDeque, &firstHalf ) )
+  {
+    computeRectangle( params, &firstHalf );
+    atomic_fetch_sub( &params->scheduler->pendingTiles, 1 );
+  }
+  announceTiles( params->scheduler, true );
+} // computeRectangle()
+
+/*
+ * function: 
+ *  computeIterSpan
+ * 
+ * description: 
+ *  Computes the iteration counts for pixels iStart up to (but not including) iEnd of row j, 
+ *    and stores them in the mariani scheduler's iteration buffer.
+ * 
+ * parameters:
+ *  struct tileWorkerParams * params: the image-wide parameters for the thread doing the work
+ *  int j: the row being computed
+ *  int iStart: the first column to compute
+ *  int iEnd: one past the last column to compute
+ * 
+ * returns: 
+ *  void
+ */
+static void computeIterSpan( struct tileWorkerParams * params, int j, int iStart, int iEnd )
+{
+  double y = params->yMin + j*(params->yMax-params->yMin)/params->bmpTotalHeight;
+  int * row = params->iterBuffer + (size_t) j * params->width;
+  size_t rawOffset = (size_t) j * params->width + iStart;
+  float * rawMagnitudes = RAW_OUTPUT != NULL ? iterfile_magnitudes(RAW_OUTPUT) + rawOffset : NULL;
+  double * rawOrbitX = RAW_OUTPUT != NULL && iterfile_orbit_x(RAW_OUTPUT) != NULL ? iterfile_orbit_x(RAW_OUTPUT) + rawOffset : NULL;
+  double * rawOrbitY = RAW_OUTPUT != NULL && iterfile_orbit_y(RAW_OUTPUT) != NULL ? iterfile_orbit_y(RAW_OUTPUT) + rawOffset : NULL;
+  int * costs = COST_MAP != NULL ? COST_MAP + rawOffset : NULL;
+  computeRowIters( row + iStart, rawMagnitudes, rawOrbitX, rawOrbitY, costs, iStart, iEnd, params->xMin, params->xMax, params->width, y, params->max );
+} // computeIterSpan()
+
+/*
+ * function: 
+ *  computeIterColumn
+ * 
+ * description: 
+ *  Computes the iteration counts for rows jStart up to (but not including) jEnd of column i, 
+ *    and stores them in the mariani scheduler's iteration buffer. The column is handed to the 
+ *    kernel ROW_CHUNK pixels at a time, so the SIMD lanes stay full on vertical borders too.
+ * 
+ * parameters:
+ *  struct tileWorkerParams * params: the image-wide parameters for the thread doing the work
+ *  int i: the column being computed
+ *  int jStart: the first row to compute
+ *  int jEnd: one past the last row to compute
+ * 
+ * returns: 
+ *  void
+ */
+static void computeIterColumn( struct tileWorkerParams * params, int i, int jStart, int jEnd )
+{
+  double xs[ROW_CHUNK];
+  double ys[ROW_CHUNK];
+  int iters[ROW_CHUNK];
+  float magnitudes[ROW_CHUNK];
+  double orbitX[ROW_CHUNK];
+  double orbitY[ROW_CHUNK];
+  int costs[ROW_CHUNK];
+  float * rawMagnitudes = RAW_OUTPUT != NULL ? iterfile_magnitudes(RAW_OUTPUT) : NULL;
+  double * rawOrbitX = RAW_OUTPUT != NULL ? iterfile_orbit_x(RAW_OUTPUT) : NULL;
+  double * rawOrbitY = RAW_OUTPUT != NULL ? iterfile_orbit_y(RAW_OUTPUT) : NULL;
+  double x = params->xMin + i*(params->xMax-params->xMin)/params->width;
+  double tolerance = periodTolerance( params->xMin, params->xMax, params->width );
+
+  int j, k;
+  for( j=jStart ; j<jEnd ; j+=ROW_CHUNK )
+  {
+    int count = jEnd - j < ROW_CHUNK ? jEnd - j : ROW_CHUNK;
+
+    for( k=0 ; k<count ; k++ )
+    {
+      xs[k] = x;
+      ys[k] = params->yMin + (j+k)*(params->yMax-params->yMin)/params->bmpTotalHeight;
+    }
+
+    computePointIters( xs, ys, count, 0, params->max, tolerance, iters, rawMagnitudes != NULL ? magnitudes : NULL,
+      rawOrbitX != NULL ? orbitX : NULL, rawOrbitY != NULL ? orbitY : NULL, COST_MAP != NULL ? costs : NULL );
+
+    for( k=0 ; k<count ; k++ )
+    {
+      size_t p = (size_t) (j+k) * params->width + i;
+      params->iterBuffer[p] = iters[k];
+      if( rawMagnitudes != NULL )
+      {
+        rawMagnitudes[p] = magnitudes[k];
+      }
+      if( rawOrbitX != NULL && iters[k] >= params->max )
+      {
+        rawOrbitX[p] = orbitX[k];
+        rawOrbitY[p] = orbitY[k];
+      }
+      if( COST_MAP != NULL )
+      {
+        COST_MAP[p] = costs[k];
+      }
+    }
+  }
+} // computeIterColumn()
+
+/*
+ * function: 
+ *  computeReusedTile
+ * 
+ * description: 
+ *  The tile function used with -r. If the area of the tile (plus a pixel of margin all around) 
+ *    had a single iteration count in the previous frame of the series, the tile's border is 
+ *    computed, and if every border pixel still has that same count, the inside is filled in with 
+ *    it. Both have to agree, which keeps this a lot more cautious than a border check alone.
+ *  Any other tile is computed normally: subdivided by computeRectangle() with the mariani 
+ *    scheduler (keeping the border if it was already computed), otherwise row by row.
+ * 
+ * parameters:
+ *  struct tileWorkerParams * params: the image-wide parameters for the thread doing the work
+ *  struct tile * theTile: the rectangle of pixels to compute
+ * 
+ * returns: 
+ *  void
+ */
+static void computeReusedTile( struct tileWorkerParams * params, struct tile * theTile )
+{
+  int * buffer = params->iterBuffer;
+  int width = params->width;
+  int left = theTile->xStart;
+  int right = theTile->xEnd - 1;
+  int top = theTile->yStart;
+  int bottom = theTile->yEnd - 1;
+  int i,j;
+
+  int previousIters;
+  if( right - left >= 2 && bottom - top >= 2 && previousFrameUniform( params, theTile, &previousIters ) )
+  {
+    computeIterSpan( params, top, left, right+1 );
+    computeIterSpan( params, bottom, left, right+1 );
+    computeIterColumn( params, left, top+1, bottom );
+    computeIterColumn( params, right, top+1, bottom );
+
+    int * topRow = buffer + (size_t) top * width;
+    int * bottomRow = buffer + (size_t) bottom * width;
+    bool uniform = true;
+    for( i=left ; i<=right && uniform ; i++ )
+    {
+      uniform = topRow[i] == previousIters && bottomRow[i] == previousIters;
+    }
+    for( j=top+1 ; j<bottom && uniform ; j++ )
+    {
+      int * row = buffer + (size_t) j * width;
+      uniform = row[left] == previousIters && row[right] == previousIters;
+    }
+
+    if( uniform )
+    {
+      for( j=top+1 ; j<bottom ; j++ )
+      {
+        int * row = buffer + (size_t) j * width;
+        for( i=left+1 ; i<right ; i++ )
+        {
+          row[i] = previousIters;
+        }
+      }
+      params->pixelsReused += (long) ( right - left - 1 ) * ( bottom - top - 1 );
+      return;
+    }
+
+    // the border is known now, so only the inside is left
+    theTile->borderComputed = true;
+  }
+
+  if( SCHEDULER == SCHED_MARIANI )
+  {
+    computeRectangle( params, theTile );
+    return;
+  }
+
+  if( theTile->borderComputed )
+  {
+    for( j=top+1 ; j<bottom ; j++ )
+    {
+      computeIterSpan( params, j, left+1, right );
+    }
+  }
+  else
+  {
+    for( j=top ; j<=bottom ; j++ )
+    {
+      computeIterSpan( params, j, left, right+1 );
+    }
+  }
+} // computeReusedTile()
+
+/*
+ * function: 
+ *  previousFrameUniform
+ * 
+ * description: 
+ *  Maps the corners of a tile into the pixels of the previous frame, widens that by a pixel on 
+ *    every side, and checks whether all of those previous pixels have the same iteration count.
+ *  Tiles that reach outside of the previous frame don't count as uniform.
+ * 
+ * parameters:
+ *  struct tileWorkerParams * params: the image-wide parameters for the thread doing the work
+ *  struct tile * theTile: the rectangle of pixels being computed
+ *  int * iters: receives the previous frame's count when the area is uniform
+ * 
+ * returns: 
+ *  bool: true if the area was uniform in the previous frame, otherwise false
+ */
+static bool previousFrameUniform( struct tileWorkerParams * params, struct tile * theTile, int * iters )
+{
+  const struct iterationFrame * previous = params->previousFrame;
+  if( previous == NULL )
+  {
+    return false;
+  }
+
+  // the corner pixels' coordinates in this frame, then in the previous frame's pixels
+  double xFirst = params->xMin + theTile->xStart*(params->xMax-params->xMin)/params->width;
+  double xLast = params->xMin + (theTile->xEnd-1)*(params->xMax-params->xMin)/params->width;
+  double yFirst = params->yMin + theTile->yStart*(params->yMax-params->yMin)/params->bmpTotalHeight;
+  double yLast = params->yMin + (theTile->yEnd-1)*(params->yMax-params->yMin)/params->bmpTotalHeight;
+
+  double xScale = previous->width / ( previous->xMax - previous->xMin );
+  double yScale = previous->height / ( previous->yMax - previous->yMin );
+  double left = floor( ( xFirst - previous->xMin ) * xScale ) - 1;
+  double right = ceil( ( xLast - previous->xMin ) * xScale ) + 1;
+  double top = floor( ( yFirst - previous->yMin ) * yScale ) - 1;
+  double bottom = ceil( ( yLast - previous->yMin ) * yScale ) + 1;
+
+  if( left < 0 || top < 0 || right >= previous->width || bottom >= previous->height )
+  {
+    return false;
+  }
+
+  int count = previous->iters[ (size_t) top * previous->width + (int) left ];
+  int i,j;
+  for( j=(int) top ; j<=(int) bottom ; j++ )
+  {
+    const int * row = previous->iters + (size_t) j * previous->width;
+    for( i=(int) left ; i<=(int) right ; i++ )
+    {
+      if( row[i] != count )
+      {
+        return false;
+      }
+    }
+  }
+
+  *iters = count;
+  return true;
+} // previousFrameUniform()
+
+/*
+ * function: 
+ *  computeImageProgressive
+ * 
+ * description: 
+ *  Called by computeImage() when progressive rendering was requested with -R.
+ *  The first pass computes every PROGRESSIVE_START_STEP'th pixel of every PROGRESSIVE_START_STEP'th row. 
+ *    Each following pass halves the step and computes only the pixels on the finer grid that weren't 
+ *    computed already, so by the final pass (step 1) every pixel has been computed exactly once and 
+ *    the finished image costs the same as a normal render.
+ *  If a preview file was requested with -w, each computed pixel is also copied over the block of 
+ *    pixels it stands in for until a later pass computes them, and the bitmap is saved after every 
+ *    pass but the last (main() saves the finished image as usual).
+ *  Within a pass the rows are handed out to the threads one at a time from a shared counter.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the pointer to the space allocated for the bitmap
+ *  double xmin: the scaled left-bound of the requested image on the x-axis
+ *  double xmax: the scaled right-bound of the requested image on the x-axis
+ *  double ymin: the scaled lower-bound of the requested image on the y-axis
+ *  double ymax: the scaled upper-bound of the requested image on the y-axis
+ *  int max: max # of recurrence relations to iterate
+ *  int threadsToUse: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors during computation, otherwise false
+ */
+bool computeImageProgressive( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
+{
+  struct timeval renderStart;
+  struct timeval passEnd;
+  gettimeofday( &renderStart, NULL );
+
+  pthread_t * threadsArr = (pthread_t *) calloc( threadsToUse, sizeof(pthread_t) );
+  if( threadsArr == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> computeImageProgressive(): calloc() for threadsArr returned NULL\n");
+    }
+    return false;
+  }
+
+  int step;
+  for( step=PROGRESSIVE_START_STEP ; step>=1 ; step/=2 )
+  {
+    atomic_int nextRow;
+    atomic_init( &nextRow, 0 );
+
+    struct progressivePassParams pass;
+    pass.theBitmap = bm;
+    pass.xMin = xmin;
+    pass.xMax = xmax;
+    pass.yMin = ymin;
+    pass.yMax = ymax;
+    pass.max = max;
+    pass.width = bitmap_width(bm);
+    pass.bmpTotalHeight = bitmap_height(bm);
+    pass.step = step;
+    pass.fillBlocks = PREVIEW_FILE != NULL && step > 1;
+    pass.nextRow = &nextRow;
+
+    if(DBG)
+    {
+      printf( "DEBUG: computeImageProgressive(): starting the pass for every %d pixel(s)..\n", step );
+    }
+
+    if( threadsToUse > 1 )
+    {
+      // every thread shares the same pass parameters, and pulls rows off of nextRow until there are none left
+      int i;
+      for( i=0 ; i<threadsToUse ; i++ )
+      {
+        int returnCode = spawnWorker( i, &threadsArr[i], progressiveWorker, (void *) &pass );
+        if( returnCode != 0 )
+        {
+          printf("There was an issue creating threads, and the program must exit.\n");
+          printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+          if(DBG)
+          {
+            printf( "ERROR -> computeImageProgressive(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+          }
+          return false;
+        }
+      }
+
+      for( i=0 ; i<threadsToUse ; i++ )
+      {
+        int joinResult = joinWorker( i, threadsArr[i] );
+        if( DBG && joinResult != 0 )
+        {
+          printf( "ERROR -> computeImageProgressive(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+        }
+      }
+    }
+    else
+    {
+      progressiveWorker( (void *) &pass );
+    }
+
+    if( pass.fillBlocks && !savePreview( bm, PREVIEW_FILE ) )
+    {
+      fprintf(stderr,"mandel: couldn't write the preview to %s: %s\n",PREVIEW_FILE,strerror(errno));
+    }
+
+    if(TIMING)
+    {
+      gettimeofday( &passEnd, NULL );
+      printf( "mandel: progressive pass for every %d pixel(s) done at (in usec): %ld\n", step, elapsedUsec( &renderStart, &passEnd ) );
+    }
+  }
+
+  free(threadsArr);
+  return true;
+} // computeImageProgressive()
+
+/*
+ * function: 
+ *  progressiveWorker
+ * 
+ * description: 
+ *  Entry point for the threads of a progressive pass (and called directly when only one thread is used).
+ *  Takes rows of the pass off of the shared counter and computes the pixels of each row that lie on 
+ *    this pass's grid but not on the previous, coarser one. When previews are being saved, each 
+ *    computed pixel is also copied into the step x step block below and to the right of it; those 
+ *    rows only belong to this row of the pass, so no two threads ever write the same pixel.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type 
+ *    progressivePassParams, which is shared by all the threads of the pass.
+ * 
+ * returns: 
+ *  void *
+ */
+void * progressiveWorker( void * args )
+{
+  struct progressivePassParams * pass = args;
+  int step = pass->step;
+  int width = pass->width;
+  int totalHeight = pass->bmpTotalHeight;
+  int * bmpData = bitmap_data( pass->theBitmap );
+  double tolerance = periodTolerance( pass->xMin, pass->xMax, width );
+
+  // pixels on the grid of the previous pass were computed already, except on the very first pass
+  int previousStep = step < PROGRESSIVE_START_STEP ? step*2 : 0;
+
+  double xs[ROW_CHUNK];
+  double ys[ROW_CHUNK];
+  int columns[ROW_CHUNK];
+  int iters[ROW_CHUNK];
+  float magnitudes[ROW_CHUNK];
+  double orbitX[ROW_CHUNK];
+  double orbitY[ROW_CHUNK];
+  int costs[ROW_CHUNK];
+  int * rawIters = RAW_OUTPUT != NULL ? iterfile_iters(RAW_OUTPUT) : NULL;
+  float * rawMagnitudes = RAW_OUTPUT != NULL ? iterfile_magnitudes(RAW_OUTPUT) : NULL;
+  double * rawOrbitX = RAW_OUTPUT != NULL ? iterfile_orbit_x(RAW_OUTPUT) : NULL;
+  double * rawOrbitY = RAW_OUTPUT != NULL ? iterfile_orbit_y(RAW_OUTPUT) : NULL;
+
+  while( true )
+  {
+    int j = atomic_fetch_add( pass->nextRow, 1 ) * step;
+    if( j >= totalHeight )
+    {
+      break;
+    }
+
+    double y = pass->yMin + j*(pass->yMax-pass->yMin)/totalHeight;
+    bool rowDoneBefore = previousStep > 0 && j % previousStep == 0;
+    int * row = bmpData + (size_t) j * width;
+    int blockHeight = j + step <= totalHeight ? step : totalHeight - j;
+
+    int i = 0;
+    while( i < width )
+    {
+      // gather the next chunk of this row's new pixels
+      int count = 0;
+      for( ; i<width && count<ROW_CHUNK ; i+=step )
+      {
+        if( rowDoneBefore && i % previousStep == 0 )
+        {
+          continue;
+        }
+        columns[count] = i;
+        xs[count] = pass->xMin + i*(pass->xMax-pass->xMin)/width;
+        ys[count] = y;
+        count++;
+      }
+
+      if( count == 0 )
+      {
+        continue;
+      }
+      computePointIters( xs, ys, count, 0, pass->max, tolerance, iters, rawIters != NULL ? magnitudes : NULL,
+        rawOrbitX != NULL ? orbitX : NULL, rawOrbitY != NULL ? orbitY : NULL, COST_MAP != NULL ? costs : NULL );
+
+      int k;
+      for( k=0 ; k<count ; k++ )
+      {
+        int color = iteration_to_color( iters[k], pass->max );
+        row[columns[k]] = color;
+        if( rawIters != NULL )
+        {
+          size_t p = (size_t) j * width + columns[k];
+          rawIters[p] = iters[k];
+          rawMagnitudes[p] = magnitudes[k];
+          if( rawOrbitX != NULL && iters[k] >= pass->max )
+          {
+            rawOrbitX[p] = orbitX[k];
+            rawOrbitY[p] = orbitY[k];
+          }
+        }
+        if( COST_MAP != NULL )
+        {
+          COST_MAP[(size_t) j * width + columns[k]] = costs[k];
+        }
+
+        if( pass->fillBlocks )
+        {
+          int blockWidth = columns[k] + step <= width ? step : width - columns[k];
+          int bi, bj;
+          for( bj=0 ; bj<blockHeight ; bj++ )
+          {
+            int * blockRow = row + (size_t) bj * width + columns[k];
+            for( bi=0 ; bi<blockWidth ; bi++ )
+            {
+              blockRow[bi] = color;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return NULL;
+} // progressiveWorker()
+
+/*
+ * function: 
+ *  savePreview
+ * 
+ * description: 
+ *  Saves the bitmap to a temporary file next to the requested one, then renames it into place, 
+ *    so a program watching the preview never reads a half-written file.
+ * 
+ * parameters:
+ *  struct bitmap * bm: the bitmap to save
+ *  const char * file: where the preview should end up
+ * 
+ * returns: 
+ *  bool: true if the preview was saved, otherwise false
+ */
+static bool savePreview( struct bitmap * bm, const char * file )
+{
+  char tempFile[4096];
+  snprintf( tempFile, sizeof(tempFile), "%s.partial", file );
+
+  if( !bitmap_save( bm, tempFile ) )
+  {
+    return false;
+  }
+
+  return rename( tempFile, file ) == 0;
+} // savePreview()
+
+/*
+ * function: 
+ *  loadResumeState
+ * 
+ * description: 
+ *  Loads the iteration file given with -C and checks that it can be carried on from for this image: 
+ *    it must keep orbits (so it was saved with -I from a double precision render), cover exactly the 
+ *    same pixels and bounds, and not have been iterated further than max already. 
+ *  Anything else is reported and the whole image is computed as usual instead.
+ * 
+ * parameters:
+ *  const char * file: the iteration file to carry on from
+ *  int width: the width of the image in pixels
+ *  int height: the height of the image in pixels
+ *  double xmin: the scaled left-bound of the image on the x-axis
+ *  double xmax: the scaled right-bound of the image on the x-axis
+ *  double ymin: the scaled lower-bound of the image on the y-axis
+ *  double ymax: the scaled upper-bound of the image on the y-axis
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  struct iterfile *: the earlier render to carry on from, or NULL if there isn't a usable one
+ */
+static struct iterfile * loadResumeState( const char * file, int width, int height, double xmin, double xmax, double ymin, double ymax, int max )
+{
+  if( PRECISION != PRECISION_DOUBLE )
+  {
+    printf("mandel: -C only applies to -p double, computing the whole image\n");
+    return NULL;
+  }
+
+  struct iterfile * state = iterfile_load(file);
+  if( state == NULL )
+  {
+    printf("mandel: couldn't read %s, computing the whole image\n", file);
+    return NULL;
+  }
+
+  const char * problem = NULL;
+  double stateXMin, stateXMax, stateYMin, stateYMax;
+  iterfile_bounds( state, &stateXMin, &stateXMax, &stateYMin, &stateYMax );
+  if( iterfile_orbit_x(state) == NULL )
+  {
+    problem = "has no orbits to carry on from";
+  }
+  else if( iterfile_width(state) != width || iterfile_height(state) != height )
+  {
+    problem = "is a different size";
+  }
+  else if( stateXMin != xmin || stateXMax != xmax || stateYMin != ymin || stateYMax != ymax )
+  {
+    problem = "is of a different part of the set";
+  }
+  else if( iterfile_max(state) > max )
+  {
+    problem = "was iterated further than -m already";
+  }
+
+  if( problem != NULL )
+  {
+    printf("mandel: %s %s, computing the whole image\n", file, problem);
+    iterfile_delete(state);
+    return NULL;
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: loadResumeState(): carrying on from %s, which was computed up to %d iterations\n", file, iterfile_max(state) );
+  }
+  return state;
+} // loadResumeState()
+
+/*
+ * function: 
+ *  computeImageResumed
+ * 
+ * description: 
+ *  Called by main() instead of renderFrame() when -C gives an iteration file (saved with -I by an 
+ *    earlier render of the same image at a lower max) to carry on from.
+ *  Pixels that escaped in the earlier render keep their counts, pixels it knew would never escape 
+ *    go straight to the new max, and only the rest are iterated: from the z they were left at, 
+ *    or from the start if their z wasn't kept (pixels the mariani scheduler filled in, for one). 
+ *  The iteration file is brought up to the new max along the way, so it can be saved again with -I 
+ *    and carried on from once more. The pixels to iterate are handed out to the threads ROW_CHUNK 
+ *    at a time from a shared counter, so they still fill the SIMD lanes.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the pointer to the space allocated for the bitmap
+ *  struct iterfile * state: the earlier render, already checked against this image
+ *  double xmin: the scaled left-bound of the requested image on the x-axis
+ *  double xmax: the scaled right-bound of the requested image on the x-axis
+ *  double ymin: the scaled lower-bound of the requested image on the y-axis
+ *  double ymax: the scaled upper-bound of the requested image on the y-axis
+ *  int max: max # of recurrence relations to iterate, at least the max of the earlier render
+ *  int threadsToUse: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors during computation, otherwise false
+ */
+static bool computeImageResumed( struct bitmap *bm, struct iterfile * state, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
+{
+  size_t size = (size_t) bitmap_width(bm) * bitmap_height(bm);
+  int * iters = iterfile_iters(state);
+  double * orbitX = iterfile_orbit_x(state);
+  int previousMax = iterfile_max(state);
+
+  // sort out which pixels still need iterating: those with a z to carry on from go first, then those starting over
+  long carriedOn = 0;
+  long startedOver = 0;
+  size_t p;
+  for( p=0 ; p<size ; p++ )
+  {
+    if( iters[p] >= previousMax && !isnan( orbitX[p] ) )
+    {
+      if( isinf( orbitX[p] ) )
+      {
+        startedOver++;
+      }
+      else
+      {
+        carriedOn++;
+      }
+    }
+  }
+
+  int * points = (int *) malloc( ( carriedOn + startedOver + 1 ) * sizeof(int) );
+  pthread_t * threadsArr = (pthread_t *) calloc( threadsToUse, sizeof(pthread_t) );
+  if( points == NULL || threadsArr == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> computeImageResumed(): allocating the pixel list or threadsArr failed\n");
+    }
+    free(points);
+    free(threadsArr);
+    return false;
+  }
+
+  long carriedOnNext = 0;
+  long startedOverNext = carriedOn;
+  for( p=0 ; p<size ; p++ )
+  {
+    if( iters[p] < previousMax )
+    {
+      continue;
+    }
+    if( isnan( orbitX[p] ) )
+    {
+      iters[p] = max;
+    }
+    else if( isinf( orbitX[p] ) )
+    {
+      points[startedOverNext++] = (int) p;
+    }
+    else
+    {
+      points[carriedOnNext++] = (int) p;
+    }
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: computeImageResumed(): carrying on %ld pixels from %d iterations and starting %ld over, of %ld\n", 
+      carriedOn, previousMax, startedOver, (long) size );
+  }
+
+  atomic_long nextChunk;
+  atomic_init( &nextChunk, 0 );
+
+  struct resumeParams resume;
+  resume.theState = state;
+  resume.points = points;
+  resume.carriedOn = carriedOn;
+  resume.pointCount = carriedOn + startedOver;
+  resume.start = previousMax;
+  resume.xMin = xmin;
+  resume.xMax = xmax;
+  resume.yMin = ymin;
+  resume.yMax = ymax;
+  resume.max = max;
+  resume.width = bitmap_width(bm);
+  resume.bmpTotalHeight = bitmap_height(bm);
+  resume.nextChunk = &nextChunk;
+
+  if( threadsToUse > 1 )
+  {
+    int i;
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int returnCode = spawnWorker( i, &threadsArr[i], resumeWorker, (void *) &resume );
+      if( returnCode != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+        if(DBG)
+        {
+          printf( "ERROR -> computeImageResumed(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+        }
+        return false;
+      }
+    }
+
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int joinResult = joinWorker( i, threadsArr[i] );
+      if( DBG && joinResult != 0 )
+      {
+        printf( "ERROR -> computeImageResumed(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+      }
+    }
+  }
+  else
+  {
+    resumeWorker( (void *) &resume );
+  }
+
+  // every count is final now, so color the whole image from them
+  iterfile_set_max( state, max );
+  int * bmpData = bitmap_data(bm);
+  for( p=0 ; p<size ; p++ )
+  {
+    bmpData[p] = iteration_to_color( iters[p], max );
+  }
+
+  if(TIMING)
+  {
+    printf( "mandel: pixels carried on from the iteration file: %ld, started over: %ld, of %ld\n", carriedOn, startedOver, (long) size );
+  }
+
+  free(points);
+  free(threadsArr);
+  return true;
+} // computeImageResumed()
+
+/*
+ * function: 
+ *  resumeWorker
+ * 
+ * description: 
+ *  Entry point for the threads of a resumed render (and called directly when only one thread is used).
+ *  Takes chunks of up to ROW_CHUNK pixels off of the shared counter, carries on iterating them from 
+ *    the iteration file (or from the start), and writes the new counts, magnitudes and orbits back to it.
+ *  A chunk never mixes carried-on pixels with ones starting over, since the kernel takes one start for all of them.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type 
+ *    resumeParams, which is shared by all the threads.
+ * 
+ * returns: 
+ *  void *
+ */
+void * resumeWorker( void * args )
+{
+  struct resumeParams * resume = args;
+  int width = resume->width;
+  int * rawIters = iterfile_iters( resume->theState );
+  float * rawMagnitudes = iterfile_magnitudes( resume->theState );
+  double * rawOrbitX = iterfile_orbit_x( resume->theState );
+  double * rawOrbitY = iterfile_orbit_y( resume->theState );
+  double tolerance = periodTolerance( resume->xMin, resume->xMax, width );
+  long carriedOnChunks = ( resume->carriedOn + ROW_CHUNK - 1 ) / ROW_CHUNK;
+
+  double xs[ROW_CHUNK];
+  double ys[ROW_CHUNK];
+  int iters[ROW_CHUNK];
+  float magnitudes[ROW_CHUNK];
+  double orbitX[ROW_CHUNK];
+  double orbitY[ROW_CHUNK];
+  int costs[ROW_CHUNK];
+
+  while( true )
+  {
+    long chunk = atomic_fetch_add( resume->nextChunk, 1 );
+    long first, last;
+    int start;
+    if( chunk < carriedOnChunks )
+    {
+      first = chunk * ROW_CHUNK;
+      last = first + ROW_CHUNK < resume->carriedOn ? first + ROW_CHUNK : resume->carriedOn;
+      start = resume->start;
+    }
+    else
+    {
+      first = resume->carriedOn + ( chunk - carriedOnChunks ) * ROW_CHUNK;
+      last = first + ROW_CHUNK < resume->pointCount ? first + ROW_CHUNK : resume->pointCount;
+      start = 0;
+    }
+    if( first >= last )
+    {
+      break;
+    }
+
+    int count = (int) ( last - first );
+    int k;
+    for( k=0 ; k<count ; k++ )
+    {
+      int p = resume->points[first+k];
+      int i = p % width;
+      int j = p / width;
+      xs[k] = resume->xMin + i*(resume->xMax-resume->xMin)/width;
+      ys[k] = resume->yMin + j*(resume->yMax-resume->yMin)/resume->bmpTotalHeight;
+      orbitX[k] = rawOrbitX[p];
+      orbitY[k] = rawOrbitY[p];
+    }
+
+    computePointIters( xs, ys, count, start, resume->max, tolerance, iters, magnitudes, orbitX, orbitY, COST_MAP != NULL ? costs : NULL );
+
+    for( k=0 ; k<count ; k++ )
+    {
+      int p = resume->points[first+k];
+      rawIters[p] = iters[k];
+      rawMagnitudes[p] = magnitudes[k];
+      if( iters[k] >= resume->max )
+      {
+        rawOrbitX[p] = orbitX[k];
+        rawOrbitY[p] = orbitY[k];
+      }
+      if( COST_MAP != NULL )
+      {
+        COST_MAP[p] = costs[k];
+      }
+    }
+  }
+
+  return NULL;
+} // resumeWorker()
+
+/*
+ * function: 
+ *  computeImageStreamed
+ * 
+ * description: 
+ *  Called by computeImage() when the image is being written into STREAM_FILE while it's computed, 
+ *    either because it's streamed with -B or because writing was asked to overlap computing with -O.
+ *  The rows are handed out to the threads one at a time from a shared counter, top to bottom, and the 
+ *    image is written a band of rows at a time by a writer thread of its own: as soon as every row of 
+ *    a band is done, the writer converts it and writes it to its place in the file while the threads 
+ *    carry on with the next bands, so the disk and the cores are kept busy at the same time.
+ *  With -B, bm only holds one band of STREAM_ROWS rows, and a second band is allocated here so one can be 
+ *    computed while the other is written. A thread about to start on a band whose buffer is still being 
+ *    written waits for the writer, so at most two bands are ever in memory. With -O, bm holds the whole 
+ *    image, every band already has a place of its own, and the bands are PIPELINE_ROWS rows.
+ *  Every row gets exactly the same y coordinate it would have in a whole-image render, so the file 
+ *    comes out byte-for-byte the same as bitmap_save() would have written.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the bitmap holding the whole image, or the first band buffer when streaming
+ *  double xmin: the scaled left-bound of the requested image on the x-axis
+ *  double xmax: the scaled right-bound of the requested image on the x-axis
+ *  double ymin: the scaled lower-bound of the requested image on the y-axis
+ *  double ymax: the scaled upper-bound of the requested image on the y-axis
+ *  int max: max # of recurrence relations to iterate
+ *  int threadsToUse: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors during computation, otherwise false
+ */
+static bool computeImageStreamed( struct bitmap *bm, double xmin, double xmax, double ymin, double ymax, int max, int threadsToUse )
+{
+  struct streamParams stream;
+  stream.width = bitmap_width(bm);
+  stream.bmpTotalHeight = STREAM_HEIGHT;
+  stream.wholeImage = bitmap_height(bm) >= STREAM_HEIGHT;
+  stream.bandRows = stream.wholeImage ? PIPELINE_ROWS : bitmap_height(bm);
+  if( stream.wholeImage && STREAM_ROWS > 0 )
+  {
+    stream.bandRows = STREAM_ROWS;
+  }
+  stream.bandCount = ( stream.bmpTotalHeight + stream.bandRows - 1 ) / stream.bandRows;
+  stream.bands[0] = bm;
+  stream.bands[1] = stream.wholeImage ? bm : bitmap_create( stream.width, stream.bandRows );
+  stream.xMin = xmin;
+  stream.xMax = xmax;
+  stream.yMin = ymin;
+  stream.yMax = ymax;
+  stream.max = max;
+  stream.bandsWritten = 0;
+  stream.writeFailed = false;
+  stream.writeErrno = 0;
+  stream.writeUsec = 0;
+  atomic_init( &stream.nextRow, 0 );
+  atomic_init( &stream.waitUsec, 0 );
+
+  stream.bandRowsDone = (atomic_int *) calloc( stream.bandCount, sizeof(atomic_int) );
+  pthread_t * threadsArr = (pthread_t *) calloc( threadsToUse, sizeof(pthread_t) );
+  if( stream.bands[1] == NULL || stream.bandRowsDone == NULL || threadsArr == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> computeImageStreamed(): allocating the second band, the band counters or threadsArr failed\n");
+    }
+    if( !stream.wholeImage && stream.bands[1] != NULL )
+    {
+      bitmap_delete( stream.bands[1] );
+    }
+    free(stream.bandRowsDone);
+    free(threadsArr);
+    return false;
+  }
+
+  int k;
+  for( k=0 ; k<stream.bandCount ; k++ )
+  {
+    atomic_init( &stream.bandRowsDone[k], 0 );
+  }
+  pthread_mutex_init( &stream.lock, NULL );
+  pthread_cond_init( &stream.changed, NULL );
+
+  // the writer is a thread of its own rather than one of the pool's, since it runs alongside all of them
+  pthread_t writer;
+  int returnCode = pthread_create( &writer, NULL, streamWriter, (void *) &stream );
+  if( returnCode != 0 )
+  {
+    printf("There was an issue creating threads, and the program must exit.\n");
+    printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+    if(DBG)
+    {
+      printf( "ERROR -> computeImageStreamed(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+    }
+    return false;
+  }
+
+  if( threadsToUse > 1 )
+  {
+    int i;
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      returnCode = spawnWorker( i, &threadsArr[i], streamWorker, (void *) &stream );
+      if( returnCode != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+        if(DBG)
+        {
+          printf( "ERROR -> computeImageStreamed(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+        }
+        return false;
+      }
+    }
+
+    for( i=0 ; i<threadsToUse ; i++ )
+    {
+      int joinResult = joinWorker( i, threadsArr[i] );
+      if( DBG && joinResult != 0 )
+      {
+        printf( "ERROR -> computeImageStreamed(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+      }
+    }
+  }
+  else
+  {
+    streamWorker( (void *) &stream );
+  }
+
+  // every band is done, so the writer stops once it has written the last one
+  pthread_join( writer, NULL );
+
+  if( stream.writeFailed )
+  {
+    fprintf(stderr,"mandel: couldn't write the image: %s\n",strerror(stream.writeErrno));
+  }
+
+  if(TIMING)
+  {
+    printf( "mandel: wrote %d bands of up to %d rows while computing, time spent writing (in usec): %ld, threads waiting on the writer (in usec): %ld\n", 
+      stream.bandCount, stream.bandRows, stream.writeUsec, atomic_load( &stream.waitUsec ) );
+  }
+
+  pthread_mutex_destroy( &stream.lock );
+  pthread_cond_destroy( &stream.changed );
+  if( !stream.wholeImage )
+  {
+    bitmap_delete( stream.bands[1] );
+  }
+  free(stream.bandRowsDone);
+  free(threadsArr);
+  return !stream.writeFailed;
+} // computeImageStreamed()
+
+/*
+ * function: 
+ *  streamWorker
+ * 
+ * description: 
+ *  Entry point for the threads computing a streamed image (and called directly when only one thread is used).
+ *  Takes rows off of the shared counter and computes each one into its band, with the y coordinate of 
+ *    the row's place in the whole image. When streaming with -B, a row whose band buffer still holds the 
+ *    band before last waits until the writer is done with it. The thread finishing the last row of a 
+ *    band wakes the writer up.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type 
+ *    streamParams, which is shared by all the threads and the writer.
+ * 
+ * returns: 
+ *  void *
+ */
+void * streamWorker( void * args )
+{
+  struct streamParams * stream = args;
+
+  while( true )
+  {
+    int j = atomic_fetch_add( &stream->nextRow, 1 );
+    if( j >= stream->bmpTotalHeight )
+    {
+      break;
+    }
+
+    int band = j / stream->bandRows;
+    int bandFirstRow = band * stream->bandRows;
+    int bandRows = bandFirstRow + stream->bandRows <= stream->bmpTotalHeight ? stream->bandRows : stream->bmpTotalHeight - bandFirstRow;
+
+    // the buffer this band goes into has to have been written out first
+    if( !stream->wholeImage && band >= 2 )
+    {
+      pthread_mutex_lock( &stream->lock );
+      if( stream->bandsWritten < band-1 && !stream->writeFailed )
+      {
+        struct timeval waitStart;
+        struct timeval waitEnd;
+        gettimeofday( &waitStart, NULL );
+        while( stream->bandsWritten < band-1 && !stream->writeFailed )
+        {
+          pthread_cond_wait( &stream->changed, &stream->lock );
+        }
+        gettimeofday( &waitEnd, NULL );
+        atomic_fetch_add( &stream->waitUsec, elapsedUsec( &waitStart, &waitEnd ) );
+      }
+      pthread_mutex_unlock( &stream->lock );
+    }
+
+    double y = stream->yMin + j*(stream->yMax-stream->yMin)/stream->bmpTotalHeight;
+    if( stream->wholeImage )
+    {
+      computeRow( stream->bands[0], j, 0, stream->width, stream->xMin, stream->xMax, stream->width, y, stream->max, RAW_OUTPUT, false );
+    }
+    else
+    {
+      computeRow( stream->bands[band%2], j-bandFirstRow, 0, stream->width, stream->xMin, stream->xMax, stream->width, y, stream->max, RAW_OUTPUT, false );
+    }
+
+    if( atomic_fetch_add( &stream->bandRowsDone[band], 1 ) + 1 == bandRows )
+    {
+      pthread_mutex_lock( &stream->lock );
+      pthread_cond_broadcast( &stream->changed );
+      pthread_mutex_unlock( &stream->lock );
+    }
+  }
+
+  return NULL;
+} // streamWorker()
+
+/*
+ * function: 
+ *  streamWriter
+ * 
+ * description: 
+ *  The writer thread of a streamed image. Waits for each band to be finished, in order from the top, 
+ *    and writes it to its place in STREAM_FILE, waking up any thread waiting for its buffer afterwards.
+ *  If a write fails, the error is kept in the stream and the writer stops; any waiting threads carry on 
+ *    without it so the image can be abandoned cleanly.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type streamParams.
+ * 
+ * returns: 
+ *  void *
+ */
+void * streamWriter( void * args )
+{
+  struct streamParams * stream = args;
+
+  int band;
+  for( band=0 ; band<stream->bandCount ; band++ )
+  {
+    int bandFirstRow = band * stream->bandRows;
+    int bandRows = bandFirstRow + stream->bandRows <= stream->bmpTotalHeight ? stream->bandRows : stream->bmpTotalHeight - bandFirstRow;
+
+    pthread_mutex_lock( &stream->lock );
+    while( atomic_load( &stream->bandRowsDone[band] ) < bandRows )
+    {
+      pthread_cond_wait( &stream->changed, &stream->lock );
+    }
+    pthread_mutex_unlock( &stream->lock );
+
+    const int * rows = stream->wholeImage ? bitmap_data( stream->bands[0] ) + (size_t) bandFirstRow * stream->width : bitmap_data( stream->bands[band%2] );
+
+    struct timeval writeStart;
+    struct timeval writeEnd;
+    gettimeofday( &writeStart, NULL );
+    bool written = bitmap_stream_write( STREAM_FILE, bandFirstRow, bandRows, rows );
+    int writeErrno = errno;
+    gettimeofday( &writeEnd, NULL );
+    stream->writeUsec += elapsedUsec( &writeStart, &writeEnd );
+
+    if(DBG)
+    {
+      printf( "DEBUG: streamWriter(): rows %d to %d %s\n", bandFirstRow, bandFirstRow+bandRows-1, written ? "written" : "failed" );
+    }
+
+    pthread_mutex_lock( &stream->lock );
+    if( written )
+    {
+      stream->bandsWritten++;
+    }
+    else
+    {
+      stream->writeFailed = true;
+      stream->writeErrno = writeErrno;
+    }
+    pthread_cond_broadcast( &stream->changed );
+    pthread_mutex_unlock( &stream->lock );
+
+    if( !written )
+    {
+      break;
+    }
+  }
+
+  return NULL;
+} // streamWriter()
+
+/*
+ * function: 
+ *  renderFrame
+ * 
+ * description: 
+ *  Computes one image centered on xcenter,ycenter with the arithmetic in PRECISION, by pointing
+ *    computeImage() at the right bounds and escape-time kernel for it.
+ *  For perturbation the reference orbit is only computed the first time, since every frame of a
+ *    series shares the same center and max. The kernel and the -c/-P checks are put back afterwards 
+ *    with restoreRenderOptions(), so the next frame of a series can use a different arithmetic.
+ * 
+ * parameters:
+ *  struct bitmap * bm: the bitmap to render into
+ *  double xcenter: the x coordinate of the image center
+ *  double ycenter: the y coordinate of the image center
+ *  const char * xcenterText: the x coordinate exactly as typed
+ *  const char * ycenterText: the y coordinate exactly as typed
+ *  double scale: the distance from the center to the edges of the image
+ *  int max: max # of recurrence relations to iterate
+ *  int numThreads: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if there were no catastrophic errors during computation, otherwise false
+ */
+static bool renderFrame( struct bitmap * bm, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, double scale, int max, int numThreads )
+{
+  if( PRECISION == PRECISION_DOUBLE )
+  {
+    return computeImage(bm,xcenter-scale,xcenter+scale,ycenter-scale,ycenter+scale,max,numThreads);
+  }
+
+  // single precision iterates the same absolute coordinates, just with twice the pixels per vector
+  struct renderOptions saved;
+  saveRenderOptions( &saved );
+  if( PRECISION == PRECISION_FLOAT )
+  {
+    ESCAPE_KERNEL = FLOAT_KERNEL;
+    ESCAPE_KERNEL_NAME = FLOAT_KERNEL_NAME;
+    bool imageComputed = computeImage(bm,xcenter-scale,xcenter+scale,ycenter-scale,ycenter+scale,max,numThreads);
+    restoreRenderOptions( &saved );
+    return imageComputed;
+  }
+
+  // the double-double and perturbation kernels work on offsets from the image center, which the -c and -P checks don't understand
+  INTERIOR_CHECK = false;
+  PERIODICITY_CHECK = false;
+
+  bool imageComputed = true;
+  if( PRECISION == PRECISION_PERTURB )
+  {
+    // iterate the center in high precision, then render every pixel as an offset from it
+    if( REFERENCE_ORBIT.x == NULL )
+    {
+      imageComputed = computeReferenceOrbit(xcenterText,ycenterText,max);
+    }
+    ESCAPE_KERNEL = escapeTimePerturbation;
+    ESCAPE_KERNEL_NAME = "perturbation";
+  }
+  else
+  {
+    // the pixels are offsets from the center here as well, which gets added back in double-double
+    setDoubleDoubleCenter(xcenterText,ycenterText);
+    ESCAPE_KERNEL = escapeTimeDoubleDouble;
+    ESCAPE_KERNEL_NAME = "double-double";
+  }
+
+  if( imageComputed )
+  {
+    imageComputed = computeImage(bm,-scale,scale,-scale,scale,max,numThreads);
+  }
+
+  restoreRenderOptions( &saved );
+  return imageComputed;
+} // renderFrame()
+
+/*
+ * function: 
+ *  renderCached
+ * 
+ * description: 
+ *  Renders one image the same way renderFrame() does, but through the -k cache.
+ *  On a hit the image is colored from the cached iteration counts, without computing anything. 
+ *  On a miss it's rendered by renderFrame() with the counts gathered in RAW_OUTPUT, the same way -I does, 
+ *    and they're put in the cache afterwards.
+ * 
+ * parameters:
+ *  struct bitmap * bm: the bitmap to render into
+ *  double xcenter: the x coordinate of the image center
+ *  double ycenter: the y coordinate of the image center
+ *  const char * xcenterText: the x coordinate exactly as typed
+ *  const char * ycenterText: the y coordinate exactly as typed
+ *  double scale: the distance from the center to the edges of the image
+ *  int max: max # of recurrence relations to iterate
+ *  int numThreads: the number of threads to perform the computation
+ *  bool * hit: receives whether the image came from the cache
+ * 
+ * returns: 
+ *  bool: true if the image was colored or computed, otherwise false
+ */
+static bool renderCached( struct bitmap * bm, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, 
+  double scale, int max, int numThreads, bool * hit )
+{
+  int width = bitmap_width(bm);
+  int height = bitmap_height(bm);
+  char key[CACHE_KEY_LENGTH];
+  cacheKey( key, PRECISION, xcenter, ycenter, xcenterText, ycenterText, scale, width, height, max );
+
+  struct iterfile * cached = lookupCachedImage( key, width, height, max );
+  *hit = cached != NULL;
+  if( cached != NULL )
+  {
+    colorCachedImage( bm, cached, max );
+    iterfile_delete(cached);
+    return true;
+  }
+
+  RAW_OUTPUT = iterfile_create( width, height, max );
+  if( RAW_OUTPUT == NULL )
+  {
+    if(DBG)
+    {
+      printf( "DEBUG: renderCached(): iterfile_create() returned NULL, rendering the image without caching it\n" );
+    }
+    return renderFrame(bm,xcenter,ycenter,xcenterText,ycenterText,scale,max,numThreads);
+  }
+
+  bool imageComputed = renderFrame(bm,xcenter,ycenter,xcenterText,ycenterText,scale,max,numThreads);
+  if( imageComputed )
+  {
+    storeCachedImage( key, RAW_OUTPUT );
+  }
+  iterfile_delete(RAW_OUTPUT);
+  RAW_OUTPUT = NULL;
+  return imageComputed;
+} // renderCached()
+
+/*
+ * function: 
+ *  lookupCachedImage
+ * 
+ * description: 
+ *  Gets the iteration counts of an image out of the -k cache. Safe to call from any thread: 
+ *    the cache is only used under cacheMutex.
+ * 
+ * parameters:
+ *  const char * key: the image's key, from cacheKey()
+ *  int width: the width of the image in pixels
+ *  int height: the height of the image in pixels
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  struct iterfile *: the counts, to be freed with iterfile_delete(), or NULL if the image isn't cached
+ */
+static struct iterfile * lookupCachedImage( const char * key, int width, int height, int max )
+{
+  pthread_mutex_lock( &cacheMutex );
+  struct iterfile * cached = imagecache_get( CACHE, key, width, height, max );
+  pthread_mutex_unlock( &cacheMutex );
+
+  if(DBG)
+  {
+    if( cached != NULL )
+    {
+      printf( "DEBUG: lookupCachedImage(): coloring the image from %s/%s.iter\n", CACHE_DIR, key );
+    }
+    else
+    {
+      printf( "DEBUG: lookupCachedImage(): %s isn't cached, rendering it\n", key );
+    }
+  }
+  return cached;
+} // lookupCachedImage()
+
+/*
+ * function: 
+ *  storeCachedImage
+ * 
+ * description: 
+ *  Puts the iteration counts of a rendered image in the -k cache, under cacheMutex like lookupCachedImage(). 
+ *    Not being able to put them there is only worth a warning, since the image itself is fine.
+ * 
+ * parameters:
+ *  const char * key: the image's key, from cacheKey()
+ *  struct iterfile * counts: the image's iteration counts
+ * 
+ * returns: 
+ *  void
+ */
+static void storeCachedImage( const char * key, struct iterfile * counts )
+{
+  pthread_mutex_lock( &cacheMutex );
+  bool stored = imagecache_put( CACHE, key, counts );
+  int storeErrno = errno;
+  pthread_mutex_unlock( &cacheMutex );
+
+  if( !stored )
+  {
+    fprintf(stderr,"mandel: couldn't put the image in the cache in %s: %s\n",CACHE_DIR,strerror(storeErrno));
+  }
+} // storeCachedImage()
+
+/*
+ * function: 
+ *  colorCachedImage
+ * 
+ * description: 
+ *  Colors a whole image from its cached iteration counts, the same colors computeRow() gives them.
+ * 
+ * parameters:
+ *  struct bitmap * bm: the bitmap to color, the same size as the counts
+ *  struct iterfile * counts: the image's iteration counts
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  void
+ */
+static void colorCachedImage( struct bitmap * bm, struct iterfile * counts, int max )
+{
+  int * iters = iterfile_iters(counts);
+  int * data = bitmap_data(bm);
+  size_t pixels = (size_t) bitmap_width(bm) * bitmap_height(bm);
+  size_t pixel;
+  for( pixel=0 ; pixel<pixels ; pixel++ )
+  {
+    data[pixel] = iteration_to_color( iters[pixel], max );
+  }
+} // colorCachedImage()
+
+/*
+ * function: 
+ *  closeCache
+ * 
+ * description: 
+ *  Prints how the -k cache did in this run, and over every run that used it for sizing it, and closes it.
+ *    Does nothing if there's no cache open.
+ * 
+ * parameters:
+ *  const char * outcome: how this run's lookups went, or NULL to print its hits and misses
+ * 
+ * returns: 
+ *  void
+ */
+static void closeCache( const char * outcome )
+{
+  if( CACHE == NULL )
+  {
+    return;
+  }
+
+  struct imagecache_stats run;
+  struct imagecache_stats total;
+  imagecache_stats( CACHE, &run, &total );
+  char counted[64];
+  if( outcome == NULL )
+  {
+    snprintf( counted, sizeof(counted), "%lld hits, %lld misses", run.hits, run.misses );
+    outcome = counted;
+  }
+  long long lookups = total.hits + total.misses;
+  printf( "mandel: cache: %s, %lld evicted, %lld images taking %lld of %lld bytes in %s\n", outcome, 
+    run.evictions, run.entries, run.bytes, CACHE_LIMIT, CACHE_DIR );
+  printf( "mandel: cache totals: %lld hits, %lld misses (%.1f%% hit rate), %lld evictions\n", total.hits, total.misses, 
+    lookups > 0 ? total.hits * 100.0 / lookups : 0.0, total.evictions );
+  imagecache_close( CACHE );
+  CACHE = NULL;
+} // closeCache()
+
+/*
+ * function: 
+ *  cacheKey
+ * 
+ * description: 
+ *  Works out the -k cache key of an image from everything that decides its iteration counts: its bounds, 
+ *    size and max, the arithmetic and escape-time kernel that will compute it, the -c and -P checks and 
+ *    CACHE_KERNEL_VERSION. The double-double and perturbation kernels work from the center as typed rather 
+ *    than the bounds, so for those the center text goes in as well, and the checks don't, since renderFrame() 
+ *    switches them off for those kernels.
+ *  The key is two 64-bit FNV-1a hashes of all that, started from different values, as 32 hex digits. 
+ *    The bounds are written out in hex floating point, so they're hashed exactly.
+ * 
+ * parameters:
+ *  char * key: receives the key, CACHE_KEY_LENGTH chars including the terminator
+ *  enum precisionType precision: the arithmetic the image is rendered with, not PRECISION_AUTO
+ *  double xcenter: the x coordinate of the image center
+ *  double ycenter: the y coordinate of the image center
+ *  const char * xcenterText: the x coordinate exactly as typed
+ *  const char * ycenterText: the y coordinate exactly as typed
+ *  double scale: the distance from the center to the edges of the image
+ *  int width: the width of the image in pixels
+ *  int height: the height of the image in pixels
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  void
+ */
+static void cacheKey( char * key, enum precisionType precision, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, 
+  double scale, int width, int height, int max )
+{
+  bool offsets = precision == PRECISION_DOUBLEDOUBLE || precision == PRECISION_PERTURB;
+  const char * kernel = offsets ? PRECISION_NAMES[precision] : precision == PRECISION_FLOAT ? FLOAT_KERNEL_NAME : ESCAPE_KERNEL_NAME;
+
+  char description[256];
+  snprintf( description, sizeof(description), "%d %s %s %d %d %d %a %a %a %a %d %d", CACHE_KERNEL_VERSION, PRECISION_NAMES[precision], 
+    kernel, width, height, max, xcenter-scale, xcenter+scale, ycenter-scale, ycenter+scale, INTERIOR_CHECK && !offsets, PERIODICITY_CHECK && !offsets );
+
+  uint64_t hashes[2] = { 14695981039346656037ULL, 0x9e3779b97f4a7c15ULL };
+  int h;
+  for( h=0 ; h<2 ; h++ )
+  {
+    hashes[h] = hashText( hashes[h], description );
+    if( offsets )
+    {
+      hashes[h] = hashText( hashes[h], " " );
+      hashes[h] = hashText( hashes[h], xcenterText );
+      hashes[h] = hashText( hashes[h], " " );
+      hashes[h] = hashText( hashes[h], ycenterText );
+    }
+  }
+
+  snprintf( key, CACHE_KEY_LENGTH, "%016llx%016llx", (unsigned long long) hashes[0], (unsigned long long) hashes[1] );
+
+  if(DBG)
+  {
+    printf( "DEBUG: cacheKey(): %s%s%s%s%s -> %s\n", description, offsets ? " " : "", offsets ? xcenterText : "", 
+      offsets ? " " : "", offsets ? ycenterText : "", key );
+  }
+} // cacheKey()
+
+/*
+ * function: 
+ *  hashText
+ * 
+ * description: 
+ *  carries a 64-bit FNV-1a hash on over the bytes of a string
+ * 
+ * parameters:
+ *  uint64_t hash: the hash so far
+ *  const char * text: the string to hash
+ * 
+ * returns: 
+ *  uint64_t: the hash with text added
+ */
+static uint64_t hashText( uint64_t hash, const char * text )
+{
+  for( ; *text != '\0' ; text++ )
+  {
+    hash ^= (unsigned char) *text;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+} // hashText()
+
+/*
+ * function: 
+ *  renderSeries
+ * 
+ * description: 
+ *  Renders the -Z zoom series in this process: the same zoom path mandelseries takes by running
+ *    mandel once per frame, from a scale of SERIES_START_SCALE down to finalScale in equal steps, 
+ *    the last frame being exactly the image mandel -s finalScale renders. The scales are worked out 
+ *    in double here, while mandelseries works them out in float and passes them on with 6 decimal 
+ *    places, so the deeper frames aren't pixel for pixel the same as its frames.
+ *  The threads are started once in WORKER_POOL and reused by every frame. Two bitmaps are allocated
+ *    up front and take turns: while one frame is computed into one of them, the frame before it
+ *    is saved from the other by a background thread, so the saves overlap the computing.
+ *  With PRECISION_AUTO the arithmetic is picked again for every frame.
+ * 
+ * parameters:
+ *  const char * outfile: the output file name, which gets the frame number added before its extension
+ *  double xcenter: the x coordinate of the image center
+ *  double ycenter: the y coordinate of the image center
+ *  const char * xcenterText: the x coordinate exactly as typed
+ *  const char * ycenterText: the y coordinate exactly as typed
+ *  double finalScale: the scale of the last frame
+ *  int width: the width of the frames in pixels
+ *  int height: the height of the frames in pixels
+ *  int max: max # of recurrence relations to iterate
+ *  int numThreads: the number of threads to perform the computation
+ *  long * mismatches: with -V, receives the number of pixels that differ from the exhaustive render over all frames
+ * 
+ * returns: 
+ *  bool: true if every frame was computed and saved, otherwise false
+ */
+static bool renderSeries( const char * outfile, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, double finalScale, 
+  int width, int height, int max, int numThreads, long * mismatches )
+{
+  struct timeval seriesStart;
+  struct timeval frameStart;
+  struct timeval frameEnd;
+  gettimeofday( &seriesStart, NULL );
+
+  enum precisionType requestedPrecision = PRECISION;
+  double scaleStep = SERIES_FRAMES > 1 ? ( SERIES_START_SCALE - finalScale ) / ( SERIES_FRAMES - 1 ) : 0;
+
+  struct bitmap * frames[2];
+  frames[0] = bitmap_create( width, height );
+  frames[1] = bitmap_create( width, height );
+  if( frames[0] == NULL || frames[1] == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> renderSeries(): bitmap_create() for the frame bitmaps returned NULL\n");
+    }
+    if( frames[0] != NULL )
+    {
+      bitmap_delete( frames[0] );
+    }
+    if( frames[1] != NULL )
+    {
+      bitmap_delete( frames[1] );
+    }
+    return false;
+  }
+
+  if( numThreads > 1 && !startWorkerPool( numThreads ) )
+  {
+    printf("There was an issue creating threads, and the program must exit.\n");
+    printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+    bitmap_delete( frames[0] );
+    bitmap_delete( frames[1] );
+    return false;
+  }
+
+  char frameNames[2][4096];
+  struct frameSave saves[2];
+  pthread_t saver;
+  int savingSlot = -1;
+  bool success = true;
+  *mismatches = 0;
+
+  int frame;
+  for( frame=0 ; frame<SERIES_FRAMES && success ; frame++ )
+  {
+    int slot = frame % 2;
+    // the last frame is the view -s asked for, not wherever the steps' rounding ends up
+    double scale = frame < SERIES_FRAMES - 1 ? SERIES_START_SCALE - frame * scaleStep : finalScale;
+
+    PRECISION = requestedPrecision;
+    if( PRECISION == PRECISION_AUTO )
+    {
+      PRECISION = selectPrecision( xcenter, ycenter, scale, width, height, max );
+    }
+
+    seriesFrameName( frameNames[slot], sizeof(frameNames[slot]), outfile, frame+1 );
+    if( PREVIEW_FILE != NULL )
+    {
+      PREVIEW_FILE = frameNames[slot];
+    }
+
+    if(DBG)
+    {
+      printf( "DEBUG: renderSeries(): frame %d: scale=%g precision=%s outfile=%s\n", frame+1, scale, PRECISION_NAMES[PRECISION], frameNames[slot] );
+    }
+
+    // Fill it with green, for debugging
+    bitmap_reset( frames[slot], MAKE_RGBA(0,255,0,0) );
+
+    gettimeofday( &frameStart, NULL );
+    if( !renderFrame( frames[slot], xcenter, ycenter, xcenterText, ycenterText, scale, max, numThreads ) )
+    {
+      if(DBG)
+      {
+        printf( "ERROR -> renderSeries(): renderFrame() returned false for frame %d...\n", frame+1 );
+      }
+      success = false;
+      break;
+    }
+    gettimeofday( &frameEnd, NULL );
+
+    if(TIMING)
+    {
+      printf( "mandel: frame %d of %d (scale=%g, %s) computed in (in usec): %ld\n", frame+1, SERIES_FRAMES, scale,
+        PRECISION_NAMES[PRECISION], elapsedUsec( &frameStart, &frameEnd ) );
+    }
+
+    if(VERIFY)
+    {
+      long frameMismatches = verifyImage( frames[slot], xcenter, ycenter, xcenterText, ycenterText, scale, max, numThreads );
+      if( frameMismatches < 0 )
+      {
+        success = false;
+        break;
+      }
+      printf( "mandel: verify: frame %d: %ld of %ld pixels differ from the exhaustive render\n", frame+1, frameMismatches, (long) width * height );
+      *mismatches += frameMismatches;
+    }
+
+    // the other bitmap is about to be reused for the next frame, so its save has to be done first
+    if( savingSlot >= 0 )
+    {
+      pthread_join( saver, NULL );
+      if( !saves[savingSlot].saved )
+      {
+        fprintf(stderr,"mandel: couldn't write to %s: %s\n",saves[savingSlot].filename,strerror(saves[savingSlot].savedErrno));
+        success = false;
+      }
+      savingSlot = -1;
+    }
+
+    saves[slot].theBitmap = frames[slot];
+    saves[slot].filename = frameNames[slot];
+    if( pthread_create( &saver, NULL, saveFrame, (void *) &saves[slot] ) == 0 )
+    {
+      savingSlot = slot;
+    }
+    else
+    {
+      // no thread to save it in the background, so just save it here
+      saveFrame( (void *) &saves[slot] );
+      if( !saves[slot].saved )
+      {
+        fprintf(stderr,"mandel: couldn't write to %s: %s\n",saves[slot].filename,strerror(saves[slot].savedErrno));
+        success = false;
+      }
+    }
+  }
+
+  if( savingSlot >= 0 )
+  {
+    pthread_join( saver, NULL );
+    if( !saves[savingSlot].saved )
+    {
+      fprintf(stderr,"mandel: couldn't write to %s: %s\n",saves[savingSlot].filename,strerror(saves[savingSlot].savedErrno));
+      success = false;
+    }
+  }
+
+  stopWorkerPool();
+  free( PREVIOUS_FRAME.iters );
+  PREVIOUS_FRAME.iters = NULL;
+  bitmap_delete( frames[0] );
+  bitmap_delete( frames[1] );
+
+  if( TIMING && success )
+  {
+    gettimeofday( &frameEnd, NULL );
+    printf( "mandel: Computed time taken (in usec): %d\n", (int) elapsedUsec( &seriesStart, &frameEnd ) );
+  }
+
+  return success;
+} // renderSeries()
+
+/*
+ * function: 
+ *  seriesFrameName
+ * 
+ * description: 
+ *  Builds the file name of one frame of a series by adding the frame number in front of the
+ *    output file's extension (mandel.bmp becomes mandel1.bmp, mandel2.bmp, ...), the same names
+ *    mandelseries uses. A name without an extension just gets the number on the end.
+ * 
+ * parameters:
+ *  char * buffer: receives the frame's file name
+ *  size_t size: the size of buffer
+ *  const char * outfile: the output file name requested with -o
+ *  int frame: the frame number, starting at 1
+ * 
+ * returns: 
+ *  void
+ */
+static void seriesFrameName( char * buffer, size_t size, const char * outfile, int frame )
+{
+  const char * extension = strrchr( outfile, '.' );
+  const char * lastSlash = strrchr( outfile, '/' );
+  if( extension == NULL || ( lastSlash != NULL && extension < lastSlash ) )
+  {
+    extension = outfile + strlen( outfile );
+  }
+
+  snprintf( buffer, size, "%.*s%d%s", (int) ( extension - outfile ), outfile, frame, extension );
+} // seriesFrameName()
+
+/*
+ * function: 
+ *  saveFrame
+ * 
+ * description: 
+ *  Thread entry point that saves one finished frame of a series, so renderSeries() can get on
+ *    with computing the next one.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type frameSave
+ * 
+ * returns: 
+ *  void *
+ */
+void * saveFrame( void * args )
+{
+  struct frameSave * save = args;
+  errno = 0;
+  save->saved = bitmap_save( save->theBitmap, save->filename );
+  save->savedErrno = errno;
+  return NULL;
+} // saveFrame()
+
+/*
+ * function: 
+ *  loadManifest
+ * 
+ * description: 
+ *  Reads a -F manifest: one view per line, as x y scale max width height outfile separated by spaces or tabs.
+ *    Blank lines and lines starting with # are skipped. The coordinates are kept as typed as well, for 
+ *    views deep enough to need the double-double or perturbation arithmetic.
+ * 
+ * parameters:
+ *  const char * file: the manifest to read
+ *  int * jobCount: receives the number of views in it
+ * 
+ * returns: 
+ *  struct batchJob *: the views, to be freed with freeManifest(), or NULL if the file couldn't be read or has a bad line
+ */
+static struct batchJob * loadManifest( const char * file, int * jobCount )
+{
+  FILE * manifest = fopen( file, "r" );
+  if( manifest == NULL )
+  {
+    fprintf(stderr,"mandel: couldn't open %s: %s\n",file,strerror(errno));
+    return NULL;
+  }
+
+  struct batchJob * jobs = NULL;
+  int count = 0;
+  int capacity = 0;
+  char line[4096];
+  int lineNumber = 0;
+  bool valid = true;
+
+  while( valid && fgets( line, sizeof(line), manifest ) != NULL )
+  {
+    lineNumber++;
+    char * fields[8];
+    int fieldCount = 0;
+    char * save;
+    char * field = strtok_r( line, " \t\r\n", &save );
+    while( field != NULL && fieldCount < 8 )
+    {
+      fields[fieldCount++] = field;
+      field = strtok_r( NULL, " \t\r\n", &save );
+    }
+    if( fieldCount == 0 || fields[0][0] == '#' )
+    {
+      continue;
+    }
+
+    struct batchJob job;
+    memset( &job, 0, sizeof(job) );
+    char * end[6];
+    if( fieldCount == 7 )
+    {
+      job.xcenter = strtod( fields[0], &end[0] );
+      job.ycenter = strtod( fields[1], &end[1] );
+      job.scale = strtod( fields[2], &end[2] );
+      job.max = (int) strtol( fields[3], &end[3], 10 );
+      job.width = (int) strtol( fields[4], &end[4], 10 );
+      job.height = (int) strtol( fields[5], &end[5], 10 );
+    }
+    int k;
+    for( k=0 ; fieldCount == 7 && k<6 && *end[k] == '\0' ; k++ );
+    if( fieldCount != 7 || k < 6 || job.scale <= 0 || job.max < 1 || job.width < 1 || job.height < 1 )
+    {
+      fprintf(stderr,"mandel: %s line %d: expected x y scale max width height outfile\n",file,lineNumber);
+      valid = false;
+      break;
+    }
+
+    if( count == capacity )
+    {
+      capacity = capacity == 0 ? 16 : capacity * 2;
+      struct batchJob * grown = realloc( jobs, capacity * sizeof(struct batchJob) );
+      if( grown == NULL )
+      {
+        valid = false;
+        break;
+      }
+      jobs = grown;
+    }
+
+    job.xcenterText = strdup( fields[0] );
+    job.ycenterText = strdup( fields[1] );
+    job.outfile = strdup( fields[6] );
+    jobs[count++] = job;
+    if( job.xcenterText == NULL || job.ycenterText == NULL || job.outfile == NULL )
+    {
+      valid = false;
+    }
+  }
+  fclose( manifest );
+
+  if( valid && count == 0 )
+  {
+    fprintf(stderr,"mandel: %s has no views in it\n",file);
+    valid = false;
+  }
+  if( !valid )
+  {
+    freeManifest( jobs, count );
+    return NULL;
+  }
+
+  *jobCount = count;
+  return jobs;
+} // loadManifest()
+
+/*
+ * function: 
+ *  freeManifest
+ * 
+ * description: 
+ *  Frees the views loadManifest() read, along with anything left of their bitmaps.
+ * 
+ * parameters:
+ *  struct batchJob * jobs: the views, or NULL
+ *  int jobCount: the number of views
+ * 
+ * returns: 
+ *  void
+ */
+static void freeManifest( struct batchJob * jobs, int jobCount )
+{
+  int i;
+  for( i=0 ; jobs != NULL && i<jobCount ; i++ )
+  {
+    free( jobs[i].xcenterText );
+    free( jobs[i].ycenterText );
+    free( jobs[i].outfile );
+    if( jobs[i].theBitmap != NULL )
+    {
+      bitmap_delete( jobs[i].theBitmap );
+    }
+  }
+  free( jobs );
+} // freeManifest()
+
+/*
+ * function: 
+ *  renderBatch
+ * 
+ * description: 
+ *  Renders every view of a -F manifest in this one process, on one pool of threads started up front.
+ *  Every view the double (or, with -p float, the float) kernel can render is cut into TILE_SIZE x TILE_SIZE 
+ *    tiles, and the tiles of all of them are numbered one after the other and handed out off of a single 
+ *    counter by batchWorker(). A thread that runs out of tiles in one view just carries on with the next 
+ *    view's, so no thread waits for the slowest tile of a view before it has more work.
+ *  Each view's bitmap is only created when its first tile is handed out, and saved and freed by whichever 
+ *    thread finishes its last tile, so only the views actually being worked on are held in memory.
+ *  Views deep enough to need the double-double or perturbation arithmetic (with -p auto), or every view 
+ *    with -p dd or -p perturb, can't share a kernel with the others, so they're rendered afterwards one 
+ *    at a time with renderFrame(), still on the same pool.
+ *  With -k every view is looked up in the cache first (see colorCachedView()), and the ones found there 
+ *    are just colored and saved. The counts of the rest are put there once they're rendered.
+ *  A report of how long every view took is printed at the end: from its first tile being handed out to it 
+ *    being saved, and the time its tiles kept threads busy all together (the same as the first, for a deep view).
+ * 
+ * parameters:
+ *  const char * manifestFile: the manifest to render
+ *  int numThreads: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if every view was rendered and saved, otherwise false
+ */
+static bool renderBatch( const char * manifestFile, int numThreads )
+{
+  struct timeval batchStart;
+  struct timeval batchEnd;
+  gettimeofday( &batchStart, NULL );
+
+  int jobCount;
+  struct batchJob * jobs = loadManifest( manifestFile, &jobCount );
+  if( jobs == NULL )
+  {
+    return false;
+  }
+
+  // number the tiles of the views that can be interleaved one after the other
+  enum precisionType requestedPrecision = PRECISION;
+  long tileCount = 0;
+  int interleaved = 0;
+  int i;
+  for( i=0 ; i<jobCount ; i++ )
+  {
+    struct batchJob * job = &jobs[i];
+    job->precision = requestedPrecision;
+    if( job->precision == PRECISION_AUTO )
+    {
+      job->precision = selectPrecision( job->xcenter, job->ycenter, job->scale, job->width, job->height, job->max );
+    }
+    pthread_mutex_init( &job->lock, NULL );
+    atomic_init( &job->busyUsec, 0 );
+
+    // a view that's in the cache already is colored and saved right here, and has no tiles to hand out
+    job->cached = CACHE != NULL && colorCachedView( job );
+    job->tilesAcross = ( job->width + TILE_SIZE - 1 ) / TILE_SIZE;
+    job->tileCount = job->cached ? 0 : job->tilesAcross * ( ( job->height + TILE_SIZE - 1 ) / TILE_SIZE );
+    job->firstTile = tileCount;
+    atomic_init( &job->tilesLeft, job->tileCount );
+    if( ( job->precision == PRECISION_DOUBLE || job->precision == PRECISION_FLOAT ) && !job->cached )
+    {
+      tileCount += job->tileCount;
+      interleaved++;
+    }
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: renderBatch(): %d views, %d of them interleaved in %ld tiles of %dx%d pixels\n", 
+      jobCount, interleaved, tileCount, TILE_SIZE, TILE_SIZE );
+  }
+
+  if( numThreads > 1 && !startWorkerPool( numThreads ) )
+  {
+    printf("There was an issue creating threads, and the program must exit.\n");
+    printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+    freeManifest( jobs, jobCount );
+    return false;
+  }
+
+  // the float kernel is swapped in for the whole interleaved part, the same as renderFrame() does for one image
+  struct renderOptions saved;
+  saveRenderOptions( &saved );
+  if( requestedPrecision == PRECISION_FLOAT )
+  {
+    ESCAPE_KERNEL = FLOAT_KERNEL;
+    ESCAPE_KERNEL_NAME = FLOAT_KERNEL_NAME;
+  }
+
+  atomic_long nextTile;
+  atomic_init( &nextTile, 0 );
+  struct batchParams batch;
+  batch.jobs = jobs;
+  batch.jobCount = jobCount;
+  batch.tileCount = tileCount;
+  batch.nextTile = &nextTile;
+
+  bool success = true;
+  pthread_t * threadsArr = calloc( numThreads, sizeof(pthread_t) );
+  if( threadsArr == NULL )
+  {
+    success = false;
+  }
+  else if( numThreads > 1 && tileCount > 0 )
+  {
+    for( i=0 ; i<numThreads ; i++ )
+    {
+      int returnCode = spawnWorker( i, &threadsArr[i], batchWorker, (void *) &batch );
+      if( returnCode != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+        if(DBG)
+        {
+          printf( "ERROR -> renderBatch(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+        }
+        exit(EXIT_FAILURE);
+      }
+    }
+    for( i=0 ; i<numThreads ; i++ )
+    {
+      int joinResult = joinWorker( i, threadsArr[i] );
+      if( DBG && joinResult != 0 )
+      {
+        printf( "ERROR -> renderBatch(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+      }
+    }
+  }
+  else if( tileCount > 0 )
+  {
+    batchWorker( (void *) &batch );
+  }
+  free( threadsArr );
+
+  restoreRenderOptions( &saved );
+
+  // the deep views, one at a time. Each has its own center, so the reference orbit is worked out again for every one
+  for( i=0 ; i<jobCount ; i++ )
+  {
+    struct batchJob * job = &jobs[i];
+    if( job->precision == PRECISION_DOUBLE || job->precision == PRECISION_FLOAT || job->cached )
+    {
+      continue;
+    }
+
+    gettimeofday( &job->start, NULL );
+    job->theBitmap = bitmap_create( job->width, job->height );
+    if( job->theBitmap == NULL )
+    {
+      job->failed = true;
+      continue;
+    }
+
+    PRECISION = job->precision;
+    free( REFERENCE_ORBIT.x );
+    free( REFERENCE_ORBIT.y );
+    REFERENCE_ORBIT.x = NULL;
+    REFERENCE_ORBIT.y = NULL;
+    RAW_OUTPUT = CACHE != NULL ? iterfile_create( job->width, job->height, job->max ) : NULL;
+    if( !renderFrame( job->theBitmap, job->xcenter, job->ycenter, job->xcenterText, job->ycenterText, job->scale, job->max, numThreads ) )
+    {
+      job->failed = true;
+    }
+    else
+    {
+      errno = 0;
+      job->saved = bitmap_save( job->theBitmap, job->outfile );
+      job->savedErrno = errno;
+      if( RAW_OUTPUT != NULL )
+      {
+        storeCachedImage( job->key, RAW_OUTPUT );
+      }
+    }
+    if( RAW_OUTPUT != NULL )
+    {
+      iterfile_delete( RAW_OUTPUT );
+      RAW_OUTPUT = NULL;
+    }
+    gettimeofday( &job->end, NULL );
+    atomic_store( &job->busyUsec, elapsedUsec( &job->start, &job->end ) );
+    bitmap_delete( job->theBitmap );
+    job->theBitmap = NULL;
+  }
+  PRECISION = requestedPrecision;
+
+  stopWorkerPool();
+
+  // the report, in the order of the manifest
+  for( i=0 ; i<jobCount ; i++ )
+  {
+    struct batchJob * job = &jobs[i];
+    if( job->failed || !job->saved )
+    {
+      if( job->failed )
+      {
+        fprintf(stderr,"mandel: job %d: couldn't render %s\n",i+1,job->outfile);
+      }
+      else
+      {
+        fprintf(stderr,"mandel: job %d: couldn't write to %s: %s\n",i+1,job->outfile,strerror(job->savedErrno));
+      }
+      success = false;
+      continue;
+    }
+    printf( "mandel: job %d of %d: x=%s y=%s scale=%g max=%d %dx%d %s%s -> %s: %ld usec, %ld usec busy over %d tiles, started at %ld usec\n", 
+      i+1, jobCount, job->xcenterText, job->ycenterText, job->scale, job->max, job->width, job->height, PRECISION_NAMES[job->precision], 
+      job->cached ? " from the cache" : "", job->outfile, elapsedUsec( &job->start, &job->end ), atomic_load( &job->busyUsec ), 
+      job->precision == PRECISION_DOUBLE || job->precision == PRECISION_FLOAT ? job->tileCount : 0, elapsedUsec( &batchStart, &job->start ) );
+  }
+
+  freeManifest( jobs, jobCount );
+
+  if( TIMING && success )
+  {
+    gettimeofday( &batchEnd, NULL );
+    printf( "mandel: Computed time taken (in usec): %d\n", (int) elapsedUsec( &batchStart, &batchEnd ) );
+  }
+
+  return success;
+} // renderBatch()
+
+/*
+ * function: 
+ *  batchWorker
+ * 
+ * description: 
+ *  Entry point for the threads of a -F batch (and called directly when only one thread is used).
+ *  Takes tiles off of the counter shared by every interleaved view until there are none left, creating 
+ *    a view's bitmap if the tile is the first of it to be handed out, and saving and freeing the bitmap 
+ *    if the tile is the last of it to finish.
+ *  The tiles are numbered view by view, and each thread's tiles only ever move forward through them, 
+ *    so the view a tile belongs to is found by carrying on from the view of the thread's last tile.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type 
+ *    batchParams, which is shared by all the threads.
+ * 
+ * returns: 
+ *  void *
+ */
+void * batchWorker( void * args )
+{
+  struct batchParams * batch = args;
+  int current = 0;
+
+  while( true )
+  {
+    long tileNumber = atomic_fetch_add( batch->nextTile, 1 );
+    if( tileNumber >= batch->tileCount )
+    {
+      break;
+    }
+
+    struct batchJob * job = &batch->jobs[current];
+    while( ( job->precision != PRECISION_DOUBLE && job->precision != PRECISION_FLOAT ) || tileNumber >= job->firstTile + job->tileCount )
+    {
+      job = &batch->jobs[++current];
+    }
+
+    // the first tile of a view to be handed out creates its bitmap
+    pthread_mutex_lock( &job->lock );
+    if( !job->started )
+    {
+      job->started = true;
+      gettimeofday( &job->start, NULL );
+      job->theBitmap = bitmap_create( job->width, job->height );
+      job->failed = job->theBitmap == NULL;
+      if( CACHE != NULL && !job->failed )
+      {
+        job->counts = iterfile_create( job->width, job->height, job->max );
+      }
+    }
+    pthread_mutex_unlock( &job->lock );
+
+    struct timeval tileStart;
+    struct timeval tileEnd;
+    gettimeofday( &tileStart, NULL );
+    if( !job->failed )
+    {
+      int k = (int) ( tileNumber - job->firstTile );
+      int xStart = ( k % job->tilesAcross ) * TILE_SIZE;
+      int yStart = ( k / job->tilesAcross ) * TILE_SIZE;
+      int xEnd = xStart + TILE_SIZE < job->width ? xStart + TILE_SIZE : job->width;
+      int yEnd = yStart + TILE_SIZE < job->height ? yStart + TILE_SIZE : job->height;
+      double xmin = job->xcenter - job->scale;
+      double xmax = job->xcenter + job->scale;
+      double ymin = job->ycenter - job->scale;
+      double ymax = job->ycenter + job->scale;
+      int j;
+      for( j=yStart ; j<yEnd ; j++ )
+      {
+        double y = ymin + j*(ymax-ymin)/job->height;
+        computeRow( job->theBitmap, j, xStart, xEnd, xmin, xmax, job->width, y, job->max, job->counts, LOCKED_WRITES );
+      }
+    }
+    gettimeofday( &tileEnd, NULL );
+    atomic_fetch_add( &job->busyUsec, elapsedUsec( &tileStart, &tileEnd ) );
+
+    // the last tile of a view to finish saves it. Every other tile of it is done by now, so nothing else touches it
+    if( atomic_fetch_sub( &job->tilesLeft, 1 ) == 1 && !job->failed )
+    {
+      errno = 0;
+      job->saved = bitmap_save( job->theBitmap, job->outfile );
+      job->savedErrno = errno;
+      bitmap_delete( job->theBitmap );
+      job->theBitmap = NULL;
+      if( job->counts != NULL )
+      {
+        storeCachedImage( job->key, job->counts );
+        iterfile_delete( job->counts );
+        job->counts = NULL;
+      }
+      gettimeofday( &job->end, NULL );
+    }
+  }
+
+  return NULL;
+} // batchWorker()
+
+/*
+ * function: 
+ *  colorCachedView
+ * 
+ * description: 
+ *  Works out the -k cache key of a view of a -F batch, and if the view is in the cache, colors it 
+ *    from the cached counts and saves it, timing that the same way a rendered view is timed.
+ * 
+ * parameters:
+ *  struct batchJob * job: the view, with its precision worked out
+ * 
+ * returns: 
+ *  bool: true if the view was in the cache, so there's nothing left to render, otherwise false
+ */
+static bool colorCachedView( struct batchJob * job )
+{
+  cacheKey( job->key, job->precision, job->xcenter, job->ycenter, job->xcenterText, job->ycenterText, 
+    job->scale, job->width, job->height, job->max );
+
+  struct iterfile * cached = lookupCachedImage( job->key, job->width, job->height, job->max );
+  if( cached == NULL )
+  {
+    return false;
+  }
+
+  gettimeofday( &job->start, NULL );
+  job->theBitmap = bitmap_create( job->width, job->height );
+  if( job->theBitmap == NULL )
+  {
+    job->failed = true;
+  }
+  else
+  {
+    colorCachedImage( job->theBitmap, cached, job->max );
+    errno = 0;
+    job->saved = bitmap_save( job->theBitmap, job->outfile );
+    job->savedErrno = errno;
+    bitmap_delete( job->theBitmap );
+    job->theBitmap = NULL;
+  }
+  iterfile_delete( cached );
+  gettimeofday( &job->end, NULL );
+  atomic_store( &job->busyUsec, elapsedUsec( &job->start, &job->end ) );
+  return true;
+} // colorCachedView()
+
+/*
+ * function: 
+ *  serveRequests
+ * 
+ * description: 
+ *  Runs mandel as a render server (-D) on a Unix domain socket until a client sends SHUTDOWN.
+ *  Clients send one request per line and get their answers back on the same connection, in 
+ *    whatever order the requests finish:
+ *      RENDER <id> <priority> <x> <y> <scale> <max> <width> <height>
+ *        renders the view, and answers OK <id> <bytes>, a newline, and then the BMP file's bytes
+ *      CANCEL <id>
+ *        drops the client's request with that id. Its answer is CANCELLED <id> instead of OK
+ *      SHUTDOWN
+ *        cancels everything still waiting and stops the server
+ *    A bad request gets ERR <id> <reason>, with an id of - if there's no id to give.
+ *  The views are the same images mandel -x -y -s -m -W -H would render with the double kernel 
+ *    (or the float one with -p float). A view deeper than doubles can resolve is refused, unless 
+ *    -p double or -p float was given to render them anyway.
+ *  The computing is done by numThreads persistent threads, started once, that work through the 
+ *    tiles of every request in the queue, always taking the next tile of the highest-priority 
+ *    request first (the oldest of those, when several share it). So a request that comes in with a 
+ *    higher priority gets the threads from the next tile on, and a cancelled request stops taking 
+ *    any more of them, while the threads on its tiles give them up at the next row. Views with a max 
+ *    above SERVER_MAX_ITERATIONS are refused, which keeps a row short. Every client connection gets 
+ *    a thread of its own that reads its requests.
+ *  With -k a view that's in the cache is answered from it as soon as it's read, and the counts of 
+ *    every view rendered are put there.
+ * 
+ * parameters:
+ *  const char * socketPath: where to create the socket. A socket already there (left by an earlier server) 
+ *    is replaced, but anything else there is left alone and the server isn't started
+ *  int numThreads: the number of threads to perform the computation
+ * 
+ * returns: 
+ *  bool: true if the server ran and was shut down, false if it couldn't be started
+ */
+static bool serveRequests( const char * socketPath, int numThreads )
+{
+  struct sockaddr_un address;
+  memset( &address, 0, sizeof(address) );
+  address.sun_family = AF_UNIX;
+  if( strlen( socketPath ) >= sizeof(address.sun_path) )
+  {
+    fprintf(stderr,"mandel: the socket path %s is too long\n",socketPath);
+    return false;
+  }
+  strcpy( address.sun_path, socketPath );
+
+  // only a stale socket is cleared out of the way, never a file that happens to have the name
+  struct stat existing;
+  if( lstat( socketPath, &existing ) == 0 )
+  {
+    if( !S_ISSOCK( existing.st_mode ) )
+    {
+      fprintf(stderr,"mandel: couldn't listen on %s: %s\n",socketPath,strerror(EEXIST));
+      return false;
+    }
+    unlink( socketPath );
+  }
+
+  int listenFd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if( listenFd < 0 || bind( listenFd, (struct sockaddr *) &address, sizeof(address) ) != 0 || listen( listenFd, SERVER_BACKLOG ) != 0 )
+  {
+    fprintf(stderr,"mandel: couldn't listen on %s: %s\n",socketPath,strerror(errno));
+    if( listenFd >= 0 )
+    {
+      close( listenFd );
+    }
+    return false;
+  }
+
+  // a client that hangs up before its answer is written shouldn't take the server down with it
+  signal( SIGPIPE, SIG_IGN );
+  SERVER.listenFd = listenFd;
+
+  // every request is rendered with the one kernel, the same as renderFrame() does for one image
+  if( PRECISION == PRECISION_FLOAT )
+  {
+    ESCAPE_KERNEL = FLOAT_KERNEL;
+    ESCAPE_KERNEL_NAME = FLOAT_KERNEL_NAME;
+  }
+
+  if( numThreads > 1 && !startWorkerPool( numThreads ) )
+  {
+    printf("There was an issue creating threads, and the program must exit.\n");
+    printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+    close( listenFd );
+    unlink( socketPath );
+    return false;
+  }
+
+  pthread_t * threadsArr = calloc( numThreads, sizeof(pthread_t) );
+  if( threadsArr == NULL )
+  {
+    stopWorkerPool();
+    close( listenFd );
+    unlink( socketPath );
+    return false;
+  }
+
+  int i;
+  for( i=0 ; i<numThreads ; i++ )
+  {
+    int returnCode = spawnWorker( i, &threadsArr[i], serverWorker, NULL );
+    if( returnCode != 0 )
+    {
+      printf("There was an issue creating threads, and the program must exit.\n");
+      printf("This is often a transient error, so it will most likely work without issue when retrying.\n");
+      if(DBG)
+      {
+        printf( "ERROR -> serveRequests(): pthread_create return code = %d: %s.. exiting...\n", returnCode, strerror(returnCode) );
+      }
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  printf( "mandel: serving on %s with %d threads\n", socketPath, numThreads );
+  fflush( stdout );
+
+  // hand every new connection to a reader thread of its own, until SHUTDOWN closes the socket under accept()
+  int clientNumber = 0;
+  while( true )
+  {
+    int fd = accept( listenFd, NULL, NULL );
+    if( fd < 0 )
+    {
+      pthread_mutex_lock( &SERVER.lock );
+      bool stopping = SERVER.shuttingDown;
+      pthread_mutex_unlock( &SERVER.lock );
+      if( stopping )
+      {
+        break;
+      }
+      if( errno == EINTR || errno == ECONNABORTED )
+      {
+        continue;
+      }
+      if( errno == EMFILE || errno == ENFILE )
+      {
+        // out of descriptors, so the connection waits in the backlog until a client hangs up (or a second 
+        // has gone by, in case something else frees one) rather than accept() being retried flat out
+        if(DBG)
+        {
+          printf( "DEBUG: serveRequests(): accept() on %s: %s, waiting for a client to hang up\n", socketPath, strerror(errno) );
+        }
+        struct timespec until;
+        clock_gettime( CLOCK_REALTIME, &until );
+        until.tv_sec++;
+        pthread_mutex_lock( &SERVER.lock );
+        if( !SERVER.shuttingDown )
+        {
+          pthread_cond_timedwait( &SERVER.clientGone, &SERVER.lock, &until );
+        }
+        pthread_mutex_unlock( &SERVER.lock );
+        continue;
+      }
+      fprintf(stderr,"mandel: accept() on %s failed: %s\n",socketPath,strerror(errno));
+      break;
+    }
+
+    struct serverClient * client = calloc( 1, sizeof(struct serverClient) );
+    int outFd = dup( fd );
+    if( client == NULL || outFd < 0 || ( client->in = fdopen( fd, "r" ) ) == NULL || ( client->out = fdopen( outFd, "w" ) ) == NULL )
+    {
+      if( client != NULL && client->in != NULL )
+      {
+        fclose( client->in );
+      }
+      else
+      {
+        close( fd );
+      }
+      if( outFd >= 0 )
+      {
+        close( outFd );
+      }
+      free( client );
+      continue;
+    }
+    pthread_mutex_init( &client->lock, NULL );
+    client->number = ++clientNumber;
+    client->refs = 1;
+
+    pthread_t reader;
+    if( pthread_create( &reader, NULL, serverReader, (void *) client ) != 0 )
+    {
+      fclose( client->in );
+      releaseClient( client );
+      continue;
+    }
+    pthread_detach( reader );
+  }
+
+  // make sure the workers see the shutdown even if accept() failed on its own
+  pthread_mutex_lock( &SERVER.lock );
+  SERVER.shuttingDown = true;
+  pthread_cond_broadcast( &SERVER.changed );
+  pthread_mutex_unlock( &SERVER.lock );
+
+  for( i=0 ; i<numThreads ; i++ )
+  {
+    int joinResult = joinWorker( i, threadsArr[i] );
+    if( DBG && joinResult != 0 )
+    {
+      printf( "ERROR -> serveRequests(): pthread_join returned error %d: %s...\n", joinResult, strerror(joinResult) );
+    }
+  }
+  free( threadsArr );
+  stopWorkerPool();
+
+  close( listenFd );
+  unlink( socketPath );
+  printf( "mandel: server on %s shut down after %ld requests\n", socketPath, SERVER.served );
+  return true;
+} // serveRequests()
+
+/*
+ * function: 
+ *  serverReader
+ * 
+ * description: 
+ *  Entry point for the thread that reads one client's requests (see serveRequests() for the protocol).
+ *  RENDER requests are checked, given their bitmap, and put on the queue, or answered from the -k cache 
+ *    if they're in it. CANCEL and SHUTDOWN are carried out straight away. A request with more fields than 
+ *    it takes is refused, and so is a line longer than SERVER_LINE_LENGTH, with one ERR for all of it. 
+ *    When the client hangs up, whatever it still has queued is cancelled.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type serverClient
+ * 
+ * returns: 
+ *  void *
+ */
+void * serverReader( void * args )
+{
+  struct serverClient * client = args;
+  char line[SERVER_LINE_LENGTH];
+
+  while( fgets( line, sizeof(line), client->in ) != NULL )
+  {
+    char command[16];
+    char id[SERVER_ID_LENGTH];
+    struct serverRequest request;
+    memset( &request, 0, sizeof(request) );
+
+    // a line that didn't fit gets one answer, and the rest of it is thrown away unread
+    size_t length = strlen( line );
+    bool tooLong = length > 0 && line[length-1] != '\n' && !feof( client->in );
+    if( tooLong )
+    {
+      int c;
+      while( ( c = getc( client->in ) ) != EOF && c != '\n' );
+    }
+
+    // end is only set if all 9 fields were there, and says where whatever follows them starts
+    int end = -1;
+    int fields = sscanf( line, "%15s %63s %d %lf %lf %lf %d %d %d %n", command, id, &request.priority, 
+      &request.xcenter, &request.ycenter, &request.scale, &request.max, &request.width, &request.height, &end );
+    if( fields < 1 )
+    {
+      continue;
+    }
+    int words = countWords( line );
+
+    if( tooLong )
+    {
+      sendReply( client, "ERR %s request too long\n", fields >= 2 ? id : "-" );
+    }
+    else if( strcmp( command, "SHUTDOWN" ) == 0 && words == 1 )
+    {
+      if(DBG)
+      {
+        printf( "DEBUG: serverReader(): client %d asked the server to shut down\n", client->number );
+      }
+      pthread_mutex_lock( &SERVER.lock );
+      SERVER.shuttingDown = true;
+      struct serverRequest * pending;
+      for( pending=SERVER.queue ; pending!=NULL ; pending=pending->next )
+      {
+        cancelRequest( pending );
+      }
+      pthread_cond_broadcast( &SERVER.changed );
+      pthread_cond_broadcast( &SERVER.clientGone );
+      pthread_mutex_unlock( &SERVER.lock );
+      finishCancelledRequests();
+      shutdown( SERVER.listenFd, SHUT_RDWR );
+      break;
+    }
+    else if( strcmp( command, "CANCEL" ) == 0 && words == 2 )
+    {
+      bool found = false;
+      pthread_mutex_lock( &SERVER.lock );
+      struct serverRequest * pending;
+      for( pending=SERVER.queue ; pending!=NULL ; pending=pending->next )
+      {
+        if( pending->client == client && strcmp( pending->id, id ) == 0 && !pending->cancelled )
+        {
+          cancelRequest( pending );
+          found = true;
+        }
+      }
+      pthread_mutex_unlock( &SERVER.lock );
+      if( found )
+      {
+        finishCancelledRequests();
+      }
+      else
+      {
+        sendReply( client, "ERR %s no such request\n", id );
+      }
+    }
+    else if( strcmp( command, "RENDER" ) == 0 && fields == 9 && end >= 0 && line[end] == '\0' )
+    {
+      if( !isfinite( request.xcenter ) || !isfinite( request.ycenter ) || !isfinite( request.scale ) || 
+        request.scale <= 0 || request.max < 1 || request.max > SERVER_MAX_ITERATIONS || 
+        request.width < 1 || request.height < 1 || (long long) request.width * request.height > SERVER_MAX_PIXELS )
+      {
+        sendReply( client, "ERR %s bad view\n", id );
+        continue;
+      }
+
+      enum precisionType precision = PRECISION;
+      if( precision == PRECISION_AUTO )
+      {
+        precision = selectPrecision( request.xcenter, request.ycenter, request.scale, request.width, request.height, request.max );
+      }
+      if( precision == PRECISION_DOUBLEDOUBLE || precision == PRECISION_PERTURB )
+      {
+        sendReply( client, "ERR %s view too deep for double precision\n", id );
+        continue;
+      }
+
+      struct serverRequest * queued = malloc( sizeof(struct serverRequest) );
+      struct bitmap * bm = bitmap_create( request.width, request.height );
+      if( queued == NULL || bm == NULL )
+      {
+        free( queued );
+        if( bm != NULL )
+        {
+          bitmap_delete( bm );
+        }
+        sendReply( client, "ERR %s out of memory\n", id );
+        continue;
+      }
+
+      *queued = request;
+      snprintf( queued->id, sizeof(queued->id), "%s", id );
+      queued->client = client;
+      queued->theBitmap = bm;
+      queued->tilesAcross = ( request.width + TILE_SIZE - 1 ) / TILE_SIZE;
+      queued->tileCount = queued->tilesAcross * ( ( request.height + TILE_SIZE - 1 ) / TILE_SIZE );
+      queued->nextTile = 0;
+      queued->tilesLeft = queued->tileCount;
+      queued->cancelled = false;
+      gettimeofday( &queued->received, NULL );
+
+      // a view that's in the cache already is answered right away, without going on the queue. 
+      // The double and float kernels only need the center as a number, so there's no text for the key
+      if( CACHE != NULL )
+      {
+        cacheKey( queued->key, precision, request.xcenter, request.ycenter, NULL, NULL, request.scale, request.width, request.height, request.max );
+        struct iterfile * cached = lookupCachedImage( queued->key, request.width, request.height, request.max );
+        if( cached != NULL )
+        {
+          colorCachedImage( bm, cached, request.max );
+          iterfile_delete( cached );
+          pthread_mutex_lock( &client->lock );
+          client->refs++;
+          pthread_mutex_unlock( &client->lock );
+          pthread_mutex_lock( &SERVER.lock );
+          SERVER.served++;
+          pthread_mutex_unlock( &SERVER.lock );
+          finishRequest( queued );
+          continue;
+        }
+        queued->counts = iterfile_create( request.width, request.height, request.max );
+      }
+
+      pthread_mutex_lock( &SERVER.lock );
+      if( SERVER.shuttingDown || !scheduleRequest( queued ) )
+      {
+        bool stopping = SERVER.shuttingDown;
+        pthread_mutex_unlock( &SERVER.lock );
+        bitmap_delete( bm );
+        if( queued->counts != NULL )
+        {
+          iterfile_delete( queued->counts );
+        }
+        free( queued );
+        sendReply( client, stopping ? "ERR %s server is shutting down\n" : "ERR %s out of memory\n", id );
+        continue;
+      }
+      pthread_mutex_lock( &client->lock );
+      client->refs++;
+      pthread_mutex_unlock( &client->lock );
+      queued->prev = NULL;
+      queued->next = SERVER.queue;
+      if( SERVER.queue != NULL )
+      {
+        SERVER.queue->prev = queued;
+      }
+      SERVER.queue = queued;
+      pthread_cond_broadcast( &SERVER.changed );
+      pthread_mutex_unlock( &SERVER.lock );
+    }
+    else
+    {
+      sendReply( client, "ERR %s bad request\n", fields >= 2 ? id : "-" );
+    }
+  }
+
+  // a client that's gone doesn't need the rest of its answers
+  pthread_mutex_lock( &SERVER.lock );
+  struct serverRequest * pending;
+  for( pending=SERVER.queue ; pending!=NULL ; pending=pending->next )
+  {
+    if( pending->client == client )
+    {
+      cancelRequest( pending );
+    }
+  }
+  pthread_mutex_unlock( &SERVER.lock );
+  finishCancelledRequests();
+
+  fclose( client->in );
+  releaseClient( client );
+  return NULL;
+} // serverReader()
+
+/*
+ * function: 
+ *  serverWorker
+ * 
+ * description: 
+ *  Entry point for the server's compute threads. Waits for a queued request with tiles left to hand out, 
+ *    takes the next tile of the highest-priority one (the oldest, among equals), and computes it. That's 
+ *    the first request of SERVER's first level, so it's found the same way however long the queue is. 
+ *    A tile of a request that is cancelled meanwhile is left unfinished from the next row on. 
+ *    Whichever thread finishes the last tile of a request sends the answer and frees the request.
+ *  Returns once the server is shutting down.
+ * 
+ * parameters:
+ *  void * args: unused, the queue is SERVER
+ * 
+ * returns: 
+ *  void *
+ */
+void * serverWorker( void * args )
+{
+  pthread_mutex_lock( &SERVER.lock );
+  while( true )
+  {
+    struct serverRequest * best = SERVER.levels != NULL ? SERVER.levels->head : NULL;
+    if( best == NULL )
+    {
+      if( SERVER.shuttingDown )
+      {
+        break;
+      }
+      pthread_cond_wait( &SERVER.changed, &SERVER.lock );
+      continue;
+    }
+
+    if( best->nextTile == 0 )
+    {
+      gettimeofday( &best->started, NULL );
+    }
+    int k = best->nextTile++;
+    if( best->nextTile == best->tileCount )
+    {
+      unscheduleRequest( best );
+    }
+    pthread_mutex_unlock( &SERVER.lock );
+
+    int xStart = ( k % best->tilesAcross ) * TILE_SIZE;
+    int yStart = ( k / best->tilesAcross ) * TILE_SIZE;
+    int xEnd = xStart + TILE_SIZE < best->width ? xStart + TILE_SIZE : best->width;
+    int yEnd = yStart + TILE_SIZE < best->height ? yStart + TILE_SIZE : best->height;
+    double xmin = best->xcenter - best->scale;
+    double xmax = best->xcenter + best->scale;
+    double ymin = best->ycenter - best->scale;
+    double ymax = best->ycenter + best->scale;
+    int j;
+    for( j=yStart ; j<yEnd ; j++ )
+    {
+      // the rest of a cancelled request's tile is never sent, so it's given up on at once
+      if( best->cancelled )
+      {
+        break;
+      }
+      double y = ymin + j*(ymax-ymin)/best->height;
+      computeRow( best->theBitmap, j, xStart, xEnd, xmin, xmax, best->width, y, best->max, best->counts, LOCKED_WRITES );
+    }
+
+    pthread_mutex_lock( &SERVER.lock );
+    best->tilesLeft--;
+    if( best->tilesLeft == 0 )
+    {
+      unqueueRequest( best );
+      pthread_mutex_unlock( &SERVER.lock );
+      finishRequest( best );
+      pthread_mutex_lock( &SERVER.lock );
+    }
+  }
+  pthread_mutex_unlock( &SERVER.lock );
+
+  return NULL;
+} // serverWorker()
+
+/*
+ * function: 
+ *  cancelRequest
+ * 
+ * description: 
+ *  Marks a queued request cancelled so no more of its tiles are handed out. The tiles that were never 
+ *    handed out count as done, so if none are being computed right now the request is finished, and 
+ *    finishCancelledRequests() answers it. Otherwise the thread computing its last tile does.
+ *  The caller holds SERVER.lock.
+ * 
+ * parameters:
+ *  struct serverRequest * request: the request to cancel
+ * 
+ * returns: 
+ *  void
+ */
+static void cancelRequest( struct serverRequest * request )
+{
+  if( request->cancelled )
+  {
+    return;
+  }
+  request->cancelled = true;
+  request->tilesLeft -= request->tileCount - request->nextTile;
+  request->nextTile = request->tileCount;
+  if( request->level != NULL )
+  {
+    unscheduleRequest( request );
+  }
+} // cancelRequest()
+
+/*
+ * function: 
+ *  finishCancelledRequests
+ * 
+ * description: 
+ *  Takes every cancelled request with no tiles still being computed off of the queue and answers it.
+ *    They're all gathered in one pass over the queue and answered once the lock is let go.
+ * 
+ * parameters:
+ *  none
+ * 
+ * returns: 
+ *  void
+ */
+static void finishCancelledRequests( void )
+{
+  struct serverRequest * finished = NULL;
+
+  pthread_mutex_lock( &SERVER.lock );
+  struct serverRequest * pending = SERVER.queue;
+  while( pending != NULL )
+  {
+    struct serverRequest * following = pending->next;
+    if( pending->cancelled && pending->tilesLeft == 0 )
+    {
+      unqueueRequest( pending );
+      pending->next = finished;
+      finished = pending;
+    }
+    pending = following;
+  }
+  pthread_mutex_unlock( &SERVER.lock );
+
+  while( finished != NULL )
+  {
+    struct serverRequest * done = finished;
+    finished = done->next;
+    finishRequest( done );
+  }
+} // finishCancelledRequests()
+
+/*
+ * function: 
+ *  unqueueRequest
+ * 
+ * description: 
+ *  Takes a request off of SERVER's queue. The caller holds SERVER.lock.
+ * 
+ * parameters:
+ *  struct serverRequest * request: the request to take off
+ * 
+ * returns: 
+ *  void
+ */
+static void unqueueRequest( struct serverRequest * request )
+{
+  if( request->prev != NULL )
+  {
+    request->prev->next = request->next;
+  }
+  else
+  {
+    SERVER.queue = request->next;
+  }
+  if( request->next != NULL )
+  {
+    request->next->prev = request->prev;
+  }
+  request->prev = NULL;
+  request->next = NULL;
+  SERVER.served++;
+} // unqueueRequest()
+
+/*
+ * function: 
+ *  scheduleRequest
+ * 
+ * description: 
+ *  Puts a new request at the back of the line of its priority's level, adding the level in its place 
+ *    among SERVER's levels (highest priority first) if it isn't there. The caller holds SERVER.lock.
+ * 
+ * parameters:
+ *  struct serverRequest * request: the request, with tiles to hand out
+ * 
+ * returns: 
+ *  bool: false if there was no memory for a new level, otherwise true
+ */
+static bool scheduleRequest( struct serverRequest * request )
+{
+  struct serverLevel ** link;
+  for( link=&SERVER.levels ; *link!=NULL && (*link)->priority > request->priority ; link=&(*link)->next );
+
+  struct serverLevel * level = *link;
+  if( level == NULL || level->priority != request->priority )
+  {
+    level = calloc( 1, sizeof(struct serverLevel) );
+    if( level == NULL )
+    {
+      return false;
+    }
+    level->priority = request->priority;
+    level->next = *link;
+    *link = level;
+  }
+
+  request->level = level;
+  request->waitingPrev = level->tail;
+  request->waitingNext = NULL;
+  if( level->tail != NULL )
+  {
+    level->tail->waitingNext = request;
+  }
+  else
+  {
+    level->head = request;
+  }
+  level->tail = request;
+  return true;
+} // scheduleRequest()
+
+/*
+ * function: 
+ *  unscheduleRequest
+ * 
+ * description: 
+ *  Takes a request out of its level's line once it has no more tiles to hand out, and drops the 
+ *    level if that leaves it empty. The caller holds SERVER.lock.
+ * 
+ * parameters:
+ *  struct serverRequest * request: the request to take out
+ * 
+ * returns: 
+ *  void
+ */
+static void unscheduleRequest( struct serverRequest * request )
+{
+  struct serverLevel * level = request->level;
+  if( request->waitingPrev != NULL )
+  {
+    request->waitingPrev->waitingNext = request->waitingNext;
+  }
+  else
+  {
+    level->head = request->waitingNext;
+  }
+  if( request->waitingNext != NULL )
+  {
+    request->waitingNext->waitingPrev = request->waitingPrev;
+  }
+  else
+  {
+    level->tail = request->waitingPrev;
+  }
+  request->level = NULL;
+  request->waitingPrev = NULL;
+  request->waitingNext = NULL;
+
+  if( level->head == NULL )
+  {
+    struct serverLevel ** link;
+    for( link=&SERVER.levels ; *link!=level ; link=&(*link)->next );
+    *link = level->next;
+    free( level );
+  }
+} // unscheduleRequest()
+
+/*
+ * function: 
+ *  finishRequest
+ * 
+ * description: 
+ *  Answers a request that's off of the queue, with its image or with CANCELLED, and frees it. 
+ *    With -t the time it waited and the time it took are printed. The counts of a rendered image 
+ *    are put in the -k cache first.
+ * 
+ * parameters:
+ *  struct serverRequest * request: the finished request
+ * 
+ * returns: 
+ *  void
+ */
+static void finishRequest( struct serverRequest * request )
+{
+  struct serverClient * client = request->client;
+  struct timeval finished;
+  gettimeofday( &finished, NULL );
+
+  // the counts go in the cache before the answer goes out, so asking for the same view again once it's in hits
+  if( request->counts != NULL )
+  {
+    if( !request->cancelled )
+    {
+      storeCachedImage( request->key, request->counts );
+    }
+    iterfile_delete( request->counts );
+    request->counts = NULL;
+  }
+
+  pthread_mutex_lock( &client->lock );
+  if( request->cancelled )
+  {
+    fprintf( client->out, "CANCELLED %s\n", request->id );
+  }
+  else
+  {
+    fprintf( client->out, "OK %s %lld\n", request->id, bitmap_file_size( request->width, request->height ) );
+    bitmap_write( request->theBitmap, client->out );
+  }
+  fflush( client->out );
+  pthread_mutex_unlock( &client->lock );
+
+  if(TIMING)
+  {
+    printf( "mandel: client %d request %s (%dx%d, priority %d): %s in (in usec): %ld, queued for: %ld\n", client->number, request->id, 
+      request->width, request->height, request->priority, request->cancelled ? "cancelled" : "rendered", 
+      elapsedUsec( &request->received, &finished ), request->nextTile > 0 && !request->cancelled ? elapsedUsec( &request->received, &request->started ) : 0 );
+    fflush( stdout );
+  }
+
+  bitmap_delete( request->theBitmap );
+  free( request );
+  releaseClient( client );
+} // finishRequest()
+
+/*
+ * function: 
+ *  sendReply
+ * 
+ * description: 
+ *  Writes a one-line answer to a client, printf-style, without getting in the way of an image 
+ *    another thread may be writing to it.
+ * 
+ * parameters:
+ *  struct serverClient * client: the client to answer
+ *  const char * format: the printf format of the line
+ *  ...: its arguments
+ * 
+ * returns: 
+ *  void
+ */
+static void sendReply( struct serverClient * client, const char * format, ... )
+{
+  va_list arguments;
+  va_start( arguments, format );
+  pthread_mutex_lock( &client->lock );
+  vfprintf( client->out, format, arguments );
+  fflush( client->out );
+  pthread_mutex_unlock( &client->lock );
+  va_end( arguments );
+} // sendReply()
+
+/*
+ * function: 
+ *  releaseClient
+ * 
+ * description: 
+ *  Drops one reference to a client: its reader thread holds one, and every request of it still 
+ *    queued holds another. The last one to go closes the connection and frees the client.
+ * 
+ * parameters:
+ *  struct serverClient * client: the client
+ * 
+ * returns: 
+ *  void
+ */
+static void releaseClient( struct serverClient * client )
+{
+  pthread_mutex_lock( &client->lock );
+  bool last = --client->refs == 0;
+  pthread_mutex_unlock( &client->lock );
+
+  if( last )
+  {
+    fclose( client->out );
+    pthread_mutex_destroy( &client->lock );
+    free( client );
+
+    pthread_mutex_lock( &SERVER.lock );
+    pthread_cond_broadcast( &SERVER.clientGone );
+    pthread_mutex_unlock( &SERVER.lock );
+  }
+} // releaseClient()
+
+/*
+ * function: 
+ *  countWords
+ * 
+ * description: 
+ *  Counts the words of a request line, so a request with anything after its last field is refused.
+ * 
+ * parameters:
+ *  const char * line: the request line
+ * 
+ * returns: 
+ *  int: the number of whitespace-separated words in it
+ */
+static int countWords( const char * line )
+{
+  int words = 0;
+  bool inWord = false;
+  for( ; *line != '\0' ; line++ )
+  {
+    bool space = isspace( (unsigned char) *line );
+    if( !space && !inWord )
+    {
+      words++;
+    }
+    inWord = !space;
+  }
+  return words;
+} // countWords()
+
+/*
+ * function: 
+ *  startWorkerPool
+ * 
+ * description: 
+ *  Starts size persistent threads in WORKER_POOL, each waiting for spawnWorker() to hand it a job.
+ * 
+ * parameters:
+ *  int size: the number of threads to start
+ * 
+ * returns: 
+ *  bool: true if every thread was started, otherwise false (and no pool is running)
+ */
+static bool startWorkerPool( int size )
+{
+  WORKER_POOL.workers = (struct poolWorker *) calloc( size, sizeof(struct poolWorker) );
+  if( WORKER_POOL.workers == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> startWorkerPool(): calloc() for the pool's workers returned NULL\n");
+    }
+    return false;
+  }
+
+  int i;
+  for( i=0 ; i<size ; i++ )
+  {
+    struct poolWorker * worker = &WORKER_POOL.workers[i];
+    pthread_mutex_init( &worker->lock, NULL );
+    pthread_cond_init( &worker->changed, NULL );
+
+    int returnCode = pthread_create( &worker->thread, NULL, poolThread, (void *) worker );
+    if( returnCode != 0 )
+    {
+      if(DBG)
+      {
+        printf( "ERROR -> startWorkerPool(): pthread_create return code = %d: %s...\n", returnCode, strerror(returnCode) );
+      }
+      pthread_mutex_destroy( &worker->lock );
+      pthread_cond_destroy( &worker->changed );
+      stopWorkerPool();
+      return false;
+    }
+    WORKER_POOL.size = i+1;
+  }
+
+  if(DBG)
+  {
+    printf( "DEBUG: startWorkerPool(): %d threads started\n", size );
+  }
+  return true;
+} // startWorkerPool()
+
+/*
+ * function: 
+ *  stopWorkerPool
+ * 
+ * description: 
+ *  Tells every thread of WORKER_POOL to exit once it's idle, waits for them, and frees the pool.
+ *  Does nothing if no pool is running.
+ * 
+ * parameters:
+ *  none
+ * 
+ * returns: 
+ *  void
+ */
+static void stopWorkerPool( void )
+{
+  if( WORKER_POOL.workers == NULL )
+  {
+    return;
+  }
+
+  int i;
+  for( i=0 ; i<WORKER_POOL.size ; i++ )
+  {
+    struct poolWorker * worker = &WORKER_POOL.workers[i];
+    pthread_mutex_lock( &worker->lock );
+    worker->quit = true;
+    pthread_cond_broadcast( &worker->changed );
+    pthread_mutex_unlock( &worker->lock );
+  }
+
+  for( i=0 ; i<WORKER_POOL.size ; i++ )
+  {
+    struct poolWorker * worker = &WORKER_POOL.workers[i];
+    pthread_join( worker->thread, NULL );
+    pthread_mutex_destroy( &worker->lock );
+    pthread_cond_destroy( &worker->changed );
+  }
+
+  free( WORKER_POOL.workers );
+  WORKER_POOL.workers = NULL;
+  WORKER_POOL.size = 0;
+} // stopWorkerPool()
+
+/*
+ * function: 
+ *  poolThread
+ * 
+ * description: 
+ *  Entry point for the threads of WORKER_POOL. Waits for a job, runs it, marks itself idle again
+ *    so joinWorker() can return, and repeats until stopWorkerPool() tells it to quit.
+ * 
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type poolWorker
+ * 
+ * returns: 
+ *  void *
+ */
+void * poolThread( void * args )
+{
+  struct poolWorker * worker = args;
+
+  pthread_mutex_lock( &worker->lock );
+  while( true )
+  {
+    while( worker->job == NULL && !worker->quit )
+    {
+      pthread_cond_wait( &worker->changed, &worker->lock );
+    }
+    if( worker->job == NULL )
+    {
+      break;
+    }
+
+    void * (*job)( void * ) = worker->job;
+    void * jobArgs = worker->jobArgs;
+    pthread_mutex_unlock( &worker->lock );
+
+    job( jobArgs );
+
+    pthread_mutex_lock( &worker->lock );
+    worker->job = NULL;
+    worker->busy = false;
+    pthread_cond_broadcast( &worker->changed );
+  }
+  pthread_mutex_unlock( &worker->lock );
+
+  return NULL;
+} // poolThread()
+
+/*
+ * function: 
+ *  spawnWorker
+ * 
+ * description: 
+ *  Starts job(jobArgs) on a thread of its own, the same as pthread_create() would. If WORKER_POOL
+ *    is running, the job goes to the pool thread numbered slot instead of a new thread.
+ * 
+ * parameters:
+ *  int slot: which of the caller's threads this is, counting from 0
+ *  pthread_t * thread: receives the new thread's id when no pool is running
+ *  void * (*job)( void * ): the thread function to run
+ *  void * jobArgs: the argument to pass to it
+ * 
+ * returns: 
+ *  int: 0 on success, otherwise the error code from pthread_create()
+ */
+static int spawnWorker( int slot, pthread_t * thread, void * (*job)( void * ), void * jobArgs )
+{
+  if( slot >= WORKER_POOL.size )
+  {
+    return pthread_create( thread, NULL, job, jobArgs );
+  }
+
+  struct poolWorker * worker = &WORKER_POOL.workers[slot];
+  pthread_mutex_lock( &worker->lock );
+  worker->job = job;
+  worker->jobArgs = jobArgs;
+  worker->busy = true;
+  pthread_cond_broadcast( &worker->changed );
+  pthread_mutex_unlock( &worker->lock );
+  return 0;
+} // spawnWorker()
+
+/*
+ * function: 
+ *  joinWorker
+ * 
+ * description: 
+ *  Waits for a job started by spawnWorker() to finish, the same as pthread_join() would.
+ * 
+ * parameters:
+ *  int slot: the slot the job was started with
+ *  pthread_t thread: the thread id spawnWorker() returned, when no pool is running
+ * 
+ * returns: 
+ *  int: 0 on success, otherwise the error code from pthread_join()
+ */
+static int joinWorker( int slot, pthread_t thread )
+{
+  if( slot >= WORKER_POOL.size )
+  {
+    return pthread_join( thread, NULL );
+  }
+
+  struct poolWorker * worker = &WORKER_POOL.workers[slot];
+  pthread_mutex_lock( &worker->lock );
+  while( worker->busy )
+  {
+    pthread_cond_wait( &worker->changed, &worker->lock );
+  }
+  pthread_mutex_unlock( &worker->lock );
+  return 0;
+} // joinWorker()
+
+/*
+ * function: 
+ *  verifyImage
+ * 
+ * description: 
+ *  Renders the same image again into a new bitmap, the plain way resetRenderOptions() sets up: row-by-row 
+ *    bands, the default kernel and none of the shortcuts, then compares it pixel by pixel against the 
+ *    image that was just computed.
+ *  The reference goes through renderFrame() in the image's own PRECISION, since double-double and 
+ *    perturbation (or float) round differently from double, and that's not what's being verified.
+ * 
+ * parameters:
+ *  struct bitmap *bm: the image to check
+ *  double xcenter: the x coordinate of the image center
+ *  double ycenter: the y coordinate of the image center
+ *  const char * xcenterText: the x coordinate exactly as typed
+ *  const char * ycenterText: the y coordinate exactly as typed
+ *  double scale: the distance from the center to the edges of the image
+ *  int max: max # of recurrence relations to iterate
+ *  int threadsToUse: the number of threads to perform the exhaustive render
+ * 
+ * returns: 
+ *  long: the number of pixels that differ, or -1 if the exhaustive render couldn't be done
+ */
+static long verifyImage( struct bitmap * bm, double xcenter, double ycenter, const char * xcenterText, const char * ycenterText, double scale, int max, int threadsToUse )
+{
+  int width = bitmap_width(bm);
+  int totalHeight = bitmap_height(bm);
+
+  struct bitmap * reference = bitmap_create( width, totalHeight );
+  if( reference == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> verifyImage(): bitmap_create() for the reference image returned NULL\n");
+    }
+    return -1;
+  }
+
+  // switch every optimization off for the reference render, then put them back
+  struct renderOptions saved;
+  saveRenderOptions( &saved );
+  resetRenderOptions();
+
+  bool computed = renderFrame( reference, xcenter, ycenter, xcenterText, ycenterText, scale, max, threadsToUse );
+
+  restoreRenderOptions( &saved );
+
+  if( !computed )
+  {
+    bitmap_delete(reference);
+    return -1;
+  }
+
+  long mismatches = 0;
+  int i,j;
+  for( j=0 ; j<totalHeight ; j++ )
+  {
+    for( i=0 ; i<width ; i++ )
+    {
+      if( bitmap_get( bm, i, j ) != bitmap_get( reference, i, j ) )
+      {
+        if( DBG && mismatches < 10 )
+        {
+          printf( "DEBUG: verifyImage(): pixel (%d,%d) is %08x, expected %08x\n", i, j, bitmap_get( bm, i, j ), bitmap_get( reference, i, j ) );
+        }
+        mismatches++;
+      }
+    }
+  }
+
+  bitmap_delete(reference);
+  return mismatches;
+} // verifyImage()
+
+/*
+ * function: 
+ *  saveRenderOptions
+ * 
+ * description: 
+ *  copies every setting in struct renderOptions out of its global, to be put back with restoreRenderOptions()
+ * 
+ * parameters:
+ *  struct renderOptions * options: receives the settings
+ * 
+ * returns: 
+ *  void
+ */
+static void saveRenderOptions( struct renderOptions * options )
+{
+  options->scheduler = SCHEDULER;
+  options->tiledBands = TILED_BANDS;
+  options->progressive = PROGRESSIVE;
+  options->seriesReuse = SERIES_REUSE;
+  options->mirrorSymmetry = MIRROR_SYMMETRY;
+  options->aaSamples = AA_SAMPLES;
+  options->interiorCheck = INTERIOR_CHECK;
+  options->periodicityCheck = PERIODICITY_CHECK;
+  options->kernel = ESCAPE_KERNEL;
+  options->kernelName = ESCAPE_KERNEL_NAME;
+  options->floatKernel = FLOAT_KERNEL;
+  options->floatKernelName = FLOAT_KERNEL_NAME;
+  options->rawOutput = RAW_OUTPUT;
+  options->workLogFile = WORK_LOG_FILE;
+  options->costMap = COST_MAP;
+  options->timing = TIMING;
+} // saveRenderOptions()
+
+/*
+ * function: 
+ *  resetRenderOptions
+ * 
+ * description: 
+ *  Switches every setting in struct renderOptions to the plain exhaustive way of computing an image: 
+ *    one band per thread computed row by row with the default kernels, every pixel iterated without 
+ *    the -c/-P shortcuts, mirroring or anti-aliasing, and nothing gathered or timed along the way.
+ * 
+ * parameters:
+ *  none
+ * 
+ * returns: 
+ *  void
+ */
+static void resetRenderOptions( void )
+{
+  SCHEDULER = SCHED_BAND;
+  TILED_BANDS = false;
+  PROGRESSIVE = false;
+  SERIES_REUSE = false;
+  MIRROR_SYMMETRY = false;
+  AA_SAMPLES = 0;
+  INTERIOR_CHECK = false;
+  PERIODICITY_CHECK = false;
+  selectKernel( NULL );
+  RAW_OUTPUT = NULL;
+  WORK_LOG_FILE = NULL;
+  COST_MAP = NULL;
+  TIMING = false;
+} // resetRenderOptions()
+
+/*
+ * function: 
+ *  restoreRenderOptions
+ * 
+ * description: 
+ *  puts back every setting saveRenderOptions() copied
+ * 
+ * parameters:
+ *  const struct renderOptions * options: the settings to put back
+ * 
+ * returns: 
+ *  void
+ */
+static void restoreRenderOptions( const struct renderOptions * options )
+{
+  SCHEDULER = options->scheduler;
+  TILED_BANDS = options->tiledBands;
+  PROGRESSIVE = options->progressive;
+  SERIES_REUSE = options->seriesReuse;
+  MIRROR_SYMMETRY = options->mirrorSymmetry;
+  AA_SAMPLES = options->aaSamples;
+  INTERIOR_CHECK = options->interiorCheck;
+  PERIODICITY_CHECK = options->periodicityCheck;
+  ESCAPE_KERNEL = options->kernel;
+  ESCAPE_KERNEL_NAME = options->kernelName;
+  FLOAT_KERNEL = options->floatKernel;
+  FLOAT_KERNEL_NAME = options->floatKernelName;
+  RAW_OUTPUT = options->rawOutput;
+  WORK_LOG_FILE = options->workLogFile;
+  COST_MAP = options->costMap;
+  TIMING = options->timing;
+} // restoreRenderOptions()
+
+/*
+ * function: 
+ *  pushTile
+ * 
+ * description: 
+ *  Adds a tile to the tail of a deque, growing the deque's storage if it's full.
+ * 
+ * parameters:
+ *  struct tileDeque * deque: the deque to add to
+ *  struct tile * theTile: the tile to copy in
+ * 
+ * returns: 
+ *  bool: false if memory for the tile couldn't be allocated, otherwise true
+ */
+static bool pushTile( struct tileDeque * deque, struct tile * theTile )
+{
+  pthread_mutex_lock( &deque->lock );
+
+  if( deque->tail == deque->capacity )
+  {
+    // slide the live tiles back to the front before deciding whether more room is needed
+    int count = deque->tail - deque->head;
+    memmove( deque->tiles, deque->tiles + deque->head, count * sizeof(struct tile) );
+    deque->head = 0;
+    deque->tail = count;
+
+    if( count == deque->capacity )
+    {
+      int newCapacity = deque->capacity > 0 ? deque->capacity * 2 : 64;
+      struct tile * newTiles = (struct tile *) realloc( deque->tiles, newCapacity * sizeof(struct tile) );
+      if( newTiles == NULL )
+      {
+        pthread_mutex_unlock( &deque->lock );
+        return false;
+      }
+      deque->tiles = newTiles;
+      deque->capacity = newCapacity;
+    }
+  }
+
+  deque->tiles[deque->tail++] = *theTile;
+
+  pthread_mutex_unlock( &deque->lock );
+  return true;
+} // pushTile()
+
+/*
+ * function: 
+ *  popTile
+ * 
+ * description: 
+ *  Removes the most recently pushed tile from the tail of a deque. Only the owning thread calls this.
+ * 
+ * parameters:
+ *  struct tileDeque * deque: the deque to take from
+ *  struct tile * theTile: receives the tile that was removed
+ * 
+ * returns: 
+ *  bool: false if the deque was empty, otherwise true
+ */
+static bool popTile( struct tileDeque * deque, struct tile * theTile )
+{
+  bool found = false;
+
+  pthread_mutex_lock( &deque->lock );
+  if( deque->tail > deque->head )
+  {
+    *theTile = deque->tiles[--deque->tail];
+    found = true;
+  }
+  pthread_mutex_unlock( &deque->lock );
+
+  return found;
+} // popTile()
+
+/*
+ * function: 
+ *  stealTile
+ * 
+ * description: 
+ *  Looks through the other threads' deques, starting with the next thread over so thieves 
+ *    spread out instead of all hitting thread 0, and takes the oldest tile from the first non-empty one.
+ * 
+ * parameters:
+ *  struct tileScheduler * scheduler: the scheduler holding every thread's deque
+ *  int thiefId: the tid of the thread doing the stealing, whose own deque is skipped
+ *  struct tile * theTile: receives the tile that was stolen
+ * 
+ * returns: 
+ *  bool: false if every other deque was empty, otherwise true
+ */
+static bool stealTile( struct tileScheduler * scheduler, int thiefId, struct tile * theTile )
+{
+  int k;
+  for( k=1 ; k<scheduler->numDeques ; k++ )
+  {
+    struct tileDeque * victim = &scheduler->deques[( thiefId + k ) % scheduler->numDeques];
+    bool found = false;
+
+    pthread_mutex_lock( &victim->lock );
+    if( victim->tail > victim->head )
+    {
+      *theTile = victim->tiles[victim->head++];
+      found = true;
+    }
+    pthread_mutex_unlock( &victim->lock );
+
+    if( found )
+    {
+      return true;
+    }
+  }
+
+  return false;
+} // stealTile()
+
+/*
+ * function: 
+ *  announceTiles
+ * 
+ * description: 
+ *  Wakes the threads waiting in waitForTiles(), after tiles were pushed onto a deque or once the 
+ *    image is done (or abandoned).
+ * 
+ * parameters:
+ *  struct tileScheduler * scheduler: the scheduler the threads are waiting on
+ *  bool pushed: true if tiles were pushed, which is what the waiting threads check for
+ * 
+ * returns: 
+ *  void
+ */
+static void announceTiles( struct tileScheduler * scheduler, bool pushed )
+{
+  pthread_mutex_lock( &scheduler->lock );
+  if( pushed )
+  {
+    atomic_fetch_add( &scheduler->pushes, 1 );
+  }
+  pthread_cond_broadcast( &scheduler->changed );
+  pthread_mutex_unlock( &scheduler->lock );
+} // announceTiles()
+
+/*
+ * function: 
+ *  waitForTiles
+ * 
+ * description: 
+ *  Called by a thread that found every deque empty. Sleeps until tiles have been pushed since it 
+ *    started looking, or until there's nothing left to wait for.
+ * 
+ * parameters:
+ *  struct tileScheduler * scheduler: the scheduler holding every thread's deque
+ *  long pushesSeen: scheduler->pushes as it was before the thread looked at the deques
+ * 
+ * returns: 
+ *  void
+ */
+static void waitForTiles( struct tileScheduler * scheduler, long pushesSeen )
+{
+  pthread_mutex_lock( &scheduler->lock );
+  while( atomic_load( &scheduler->pushes ) == pushesSeen && atomic_load( &scheduler->pendingTiles ) > 0 && 
+    !atomic_load( &scheduler->abandoned ) )
+  {
+    pthread_cond_wait( &scheduler->changed, &scheduler->lock );
+  }
+  pthread_mutex_unlock( &scheduler->lock );
+} // waitForTiles()
+
+/*
+ * function: 
+ *  freeTileScheduler
+ * 
+ * description: 
+ *  Frees the deques of a scheduler set up by computeImageStealing(), along with its locks.
+ * 
+ * parameters:
+ *  struct tileScheduler * scheduler: the scheduler, which no thread is using anymore
+ * 
+ * returns: 
+ *  void
+ */
+static void freeTileScheduler( struct tileScheduler * scheduler )
+{
+  int i;
+  for( i=0 ; i<scheduler->numDeques ; i++ )
+  {
+    pthread_mutex_destroy( &scheduler->deques[i].lock );
+    free( scheduler->deques[i].tiles );
+  }
+  free( scheduler->deques );
+  pthread_cond_destroy( &scheduler->changed );
+  pthread_mutex_destroy( &scheduler->lock );
+} // freeTileScheduler()
+
+/*
+ * function: 
+ *  elapsedUsec
+ * 
+ * description: 
+ *  Calculates the number of microseconds between two gettimeofday() readings.
+ * 
+ * parameters:
+ *  struct timeval * start: the earlier reading
+ *  struct timeval * end: the later reading
+ * 
+ * returns: 
+ *  long: the elapsed time in microseconds
+ */
+static long elapsedUsec( struct timeval * start, struct timeval * end )
+{
+  return ( end->tv_sec - start->tv_sec ) * 1000000L + ( end->tv_usec - start->tv_usec );
+} // elapsedUsec()
+
+/*
+ * function: 
+ *  threadCpuUsec
+ * 
+ * description: 
+ *  Returns how much CPU time the calling thread has used so far, for -M. Unlike the wall time,
+ *    this doesn't grow while the thread is descheduled, so the two together show how much of
+ *    a thread's time the other threads and processes on the machine took from it.
+ * 
+ * parameters:
+ *  none
+ * 
+ * returns: 
+ *  long: the CPU time of the calling thread in microseconds, or 0 if it isn't available
+ */
+static long threadCpuUsec( void )
+{
+  struct timespec now;
+  if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now ) != 0 )
+  {
+    return 0;
+  }
+  return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+} // threadCpuUsec()
+
+/*
+ * function: 
+ *  logWork
+ * 
+ * description: 
+ *  Adds a record to WORK_LOG for -M: a band or tile one thread finished, or the total for a thread 
+ *    once it's done. The log is shared by all the threads, so it's locked while the record is added,
+ *    which happens once per band or tile and so stays well out of the way of the computation.
+ * 
+ * parameters:
+ *  enum workKind kind: whether the record is for a thread, a band or a tile
+ *  int thread: the id of the thread that did the work
+ *  int xStart, int yStart: the top left corner of the pixels the work covered
+ *  int xEnd, int yEnd: one past the bottom right corner of those pixels
+ *  long long iterations: the number of iterations spent on them
+ *  long wallUsec: how long the work took, in microseconds
+ *  long cpuUsec: how much CPU time the thread used for it, in microseconds
+ * 
+ * returns: 
+ *  void
+ */
+static void logWork( enum workKind kind, int thread, int xStart, int yStart, int xEnd, int yEnd, long long iterations, long wallUsec, long cpuUsec )
+{
+  pthread_mutex_lock( &WORK_LOG.lock );
+
+  if( WORK_LOG.count == WORK_LOG.capacity )
+  {
+    int newCapacity = WORK_LOG.capacity > 0 ? WORK_LOG.capacity * 2 : 256;
+    struct workRecord * grown = realloc( WORK_LOG.records, newCapacity * sizeof(struct workRecord) );
+    if( grown == NULL )
+    {
+      if(DBG)
+      {
+        printf("DEBUG: logWork(): realloc() for the work log returned NULL, dropping a record\n");
+      }
+      pthread_mutex_unlock( &WORK_LOG.lock );
+      return;
+    }
+    WORK_LOG.records = grown;
+    WORK_LOG.capacity = newCapacity;
+  }
+
+  struct workRecord * record = &WORK_LOG.records[WORK_LOG.count++];
+  record->kind = kind;
+  record->thread = thread;
+  record->xStart = xStart;
+  record->yStart = yStart;
+  record->xEnd = xEnd;
+  record->yEnd = yEnd;
+  record->iterations = iterations;
+  record->wallUsec = wallUsec;
+  record->cpuUsec = cpuUsec;
+
+  pthread_mutex_unlock( &WORK_LOG.lock );
+} // logWork()
+
+/*
+ * function: 
+ *  saveWorkLog
+ * 
+ * description: 
+ *  Saves WORK_LOG to a CSV file for -M, one record per line in the order they were finished, under 
+ *    the header line kind,thread,x_start,y_start,x_end,y_end,iterations,wall_usec,cpu_usec.
+ *  kind is thread, band or tile, and the pixel ranges include the start and exclude the end.
+ * 
+ * parameters:
+ *  const char * file: the file to write the log to
+ * 
+ * returns: 
+ *  bool: true if the log was saved, otherwise false
+ */
+static bool saveWorkLog( const char * file )
+{
+  FILE * out = fopen( file, "w" );
+  if( out == NULL )
+  {
+    return false;
+  }
+
+  fprintf( out, "kind,thread,x_start,y_start,x_end,y_end,iterations,wall_usec,cpu_usec\n" );
+  int r;
+  for( r=0 ; r<WORK_LOG.count ; r++ )
+  {
+    struct workRecord * record = &WORK_LOG.records[r];
+    fprintf( out, "%s,%d,%d,%d,%d,%d,%lld,%ld,%ld\n", WORK_KIND_NAMES[record->kind], record->thread, 
+      record->xStart, record->yStart, record->xEnd, record->yEnd, record->iterations, record->wallUsec, record->cpuUsec );
+  }
+
+  // fclose() flushes what's left, so a full disk may only show up here
+  bool written = !ferror( out );
+  if( fclose( out ) != 0 )
+  {
+    written = false;
+  }
+  return written;
+} // saveWorkLog()
+
+/*
+ * function: 
+ *  printWorkSummary
+ * 
+ * description: 
+ *  Prints how evenly the work in WORK_LOG was spread over the threads, for -M: the spread of the 
+ *    threads' busy time and the load imbalance, the slowest thread's busy time over the mean (1 is 
+ *    perfectly balanced, and the image took that much longer than it would have if it were), the 
+ *    same for the iterations each thread did, and the spread of iterations over the bands or tiles.
+ * 
+ * parameters:
+ *  none
+ * 
+ * returns: 
+ *  void
+ */
+static void printWorkSummary( void )
+{
+  int threads = 0;
+  long minWall = 0, maxWall = 0;
+  long long totalWall = 0, totalCpu = 0;
+  long long maxIters = 0, totalIters = 0;
+  int units = 0;
+  long long minUnitIters = 0, maxUnitIters = 0, totalUnitIters = 0;
+
+  int r;
+  for( r=0 ; r<WORK_LOG.count ; r++ )
+  {
+    struct workRecord * record = &WORK_LOG.records[r];
+    if( record->kind == WORK_THREAD )
+    {
+      if( threads == 0 || record->wallUsec < minWall )
+      {
+        minWall = record->wallUsec;
+      }
+      if( threads == 0 || record->wallUsec > maxWall )
+      {
+        maxWall = record->wallUsec;
+      }
+      if( threads == 0 || record->iterations > maxIters )
+      {
+        maxIters = record->iterations;
+      }
+      totalWall += record->wallUsec;
+      totalCpu += record->cpuUsec;
+      totalIters += record->iterations;
+      threads++;
+    }
+    else
+    {
+      if( units == 0 || record->iterations < minUnitIters )
+      {
+        minUnitIters = record->iterations;
+      }
+      if( units == 0 || record->iterations > maxUnitIters )
+      {
+        maxUnitIters = record->iterations;
+      }
+      totalUnitIters += record->iterations;
+      units++;
+    }
+  }
+
+  if( threads == 0 )
+  {
+    printf( "mandel: work: nothing was logged, -M only covers the band, steal and mariani schedulers\n" );
+    return;
+  }
+
+  double meanWall = (double) totalWall / threads;
+  double meanIters = (double) totalIters / threads;
+  printf( "mandel: work: %d threads busy for %.3f/%.3f/%.3f ms (min/mean/max), imbalance (max/mean) %.3f, cpu/wall %.3f\n", 
+    threads, minWall / 1000.0, meanWall / 1000.0, maxWall / 1000.0, meanWall > 0 ? maxWall / meanWall : 1.0, 
+    totalWall > 0 ? (double) totalCpu / totalWall : 1.0 );
+  printf( "mandel: work: %lld iterations, %.0f/%lld per thread (mean/max), imbalance (max/mean) %.3f\n", 
+    totalIters, meanIters, maxIters, meanIters > 0 ? maxIters / meanIters : 1.0 );
+  if( units > 0 )
+  {
+    printf( "mandel: work: %d %s, %lld/%.0f/%lld iterations each (min/mean/max)\n", 
+      units, SCHEDULER == SCHED_BAND ? "bands" : "tiles", minUnitIters, (double) totalUnitIters / units, maxUnitIters );
+  }
+} // printWorkSummary()
+
+/*
+ * function: 
+ *  saveCostMap
+ * 
+ * description: 
+ *  Saves COST_MAP as a heatmap bitmap for -G, showing where the iterations of the image were spent.
+ *  The costs are scaled logarithmically against the most expensive pixel, and run from black 
+ *    (no iterations at all, like pixels the cardioid check or the mariani fill skipped) through 
+ *    blue, red and yellow up to white.
+ * 
+ * parameters:
+ *  const char * file: the file to save the heatmap to
+ *  int width: the width of the image in pixels
+ *  int height: the height of the image in pixels
+ * 
+ * returns: 
+ *  bool: true if the heatmap was saved, otherwise false
+ */
+static bool saveCostMap( const char * file, int width, int height )
+{
+  struct bitmap * heatmap = bitmap_create( width, height );
+  if( heatmap == NULL )
+  {
+    return false;
+  }
+
+  int maxCost = 0;
+  size_t p;
+  for( p=0 ; p<(size_t) width * height ; p++ )
+  {
+    if( COST_MAP[p] > maxCost )
+    {
+      maxCost = COST_MAP[p];
+    }
+  }
+
+  // the colors the heatmap runs through, evenly spaced along the log scale
+  static const int ramp[][3] = { {0,0,0}, {0,0,255}, {255,0,0}, {255,255,0}, {255,255,255} };
+  int stops = sizeof(ramp) / sizeof(ramp[0]);
+
+  int * data = bitmap_data( heatmap );
+  for( p=0 ; p<(size_t) width * height ; p++ )
+  {
+    double t = maxCost > 0 ? log1p( COST_MAP[p] ) / log1p( maxCost ) : 0;
+    double position = t * ( stops - 1 );
+    int stop = (int) position;
+    if( stop >= stops - 1 )
+    {
+      stop = stops - 2;
+    }
+    double blend = position - stop;
+    int rgb[3];
+    int c;
+    for( c=0 ; c<3 ; c++ )
+    {
+      rgb[c] = (int) ( ramp[stop][c] + blend * ( ramp[stop+1][c] - ramp[stop][c] ) + 0.5 );
+    }
+    data[p] = MAKE_RGBA( rgb[0], rgb[1], rgb[2], 0 );
+  }
+
+  bool saved = bitmap_save( heatmap, file );
+  bitmap_delete( heatmap );
+  return saved;
+} // saveCostMap()
+
+/*
+ * function: 
+ *  computeRow
+ * 
+ * description: 
+ *  Computes pixels iStart up to (but not including) iEnd of row j and sets them in the bitmap.
+ *  The iterations come from computeRowIters() ROW_CHUNK pixels at a time, and are then 
+ *    converted to colors and written straight into the row.
+ *  The raw counts, escape magnitudes and orbits are also kept in counts when it's given (RAW_OUTPUT 
+ *    with -I, or a -F or -D image going into the -k cache), and with -G the iterations each pixel 
+ *    cost are kept in COST_MAP.
+ * 
+ * parameters:
+ *  struct bitmap * bm: the bitmap to set the pixels in
+ *  int j: the row of the bitmap being computed
+ *  int iStart: the first column to compute
+ *  int iEnd: one past the last column to compute
+ *  double xmin: the scaled left-bound of the image on the x-axis
+ *  double xmax: the scaled right-bound of the image on the x-axis
+ *  int width: the width of the whole image in pixels
+ *  double y: the y coordinate of row j
+ *  int max: max # of recurrence relations to iterate
+ *  struct iterfile * counts: where to keep the raw counts of the whole image, or NULL
+ *  bool lockWrites: lock bmpMutex around each bitmap_set() instead of writing to the row directly
+ * 
+ * returns: 
+ *  void
+ */
+static void computeRow( struct bitmap * bm, int j, int iStart, int iEnd, double xmin, double xmax, int width, double y, int max, struct iterfile * counts, bool lockWrites )
+{
+  int iters[ROW_CHUNK];
+  int * row = bitmap_data(bm) + (size_t) j * width;
+  int * rawIters = counts != NULL ? iterfile_iters(counts) + (size_t) j * width : NULL;
+  float * rawMagnitudes = counts != NULL ? iterfile_magnitudes(counts) + (size_t) j * width : NULL;
+  double * rawOrbitX = counts != NULL && iterfile_orbit_x(counts) != NULL ? iterfile_orbit_x(counts) + (size_t) j * width : NULL;
+  double * rawOrbitY = counts != NULL && iterfile_orbit_y(counts) != NULL ? iterfile_orbit_y(counts) + (size_t) j * width : NULL;
+  int * costs = COST_MAP != NULL ? COST_MAP + (size_t) j * width : NULL;
+
+  int i, k;
+  for( i=iStart ; i<iEnd ; i+=ROW_CHUNK )
+  {
+    int count = iEnd - i < ROW_CHUNK ? iEnd - i : ROW_CHUNK;
+
+    // Compute the iterations for this chunk of the row.
+    computeRowIters( iters, rawMagnitudes != NULL ? rawMagnitudes + i : NULL, rawOrbitX != NULL ? rawOrbitX + i : NULL, 
+      rawOrbitY != NULL ? rawOrbitY + i : NULL, costs != NULL ? costs + i : NULL, i, i+count, xmin, xmax, width, y, max );
+    if( rawIters != NULL )
+    {
+      memcpy( rawIters + i, iters, count * sizeof(int) );
+    }
+
+    // Set the pixels in the bitmap.
+    for( k=0 ; k<count ; k++ )
+    {
+      int color = iteration_to_color( iters[k], max );
+      if( lockWrites )
+      {
+        pthread_mutex_lock(&bmpMutex);
+        bitmap_set(bm,i+k,j,color);
+        pthread_mutex_unlock(&bmpMutex);
+      }
+      else
+      {
+        row[i+k] = color;
+      }
+    }
+  }
+} // computeRow()
+
+/*
+ * function: 
+ *  periodTolerance
+ * 
+ * description: 
+ *  Works out how close two orbit points have to be for the periodicity check to take them as the 
+ *    same, PERIOD_TOLERANCE_FACTOR of the spacing of the points being computed. Every kernel and 
+ *    scheduler gets its tolerance from here, so they all cut orbits short at the same point.
+ * 
+ * parameters:
+ *  double xmin: the scaled left-bound of the image on the x-axis
+ *  double xmax: the scaled right-bound of the image on the x-axis
+ *  int width: how many points are computed across it, pixels or (when supersampling) subpixels
+ * 
+ * returns: 
+ *  double: the tolerance, or 0 if the periodicity check is off
+ */
+static double periodTolerance( double xmin, double xmax, int width )
+{
+  return PERIODICITY_CHECK ? PERIOD_TOLERANCE_FACTOR * (xmax-xmin)/width : 0;
+} // periodTolerance()
+
+/*
+ * function: 
+ *  computeRowIters
+ * 
+ * description: 
+ *  Computes the iteration counts for pixels iStart up to (but not including) iEnd of a row,
+ *    handing them to computePointIters() ROW_CHUNK at a time so the SIMD kernels get enough 
+ *    neighbouring pixels to fill their lanes.
+ * 
+ * parameters:
+ *  int * iters: receives the iteration counts, iters[0] being the count for pixel iStart
+ *  float * magnitudes: if not NULL, receives the escape magnitudes the same way
+ *  double * orbitX, double * orbitY: if not NULL, receive the orbits of the pixels still inside the same way
+ *  int * costs: if not NULL, receives the iterations spent on each pixel the same way
+ *  int iStart: the first column to compute
+ *  int iEnd: one past the last column to compute
+ *  double xmin: the scaled left-bound of the image on the x-axis
+ *  double xmax: the scaled right-bound of the image on the x-axis
+ *  int width: the width of the whole image in pixels
+ *  double y: the y coordinate of the row
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  void
+ */
+static void computeRowIters( int * iters, float * magnitudes, double * orbitX, double * orbitY, int * costs, int iStart, int iEnd, double xmin, double xmax, int width, double y, int max )
+{
+  double xs[ROW_CHUNK];
+  double ys[ROW_CHUNK];
+  double tolerance = periodTolerance( xmin, xmax, width );
+
+  int i, k;
+  for( i=iStart ; i<iEnd ; i+=ROW_CHUNK )
+  {
+    int count = iEnd - i < ROW_CHUNK ? iEnd - i : ROW_CHUNK;
+
+    // Determine the point in x,y space for each pixel of the chunk.
+    for( k=0 ; k<count ; k++ )
+    {
+      xs[k] = xmin + (i+k)*(xmax-xmin)/width;
+      ys[k] = y;
+    }
+
+    computePointIters( xs, ys, count, 0, max, tolerance, iters + ( i - iStart ), magnitudes != NULL ? magnitudes + ( i - iStart ) : NULL,
+      orbitX != NULL ? orbitX + ( i - iStart ) : NULL, orbitY != NULL ? orbitY + ( i - iStart ) : NULL, 
+      costs != NULL ? costs + ( i - iStart ) : NULL );
+  }
+} // computeRowIters()
+
+/*
+ * function: 
+ *  computePointIters
+ * 
+ * description: 
+ *  Computes the iteration counts for up to ROW_CHUNK arbitrary points with the selected escape-time kernel.
+ *  If the interior check is enabled, points inside the main cardioid or period-2 bulb are set to 
+ *    max straight away and only the remaining points are packed together for the kernel.
+ *  The caller picks the periodicity tolerance with periodTolerance() (0 unless the check is 
+ *    enabled), so the check tightens along with the pixel spacing as the image zooms in.
+ * 
+ * parameters:
+ *  const double * xs: the x coordinates of the points
+ *  const double * ys: the y coordinates of the points
+ *  int count: how many points there are, at most ROW_CHUNK
+ *  int start: how many times the points have already been iterated, 0 for a fresh start
+ *  int max: max # of recurrence relations to iterate
+ *  double tolerance: the periodicity check tolerance, or 0 for no check
+ *  int * iters: receives the iteration count for each point
+ *  float * magnitudes: if not NULL, receives |z| for each point when it escaped, or 0
+ *  double * orbitX, double * orbitY: if not NULL, receive z for each point that hasn't escaped by max 
+ *    (NAN if it never will), and hold the z to carry on from when start is above 0
+ *  int * costs: if not NULL, receives the number of iterations spent on each point by this call
+ * 
+ * returns: 
+ *  void
+ */
+static void computePointIters( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY, int * costs )
+{
+  double kernelXs[ROW_CHUNK];
+  double kernelYs[ROW_CHUNK];
+  int kernelIters[ROW_CHUNK];
+  float kernelMagnitudes[ROW_CHUNK];
+  double kernelOrbitX[ROW_CHUNK];
+  double kernelOrbitY[ROW_CHUNK];
+  int kernelPoints[ROW_CHUNK];
+  int kernelCount = 0;
+  long shortCircuited = 0;
+
+  // keep only the points that actually need iterating
+  int k;
+  for( k=0 ; k<count ; k++ )
+  {
+    if( INTERIOR_CHECK && inCardioidOrBulb( xs[k], ys[k] ) )
+    {
+      iters[k] = max;
+      if( magnitudes != NULL )
+      {
+        magnitudes[k] = 0;
+      }
+      if( orbitX != NULL )
+      {
+        orbitX[k] = NAN;
+        orbitY[k] = NAN;
+      }
+      if( costs != NULL )
+      {
+        costs[k] = 0;
+      }
+      shortCircuited++;
+    }
+    else
+    {
+      kernelXs[kernelCount] = xs[k];
+      kernelYs[kernelCount] = ys[k];
+      if( orbitX != NULL )
+      {
+        kernelOrbitX[kernelCount] = orbitX[k];
+        kernelOrbitY[kernelCount] = orbitY[k];
+      }
+      kernelPoints[kernelCount] = k;
+      kernelCount++;
+    }
+  }
+
+  // Compute the iterations at those points, if any are left.
+  if( kernelCount > 0 )
+  {
+    ESCAPE_KERNEL( kernelXs, kernelYs, kernelCount, start, max, tolerance, kernelIters, magnitudes != NULL ? kernelMagnitudes : NULL,
+      orbitX != NULL ? kernelOrbitX : NULL, orbitX != NULL ? kernelOrbitY : NULL );
+  }
+  long long spent = 0;
+  for( k=0 ; k<kernelCount ; k++ )
+  {
+    iters[kernelPoints[k]] = kernelIters[k];
+    if( magnitudes != NULL )
+    {
+      magnitudes[kernelPoints[k]] = kernelMagnitudes[k];
+    }
+    if( orbitX != NULL && kernelIters[k] >= max )
+    {
+      orbitX[kernelPoints[k]] = kernelOrbitX[k];
+      orbitY[kernelPoints[k]] = kernelOrbitY[k];
+    }
+    if( costs != NULL )
+    {
+      costs[kernelPoints[k]] = kernelIters[k] - start;
+    }
+    spent += kernelIters[k] - start;
+  }
+  THREAD_ITERATIONS += spent;
+
+  if( shortCircuited > 0 )
+  {
+    atomic_fetch_add( &SHORT_CIRCUITED_PIXELS, shortCircuited );
+  }
+} // computePointIters()
+
+/*
+ * function: 
+ *  inCardioidOrBulb
+ * 
+ * description: 
+ *  Checks, in constant time, whether a point lies inside the main cardioid or the period-2 bulb 
+ *    of the Mandelbrot set. Points inside either one never escape, so iterations_at_point() 
+ *    would run them all the way to max.
+ * 
+ * parameters:
+ *  double x: the x coordinate of the point
+ *  double y: the y coordinate of the point
+ * 
+ * returns: 
+ *  bool: true if the point is inside the main cardioid or the period-2 bulb, otherwise false
+ */
+static bool inCardioidOrBulb( double x, double y )
+{
+  double ySquared = y*y;
+
+  // main cardioid: q*(q + (x - 1/4)) <= y^2/4, where q = (x - 1/4)^2 + y^2
+  double xShifted = x - 0.25;
+  double q = xShifted*xShifted + ySquared;
+  if( q * ( q + xShifted ) <= 0.25 * ySquared )
+  {
+    return true;
+  }
+
+  // period-2 bulb: the disc of radius 1/4 centered on -1
+  return ( x + 1.0 ) * ( x + 1.0 ) + ySquared <= 0.0625;
+} // inCardioidOrBulb()
+
+// every escape-time kernel compiled into this binary, widest first: AVX-512 (8 pixels at once, or 16 
+// in single precision), AVX2 (4 or 8), SSE2 (2 or 4), and the plain scalar loop that runs anywhere. 
+// All of them produce exactly the same iteration counts as iterations_at_point(), or in single 
+// precision, as float_iterations_at_point()
+static const struct kernelEntry KERNEL_REGISTRY[] = {
+#if defined(__x86_64__) || defined(__i386__)
+  { "avx512", escapeTimeAVX512, "avx512 float", escapeTimeFloatAVX512, FEATURE_AVX512F },
+  { "avx2", escapeTimeAVX2, "avx2 float", escapeTimeFloatAVX2, FEATURE_AVX2 },
+  { "sse2", escapeTimeSSE2, "sse2 float", escapeTimeFloatSSE2, FEATURE_SSE2 },
+#endif
+  { "scalar", escapeTimeScalar, "scalar float", escapeTimeFloatScalar, FEATURE_NONE }
+};
+
+/*
+ * function: 
+ *  selectKernel
+ * 
+ * description: 
+ *  Picks the escape-time kernel from KERNEL_REGISTRY: the first (widest) one the CPU and OS 
+ *    support, or the one with the given name when it's forced with -K, as long as it can run here.
+ *  Forcing a kernel is for benchmarking the kernels against each other and for tracking down 
+ *    which one an image that looks different came from.
+ * 
+ * parameters:
+ *  const char * name: the name of the kernel to use, or NULL for the best one the CPU supports
+ * 
+ * returns: 
+ *  bool: true if the kernel was selected, false if there's no kernel by that name or the CPU can't run it
+ */
+static bool selectKernel( const char * name )
+{
+  int count = sizeof(KERNEL_REGISTRY) / sizeof(KERNEL_REGISTRY[0]);
+  int k;
+  for( k=0 ; k<count ; k++ )
+  {
+    if( name == NULL ? cpuSupports( KERNEL_REGISTRY[k].feature ) : strcmp( name, KERNEL_REGISTRY[k].name ) == 0 )
+    {
+      break;
+    }
+  }
+
+  if( k == count || !cpuSupports( KERNEL_REGISTRY[k].feature ) )
+  {
+    if(DBG)
+    {
+      printf( "DEBUG: selectKernel(): the %s escape-time kernel %s\n", name, k == count ? "isn't compiled in" : "isn't supported by this CPU" );
+    }
+    return false;
+  }
+
+  ESCAPE_KERNEL = KERNEL_REGISTRY[k].kernel;
+  ESCAPE_KERNEL_NAME = KERNEL_REGISTRY[k].name;
+  FLOAT_KERNEL = KERNEL_REGISTRY[k].floatKernel;
+  FLOAT_KERNEL_NAME = KERNEL_REGISTRY[k].floatName;
+
+  if(DBG)
+  {
+    printf( "DEBUG: selectKernel(): using the %s escape-time kernel%s\n", ESCAPE_KERNEL_NAME, name != NULL ? " (forced with -K)" : "" );
+  }
+  return true;
+} // selectKernel()
+
+/*
+ * function: 
+ *  cpuSupports
+ * 
+ * description: 
+ *  Checks cpuid for a feature one of the kernels in KERNEL_REGISTRY needs. The compiler's checks 
+ *    also make sure the OS saves the wider registers, so a kernel that passes is safe to run.
+ * 
+ * parameters:
+ *  enum cpuFeature feature: the feature to check for
+ * 
+ * returns: 
+ *  bool: true if this CPU has the feature, or if the feature is FEATURE_NONE, otherwise false
+ */
+static bool cpuSupports( enum cpuFeature feature )
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  switch( feature )
+  {
+    case FEATURE_SSE2:
+      return __builtin_cpu_supports("sse2");
+    case FEATURE_AVX2:
+      return __builtin_cpu_supports("avx2");
+    case FEATURE_AVX512F:
+      return __builtin_cpu_supports("avx512f");
+    default:
+      break;
+  }
+#endif
+  return feature == FEATURE_NONE;
+} // cpuSupports()
+
+/*
+ * function: 
+ *  escapeTimeScalar
+ * 
+ * description: 
+ *  The reference escape-time kernel: runs iterations_at_point() (or periodic_iterations_at_point() 
+ *    when a tolerance is given) on each pixel one at a time. The SIMD kernels must match this exactly.
+ * 
+ * parameters:
+ *  const double * xs: the x coordinates of the pixels
+ *  const double * ys: the y coordinates of the pixels
+ *  int count: how many pixels there are
+ *  int start: how many times the pixels have already been iterated, 0 for a fresh start
+ *  int max: max # of recurrence relations to iterate
+ *  double tolerance: how close the orbit must come back to itself to count as periodic, or 0 for no check
+ *  int * iters: receives the iteration count for each pixel
+ *  float * magnitudes: if not NULL, receives |z| for each pixel when it escaped, or 0
+ *  double * orbitX, double * orbitY: if not NULL, receive z for each pixel that hasn't escaped 
+ *    by max (NAN if it never will), and hold the z to carry on from when start is above 0
+ * 
+ * returns: 
+ *  void
+ */
+static void escapeTimeScalar( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  int k;
+  for( k=0 ; k<count ; k++ )
+  {
+    // resumable renders need the orbit as well as the count
+    if( orbitX != NULL )
+    {
+      double zx = start > 0 ? orbitX[k] : xs[k];
+      double zy = start > 0 ? orbitY[k] : ys[k];
+      iters[k] = orbit_iterations_at_point( xs[k], ys[k], &zx, &zy, start, max, tolerance );
+      if( magnitudes != NULL )
+      {
+        magnitudes[k] = iters[k] < max ? (float) sqrt( zx*zx + zy*zy ) : 0;
+      }
+      if( iters[k] >= max )
+      {
+        orbitX[k] = zx;
+        orbitY[k] = zy;
+      }
+      continue;
+    }
+
+    if( tolerance > 0 )
+    {
+      iters[k] = periodic_iterations_at_point( xs[k], ys[k], max, tolerance );
+    }
+    else
+    {
+      iters[k] = iterations_at_point( xs[k], ys[k], max );
+    }
+
+    if( magnitudes != NULL )
+    {
+      magnitudes[k] = iters[k] < max ? escape_magnitude_at_point( xs[k], ys[k], iters[k] ) : 0;
+    }
+  }
+} // escapeTimeScalar()
+
+/*
+ * function: 
+ *  escapeTimeFloatScalar
+ * 
+ * description: 
+ *  The reference single-precision kernel: runs float_iterations_at_point() on each pixel one at 
+ *    a time. The single-precision SIMD kernels must match this exactly.
+ *  Single precision is only used when asked for with -p float, and orbits are only ever kept 
+ *    in double precision, so the single-precision kernels always start from scratch and leave 
+ *    the orbits alone.
+ * 
+ * parameters:
+ *  const double * xs: the x coordinates of the pixels, rounded to floats here
+ *  const double * ys: the y coordinates of the pixels, rounded to floats here
+ *  int count: how many pixels there are
+ *  int start: unused, single precision always starts from scratch
+ *  int max: max # of recurrence relations to iterate
+ *  double tolerance: how close the orbit must come back to itself to count as periodic, or 0 for no check
+ *  int * iters: receives the iteration count for each pixel
+ *  float * magnitudes: if not NULL, receives |z| for each pixel when it escaped, or 0
+ *  double * orbitX, double * orbitY: unused
+ * 
+ * returns: 
+ *  void
+ */
+static void escapeTimeFloatScalar( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  int k;
+  for( k=0 ; k<count ; k++ )
+  {
+    float magnitude;
+    iters[k] = float_iterations_at_point( (float) xs[k], (float) ys[k], max, (float) tolerance, &magnitude );
+    if( magnitudes != NULL )
+    {
+      magnitudes[k] = magnitude;
+    }
+  }
+} // escapeTimeFloatScalar()
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/*
+ * The SIMD kernels below iterate several pixels (usually neighbours on a row) in the lanes of one vector.
+ * Each lane follows exactly the same sequence of multiplies and adds as iterations_at_point(),
+ *   so their results are bit-for-bit identical to it (the Makefile turns off FMA contraction,
+ *   which would otherwise round differently). A lane that escapes is masked out of the 
+ *   count, and the vector stops once every lane has escaped or max has been reached.
+ * When count isn't a multiple of the lane width, the last vector is padded with copies 
+ *   of the final pixel and only the real lanes are stored.
+ * When magnitudes are wanted, each lane keeps |z|^2 from the last escape test it was still 
+ *   active for, which for an escaped lane is the test it failed.
+ * A lane that is still active when the loop reaches max hasn't escaped yet, so its z is handed back 
+ *   in the orbits for a later render to carry on from, and the lanes start from those when start is above 0.
+ * With a tolerance, each lane also runs the same periodicity check as periodic_iterations_at_point(),
+ *   comparing against a checkpoint that is saved for all lanes at once on power-of-two iterations.
+ */
+
+__attribute__((target("sse2")))
+static void escapeTimeSSE2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const __m128d four = _mm_set1_pd(4.0);
+  const __m128d two = _mm_set1_pd(2.0);
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d tol = _mm_set1_pd(tolerance);
+  const __m128d maxIters = _mm_set1_pd(max);
+  const __m128d signBit = _mm_set1_pd(-0.0);
+  bool checkPeriod = tolerance > 0;
+
+  int k, lane;
+  for( k=0 ; k<count ; k+=2 )
+  {
+    double laneXs[2];
+    double laneYs[2];
+    double laneIters[2];
+    double laneMagnitudes[2];
+    double laneZxs[2];
+    double laneZys[2];
+    for( lane=0 ; lane<2 ; lane++ )
+    {
+      int point = k+lane < count ? k+lane : count-1;
+      laneXs[lane] = xs[point];
+      laneYs[lane] = ys[point];
+      laneZxs[lane] = start > 0 ? orbitX[point] : xs[point];
+      laneZys[lane] = start > 0 ? orbitY[point] : ys[point];
+    }
+
+    __m128d x0 = _mm_loadu_pd(laneXs);
+    __m128d y0 = _mm_loadu_pd(laneYs);
+    __m128d zx = _mm_loadu_pd(laneZxs);
+    __m128d zy = _mm_loadu_pd(laneZys);
+    __m128d counts = _mm_set1_pd(start);
+    __m128d magnitudes2 = _mm_setzero_pd();
+    __m128d active = _mm_castsi128_pd( _mm_set1_epi32(-1) );
+    __m128d savedX = zx;
+    __m128d savedY = zy;
+
+    int iter;
+    for( iter=start ; iter<max ; iter++ )
+    {
+      __m128d xx = _mm_mul_pd(zx,zx);
+      __m128d yy = _mm_mul_pd(zy,zy);
+      __m128d zMag = _mm_add_pd(xx,yy);
+      if( magnitudes != NULL )
+      {
+        magnitudes2 = _mm_or_pd( _mm_andnot_pd(active,magnitudes2), _mm_and_pd(active,zMag) );
+      }
+      active = _mm_and_pd( active, _mm_cmple_pd( zMag, four ) );
+      if( _mm_movemask_pd(active) == 0 )
+      {
+        break;
+      }
+      counts = _mm_add_pd( counts, _mm_and_pd(active,one) );
+
+      __m128d xt = _mm_add_pd( _mm_sub_pd(xx,yy), x0 );
+      zy = _mm_add_pd( _mm_mul_pd( _mm_mul_pd(two,zx), zy ), y0 );
+      zx = xt;
+
+      if( checkPeriod )
+      {
+        __m128d closeX = _mm_cmplt_pd( _mm_andnot_pd( signBit, _mm_sub_pd(zx,savedX) ), tol );
+        __m128d closeY = _mm_cmplt_pd( _mm_andnot_pd( signBit, _mm_sub_pd(zy,savedY) ), tol );
+        __m128d periodic = _mm_and_pd( active, _mm_and_pd(closeX,closeY) );
+        counts = _mm_or_pd( _mm_andnot_pd(periodic,counts), _mm_and_pd(periodic,maxIters) );
+        active = _mm_andnot_pd( periodic, active );
+        if( ( (iter+1) & iter ) == 0 )
+        {
+          savedX = zx;
+          savedY = zy;
+        }
+      }
+    }
+
+    _mm_storeu_pd( laneIters, counts );
+    _mm_storeu_pd( laneMagnitudes, magnitudes2 );
+    _mm_storeu_pd( laneZxs, zx );
+    _mm_storeu_pd( laneZys, zy );
+    int stillActive = _mm_movemask_pd(active);
+    for( lane=0 ; lane<2 && k+lane<count ; lane++ )
+    {
+      iters[k+lane] = (int) laneIters[lane];
+      if( magnitudes != NULL )
+      {
+        magnitudes[k+lane] = iters[k+lane] < max ? (float) sqrt( laneMagnitudes[lane] ) : 0;
+      }
+      if( orbitX != NULL && iters[k+lane] >= max )
+      {
+        bool periodic = ( stillActive & ( 1 << lane ) ) == 0;
+        orbitX[k+lane] = periodic ? NAN : laneZxs[lane];
+        orbitY[k+lane] = periodic ? NAN : laneZys[lane];
+      }
+    }
+  }
+} // escapeTimeSSE2()
+
+__attribute__((target("avx2")))
+static void escapeTimeAVX2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d tol = _mm256_set1_pd(tolerance);
+  const __m256d maxIters = _mm256_set1_pd(max);
+  const __m256d signBit = _mm256_set1_pd(-0.0);
+  bool checkPeriod = tolerance > 0;
+
+  int k, lane;
+  for( k=0 ; k<count ; k+=4 )
+  {
+    double laneXs[4];
+    double laneYs[4];
+    double laneIters[4];
+    double laneMagnitudes[4];
+    double laneZxs[4];
+    double laneZys[4];
+    for( lane=0 ; lane<4 ; lane++ )
+    {
+      int point = k+lane < count ? k+lane : count-1;
+      laneXs[lane] = xs[point];
+      laneYs[lane] = ys[point];
+      laneZxs[lane] = start > 0 ? orbitX[point] : xs[point];
+      laneZys[lane] = start > 0 ? orbitY[point] : ys[point];
+    }
+
+    __m256d x0 = _mm256_loadu_pd(laneXs);
+    __m256d y0 = _mm256_loadu_pd(laneYs);
+    __m256d zx = _mm256_loadu_pd(laneZxs);
+    __m256d zy = _mm256_loadu_pd(laneZys);
+    __m256d counts = _mm256_set1_pd(start);
+    __m256d magnitudes2 = _mm256_setzero_pd();
+    __m256d active = _mm256_castsi256_pd( _mm256_set1_epi32(-1) );
+    __m256d savedX = zx;
+    __m256d savedY = zy;
+
+    int iter;
+    for( iter=start ; iter<max ; iter++ )
+    {
+      __m256d xx = _mm256_mul_pd(zx,zx);
+      __m256d yy = _mm256_mul_pd(zy,zy);
+      __m256d zMag = _mm256_add_pd(xx,yy);
+      if( magnitudes != NULL )
+      {
+        magnitudes2 = _mm256_blendv_pd( magnitudes2, zMag, active );
+      }
+      active = _mm256_and_pd( active, _mm256_cmp_pd( zMag, four, _CMP_LE_OQ ) );
+      if( _mm256_movemask_pd(active) == 0 )
+      {
+        break;
+      }
+      counts = _mm256_add_pd( counts, _mm256_and_pd(active,one) );
+
+      __m256d xt = _mm256_add_pd( _mm256_sub_pd(xx,yy), x0 );
+      zy = _mm256_add_pd( _mm256_mul_pd( _mm256_mul_pd(two,zx), zy ), y0 );
+      zx = xt;
+
+      if( checkPeriod )
+      {
+        __m256d closeX = _mm256_cmp_pd( _mm256_andnot_pd( signBit, _mm256_sub_pd(zx,savedX) ), tol, _CMP_LT_OQ );
+        __m256d closeY = _mm256_cmp_pd( _mm256_andnot_pd( signBit, _mm256_sub_pd(zy,savedY) ), tol, _CMP_LT_OQ );
+        __m256d periodic = _mm256_and_pd( active, _mm256_and_pd(closeX,closeY) );
+        counts = _mm256_blendv_pd( counts, maxIters, periodic );
+        active = _mm256_andnot_pd( periodic, active );
+        if( ( (iter+1) & iter ) == 0 )
+        {
+          savedX = zx;
+          savedY = zy;
+        }
+      }
+    }
+
+    _mm256_storeu_pd( laneIters, counts );
+    _mm256_storeu_pd( laneMagnitudes, magnitudes2 );
+    _mm256_storeu_pd( laneZxs, zx );
+    _mm256_storeu_pd( laneZys, zy );
+    int stillActive = _mm256_movemask_pd(active);
+    for( lane=0 ; lane<4 && k+lane<count ; lane++ )
+    {
+      iters[k+lane] = (int) laneIters[lane];
+      if( magnitudes != NULL )
+      {
+        magnitudes[k+lane] = iters[k+lane] < max ? (float) sqrt( laneMagnitudes[lane] ) : 0;
+      }
+      if( orbitX != NULL && iters[k+lane] >= max )
+      {
+        bool periodic = ( stillActive & ( 1 << lane ) ) == 0;
+        orbitX[k+lane] = periodic ? NAN : laneZxs[lane];
+        orbitY[k+lane] = periodic ? NAN : laneZys[lane];
+      }
+    }
+  }
+} // escapeTimeAVX2()
+
+__attribute__((target("avx512f")))
+static void escapeTimeAVX512( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const __m512d four = _mm512_set1_pd(4.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d tol = _mm512_set1_pd(tolerance);
+  const __m512d maxIters = _mm512_set1_pd(max);
+  bool checkPeriod = tolerance > 0;
+
+  int k, lane;
+  for( k=0 ; k<count ; k+=8 )
+  {
+    double laneXs[8];
+    double laneYs[8];
+    double laneIters[8];
+    double laneMagnitudes[8];
+    double laneZxs[8];
+    double laneZys[8];
+    for( lane=0 ; lane<8 ; lane++ )
+    {
+      int point = k+lane < count ? k+lane : count-1;
+      laneXs[lane] = xs[point];
+      laneYs[lane] = ys[point];
+      laneZxs[lane] = start > 0 ? orbitX[point] : xs[point];
+      laneZys[lane] = start > 0 ? orbitY[point] : ys[point];
+    }
+
+    __m512d x0 = _mm512_loadu_pd(laneXs);
+    __m512d y0 = _mm512_loadu_pd(laneYs);
+    __m512d zx = _mm512_loadu_pd(laneZxs);
+    __m512d zy = _mm512_loadu_pd(laneZys);
+    __m512d counts = _mm512_set1_pd(start);
+    __m512d magnitudes2 = _mm512_setzero_pd();
+    __mmask8 active = 0xff;
+    __m512d savedX = zx;
+    __m512d savedY = zy;
+
+    int iter;
+    for( iter=start ; iter<max ; iter++ )
+    {
+      __m512d xx = _mm512_mul_pd(zx,zx);
+      __m512d yy = _mm512_mul_pd(zy,zy);
+      __m512d zMag = _mm512_add_pd(xx,yy);
+      if( magnitudes != NULL )
+      {
+        magnitudes2 = _mm512_mask_mov_pd( magnitudes2, active, zMag );
+      }
+      active = _mm512_mask_cmp_pd_mask( active, zMag, four, _CMP_LE_OQ );
+      if( active == 0 )
+      {
+        break;
+      }
+      counts = _mm512_mask_add_pd( counts, active, counts, one );
+
+      __m512d xt = _mm512_add_pd( _mm512_sub_pd(xx,yy), x0 );
+      zy = _mm512_add_pd( _mm512_mul_pd( _mm512_mul_pd(two,zx), zy ), y0 );
+      zx = xt;
+
+      if( checkPeriod )
+      {
+        __mmask8 periodic = _mm512_mask_cmp_pd_mask( active, _mm512_abs_pd( _mm512_sub_pd(zx,savedX) ), tol, _CMP_LT_OQ );
+        periodic = _mm512_mask_cmp_pd_mask( periodic, _mm512_abs_pd( _mm512_sub_pd(zy,savedY) ), tol, _CMP_LT_OQ );
+        counts = _mm512_mask_mov_pd( counts, periodic, maxIters );
+        active &= ~periodic;
+        if( ( (iter+1) & iter ) == 0 )
+        {
+          savedX = zx;
+          savedY = zy;
+        }
+      }
+    }
+
+    _mm512_storeu_pd( laneIters, counts );
+    _mm512_storeu_pd( laneMagnitudes, magnitudes2 );
+    _mm512_storeu_pd( laneZxs, zx );
+    _mm512_storeu_pd( laneZys, zy );
+    int stillActive = active;
+    for( lane=0 ; lane<8 && k+lane<count ; lane++ )
+    {
+      iters[k+lane] = (int) laneIters[lane];
+      if( magnitudes != NULL )
+      {
+        magnitudes[k+lane] = iters[k+lane] < max ? (float) sqrt( laneMagnitudes[lane] ) : 0;
+      }
+      if( orbitX != NULL && iters[k+lane] >= max )
+      {
+        bool periodic = ( stillActive & ( 1 << lane ) ) == 0;
+        orbitX[k+lane] = periodic ? NAN : laneZxs[lane];
+        orbitY[k+lane] = periodic ? NAN : laneZys[lane];
+      }
+    }
+  }
+} // escapeTimeAVX512()
+
+/*
+ * The single-precision kernels below work the same way as the double ones above, with twice the lanes 
+ *   per vector, and match float_iterations_at_point() bit for bit. Their counts are kept as 32-bit ints 
+ *   (an active lane's mask is -1, so subtracting it counts the iteration), since a float count would 
+ *   stop being exact past 2^24 iterations. They always start from scratch and never touch the orbits.
+ */
+
+__attribute__((target("sse2")))
+static void escapeTimeFloatSSE2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const __m128 four = _mm_set1_ps(4.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 tol = _mm_set1_ps((float) tolerance);
+  const __m128 signBit = _mm_set1_ps(-0.0f);
+  const __m128i maxIters = _mm_set1_epi32(max);
+  bool checkPeriod = tolerance > 0;
+
+  int k, lane;
+  for( k=0 ; k<count ; k+=4 )
+  {
+    float laneXs[4];
+    float laneYs[4];
+    int laneIters[4];
+    float laneMagnitudes[4];
+    for( lane=0 ; lane<4 ; lane++ )
+    {
+      int point = k+lane < count ? k+lane : count-1;
+      laneXs[lane] = (float) xs[point];
+      laneYs[lane] = (float) ys[point];
+    }
+
+    __m128 x0 = _mm_loadu_ps(laneXs);
+    __m128 y0 = _mm_loadu_ps(laneYs);
+    __m128 zx = x0;
+    __m128 zy = y0;
+    __m128i counts = _mm_setzero_si128();
+    __m128 magnitudes2 = _mm_setzero_ps();
+    __m128 active = _mm_castsi128_ps( _mm_set1_epi32(-1) );
+    __m128 savedX = zx;
+    __m128 savedY = zy;
+
+    int iter;
+    for( iter=0 ; iter<max ; iter++ )
+    {
+      __m128 xx = _mm_mul_ps(zx,zx);
+      __m128 yy = _mm_mul_ps(zy,zy);
+      __m128 zMag = _mm_add_ps(xx,yy);
+      if( magnitudes != NULL )
+      {
+        magnitudes2 = _mm_or_ps( _mm_andnot_ps(active,magnitudes2), _mm_and_ps(active,zMag) );
+      }
+      active = _mm_and_ps( active, _mm_cmple_ps( zMag, four ) );
+      if( _mm_movemask_ps(active) == 0 )
+      {
+        break;
+      }
+      counts = _mm_sub_epi32( counts, _mm_castps_si128(active) );
+
+      __m128 xt = _mm_add_ps( _mm_sub_ps(xx,yy), x0 );
+      zy = _mm_add_ps( _mm_mul_ps( _mm_mul_ps(two,zx), zy ), y0 );
+      zx = xt;
+
+      if( checkPeriod )
+      {
+        __m128 closeX = _mm_cmplt_ps( _mm_andnot_ps( signBit, _mm_sub_ps(zx,savedX) ), tol );
+        __m128 closeY = _mm_cmplt_ps( _mm_andnot_ps( signBit, _mm_sub_ps(zy,savedY) ), tol );
+        __m128 periodic = _mm_and_ps( active, _mm_and_ps(closeX,closeY) );
+        __m128i periodicMask = _mm_castps_si128(periodic);
+        counts = _mm_or_si128( _mm_andnot_si128(periodicMask,counts), _mm_and_si128(periodicMask,maxIters) );
+        active = _mm_andnot_ps( periodic, active );
+        if( ( (iter+1) & iter ) == 0 )
+        {
+          savedX = zx;
+          savedY = zy;
+        }
+      }
+    }
+
+    _mm_storeu_si128( (__m128i *) laneIters, counts );
+    _mm_storeu_ps( laneMagnitudes, magnitudes2 );
+    for( lane=0 ; lane<4 && k+lane<count ; lane++ )
+    {
+      iters[k+lane] = laneIters[lane];
+      if( magnitudes != NULL )
+      {
+        magnitudes[k+lane] = iters[k+lane] < max ? sqrtf( laneMagnitudes[lane] ) : 0;
+      }
+    }
+  }
+} // escapeTimeFloatSSE2()
+
+__attribute__((target("avx2")))
+static void escapeTimeFloatAVX2( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const __m256 four = _mm256_set1_ps(4.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m256 tol = _mm256_set1_ps((float) tolerance);
+  const __m256 signBit = _mm256_set1_ps(-0.0f);
+  const __m256i maxIters = _mm256_set1_epi32(max);
+  bool checkPeriod = tolerance > 0;
+
+  int k, lane;
+  for( k=0 ; k<count ; k+=8 )
+  {
+    float laneXs[8];
+    float laneYs[8];
+    int laneIters[8];
+    float laneMagnitudes[8];
+    for( lane=0 ; lane<8 ; lane++ )
+    {
+      int point = k+lane < count ? k+lane : count-1;
+      laneXs[lane] = (float) xs[point];
+      laneYs[lane] = (float) ys[point];
+    }
+
+    __m256 x0 = _mm256_loadu_ps(laneXs);
+    __m256 y0 = _mm256_loadu_ps(laneYs);
+    __m256 zx = x0;
+    __m256 zy = y0;
+    __m256i counts = _mm256_setzero_si256();
+    __m256 magnitudes2 = _mm256_setzero_ps();
+    __m256 active = _mm256_castsi256_ps( _mm256_set1_epi32(-1) );
+    __m256 savedX = zx;
+    __m256 savedY = zy;
+
+    int iter;
+    for( iter=0 ; iter<max ; iter++ )
+    {
+      __m256 xx = _mm256_mul_ps(zx,zx);
+      __m256 yy = _mm256_mul_ps(zy,zy);
+      __m256 zMag = _mm256_add_ps(xx,yy);
+      if( magnitudes != NULL )
+      {
+        magnitudes2 = _mm256_blendv_ps( magnitudes2, zMag, active );
+      }
+      active = _mm256_and_ps( active, _mm256_cmp_ps( zMag, four, _CMP_LE_OQ ) );
+      if( _mm256_movemask_ps(active) == 0 )
+      {
+        break;
+      }
+      counts = _mm256_sub_epi32( counts, _mm256_castps_si256(active) );
+
+      __m256 xt = _mm256_add_ps( _mm256_sub_ps(xx,yy), x0 );
+      zy = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps(two,zx), zy ), y0 );
+      zx = xt;
+
+      if( checkPeriod )
+      {
+        __m256 closeX = _mm256_cmp_ps( _mm256_andnot_ps( signBit, _mm256_sub_ps(zx,savedX) ), tol, _CMP_LT_OQ );
+        __m256 closeY = _mm256_cmp_ps( _mm256_andnot_ps( signBit, _mm256_sub_ps(zy,savedY) ), tol, _CMP_LT_OQ );
+        __m256 periodic = _mm256_and_ps( active, _mm256_and_ps(closeX,closeY) );
+        counts = _mm256_blendv_epi8( counts, maxIters, _mm256_castps_si256(periodic) );
+        active = _mm256_andnot_ps( periodic, active );
+        if( ( (iter+1) & iter ) == 0 )
+        {
+          savedX = zx;
+          savedY = zy;
+        }
+      }
+    }
+
+    _mm256_storeu_si256( (__m256i *) laneIters, counts );
+    _mm256_storeu_ps( laneMagnitudes, magnitudes2 );
+    for( lane=0 ; lane<8 && k+lane<count ; lane++ )
+    {
+      iters[k+lane] = laneIters[lane];
+      if( magnitudes != NULL )
+      {
+        magnitudes[k+lane] = iters[k+lane] < max ? sqrtf( laneMagnitudes[lane] ) : 0;
+      }
+    }
+  }
+} // escapeTimeFloatAVX2()
+
+__attribute__((target("avx512f")))
+static void escapeTimeFloatAVX512( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const __m512 four = _mm512_set1_ps(4.0f);
+  const __m512 two = _mm512_set1_ps(2.0f);
+  const __m512 tol = _mm512_set1_ps((float) tolerance);
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i maxIters = _mm512_set1_epi32(max);
+  bool checkPeriod = tolerance > 0;
+
+  int k, lane;
+  for( k=0 ; k<count ; k+=16 )
+  {
+    float laneXs[16];
+    float laneYs[16];
+    int laneIters[16];
+    float laneMagnitudes[16];
+    for( lane=0 ; lane<16 ; lane++ )
+    {
+      int point = k+lane < count ? k+lane : count-1;
+      laneXs[lane] = (float) xs[point];
+      laneYs[lane] = (float) ys[point];
+    }
+
+    __m512 x0 = _mm512_loadu_ps(laneXs);
+    __m512 y0 = _mm512_loadu_ps(laneYs);
+    __m512 zx = x0;
+    __m512 zy = y0;
+    __m512i counts = _mm512_setzero_si512();
+    __m512 magnitudes2 = _mm512_setzero_ps();
+    __mmask16 active = 0xffff;
+    __m512 savedX = zx;
+    __m512 savedY = zy;
+
+    int iter;
+    for( iter=0 ; iter<max ; iter++ )
+    {
+      __m512 xx = _mm512_mul_ps(zx,zx);
+      __m512 yy = _mm512_mul_ps(zy,zy);
+      __m512 zMag = _mm512_add_ps(xx,yy);
+      if( magnitudes != NULL )
+      {
+        magnitudes2 = _mm512_mask_mov_ps( magnitudes2, active, zMag );
+      }
+      active = _mm512_mask_cmp_ps_mask( active, zMag, four, _CMP_LE_OQ );
+      if( active == 0 )
+      {
+        break;
+      }
+      counts = _mm512_mask_add_epi32( counts, active, counts, one );
+
+      __m512 xt = _mm512_add_ps( _mm512_sub_ps(xx,yy), x0 );
+      zy = _mm512_add_ps( _mm512_mul_ps( _mm512_mul_ps(two,zx), zy ), y0 );
+      zx = xt;
+
+      if( checkPeriod )
+      {
+        __mmask16 periodic = _mm512_mask_cmp_ps_mask( active, _mm512_abs_ps( _mm512_sub_ps(zx,savedX) ), tol, _CMP_LT_OQ );
+        periodic = _mm512_mask_cmp_ps_mask( periodic, _mm512_abs_ps( _mm512_sub_ps(zy,savedY) ), tol, _CMP_LT_OQ );
+        counts = _mm512_mask_mov_epi32( counts, periodic, maxIters );
+        active &= ~periodic;
+        if( ( (iter+1) & iter ) == 0 )
+        {
+          savedX = zx;
+          savedY = zy;
+        }
+      }
+    }
+
+    _mm512_storeu_si512( laneIters, counts );
+    _mm512_storeu_ps( laneMagnitudes, magnitudes2 );
+    for( lane=0 ; lane<16 && k+lane<count ; lane++ )
+    {
+      iters[k+lane] = laneIters[lane];
+      if( magnitudes != NULL )
+      {
+        magnitudes[k+lane] = iters[k+lane] < max ? sqrtf( laneMagnitudes[lane] ) : 0;
+      }
+    }
+  }
+} // escapeTimeFloatAVX512()
+
+#endif
+
+/*
+ * function: 
+ *  computeReferenceOrbit
+ * 
+ * description: 
+ *  Iterates the image center in HP_LIMBS-limb fixed-point arithmetic, starting from 0, and stores 
+ *    each orbit point rounded to doubles in REFERENCE_ORBIT for escapeTimePerturbation() to use.
+ *  The orbit runs for max+1 steps, or until it escapes, whichever comes first.
+ * 
+ * parameters:
+ *  const char * xText: the x coordinate of the image center, as typed on the command line
+ *  const char * yText: the y coordinate of the image center, as typed on the command line
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  bool: false if memory for the orbit couldn't be allocated, otherwise true
+ */
+static bool computeReferenceOrbit( const char * xText, const char * yText, int max )
+{
+  struct hpNumber cx, cy;
+  hpFromCoordinate( xText, &cx );
+  hpFromCoordinate( yText, &cy );
+
+  free( REFERENCE_ORBIT.x );
+  free( REFERENCE_ORBIT.y );
+  REFERENCE_ORBIT.x = (double *) malloc( ( (size_t) max + 2 ) * sizeof(double) );
+  REFERENCE_ORBIT.y = (double *) malloc( ( (size_t) max + 2 ) * sizeof(double) );
+  if( REFERENCE_ORBIT.x == NULL || REFERENCE_ORBIT.y == NULL )
+  {
+    if(DBG)
+    {
+      printf("ERROR -> computeReferenceOrbit(): malloc() for the orbit returned NULL\n");
+    }
+    return false;
+  }
+
+  struct hpNumber zx, zy, xx, yy, xy, diff;
+  memset( &zx, 0, sizeof(zx) );
+  memset( &zy, 0, sizeof(zy) );
+
+  int m;
+  for( m=0 ; m<=max+1 ; m++ )
+  {
+    double x = hpToDouble( &zx );
+    double y = hpToDouble( &zy );
+    if( x*x + y*y > 4 )
+    {
+      break;
+    }
+    REFERENCE_ORBIT.x[m] = x;
+    REFERENCE_ORBIT.y[m] = y;
+
+    // z = z^2 + c, with 2xy done as xy + xy
+    hpMul( &zx, &zx, &xx );
+    hpMul( &zy, &zy, &yy );
+    hpMul( &zx, &zy, &xy );
+    hpSub( &xx, &yy, &diff );
+    hpAdd( &diff, &cx, &zx );
+    hpAdd( &xy, &xy, &diff );
+    hpAdd( &diff, &cy, &zy );
+  }
+  REFERENCE_ORBIT.length = m;
+
+  if(DBG)
+  {
+    printf( "DEBUG: computeReferenceOrbit(): reference orbit has %d points\n", REFERENCE_ORBIT.length );
+  }
+
+  return true;
+} // computeReferenceOrbit()
+
+/*
+ * function: 
+ *  selectPrecision
+ * 
+ * description: 
+ *  The auto precision selector. Compares the pixel spacing of the image against the size of the 
+ *    numbers being iterated (the center coordinates, or the escape radius of 2 if those are smaller) 
+ *    and picks the cheapest arithmetic that can still tell neighbouring pixels apart reliably:
+ *    double, then double-double, then perturbation for anything deeper. Each one's limit grows with 
+ *    max, since a longer orbit gathers more rounding error. With -d it says why it picked it.
+ *  Float is left out, since its results drift from double's as max grows (see DOUBLE_MIN_RELATIVE_SPACING).
+ * 
+ * parameters:
+ *  double xcenter: the x coordinate of the image center
+ *  double ycenter: the y coordinate of the image center
+ *  double scale: the scale of the image
+ *  int width: the width of the image in pixels
+ *  int height: the height of the image in pixels
+ *  int max: max # of recurrence relations to iterate
+ * 
+ * returns: 
+ *  enum precisionType: the arithmetic to use
+ */
+static enum precisionType selectPrecision( double xcenter, double ycenter, double scale, int width, int height, int max )
+{
+  double pixelSpacing = 2 * scale / ( width > height ? width : height );
+  double magnitude = fmax( 2.0, fmax( fabs(xcenter), fabs(ycenter) ) );
+  double relativeSpacing = pixelSpacing / magnitude;
+  double doubleLimit = fmax( DOUBLE_MIN_RELATIVE_SPACING, max * DOUBLE_ERROR_PER_ITERATION );
+  double doubleDoubleLimit = fmax( DOUBLEDOUBLE_MIN_RELATIVE_SPACING, max * DOUBLEDOUBLE_ERROR_PER_ITERATION );
+
+  enum precisionType selected = PRECISION_PERTURB;
+  double limit = doubleDoubleLimit;
+  if( relativeSpacing >= doubleLimit )
+  {
+    selected = PRECISION_DOUBLE;
+    limit = doubleLimit;
+  }
+  else if( relativeSpacing >= doubleDoubleLimit )
+  {
+    selected = PRECISION_DOUBLEDOUBLE;
+  }
+
+  if(DBG)
+  {
+    if( selected == PRECISION_PERTURB )
+    {
+      printf( "DEBUG: selectPrecision(): relative pixel spacing %g is below the dd limit of %g for max %d, using perturb precision\n", 
+        relativeSpacing, limit, max );
+    }
+    else
+    {
+      printf( "DEBUG: selectPrecision(): relative pixel spacing %g is at or above the %s limit of %g for max %d, using %s precision\n", 
+        relativeSpacing, PRECISION_NAMES[selected], limit, max, PRECISION_NAMES[selected] );
+    }
+  }
+
+  return selected;
+} // selectPrecision()
+
+/*
+ * function: 
+ *  hpFromCoordinate
+ * 
+ * description: 
+ *  Converts a center coordinate, as typed on the command line, into a high-precision number.
+ *  Anything that isn't a plain decimal number (exponents, for instance) only gets a double's precision.
+ * 
+ * parameters:
+ *  const char * text: the coordinate as typed
+ *  struct hpNumber * result: receives the converted coordinate
+ * 
+ * returns: 
+ *  void
+ */
+static void hpFromCoordinate( const char * text, struct hpNumber * result )
+{
+  if( !hpFromString( text, result ) )
+  {
+    hpFromDouble( atof(text), result );
+  }
+} // hpFromCoordinate()
+
+/*
+ * function: 
+ *  setDoubleDoubleCenter
+ * 
+ * description: 
+ *  Converts the center coordinates, as typed on the command line, into the double-double
+ *    DD_CENTER_X and DD_CENTER_Y used by escapeTimeDoubleDouble().
+ * 
+ * parameters:
+ *  const char * xText: the x coordinate of the image center
+ *  const char * yText: the y coordinate of the image center
+ * 
+ * returns: 
+ *  void
+ */
+static void setDoubleDoubleCenter( const char * xText, const char * yText )
+{
+  struct hpNumber center, hiPart, remainder;
+
+  // hi is the center rounded to a double, and lo is whatever is left over
+  hpFromCoordinate( xText, &center );
+  DD_CENTER_X.hi = hpToDouble( &center );
+  hpFromDouble( DD_CENTER_X.hi, &hiPart );
+  hpSub( &center, &hiPart, &remainder );
+  DD_CENTER_X.lo = hpToDouble( &remainder );
+
+  hpFromCoordinate( yText, &center );
+  DD_CENTER_Y.hi = hpToDouble( &center );
+  hpFromDouble( DD_CENTER_Y.hi, &hiPart );
+  hpSub( &center, &hiPart, &remainder );
+  DD_CENTER_Y.lo = hpToDouble( &remainder );
+} // setDoubleDoubleCenter()
+
+/*
+ * The double-double building blocks. These rely on every operation being rounded to double
+ * exactly once, which the Makefile's -ffp-contract=off (and x86-64's SSE arithmetic) guarantee.
+ */
+
+// a + b exactly, as a double-double
+static inline struct doubleDouble ddTwoSum( double a, double b )
+{
+  struct doubleDouble result;
+  result.hi = a + b;
+  double bVirtual = result.hi - a;
+  result.lo = ( a - ( result.hi - bVirtual ) ) + ( b - bVirtual );
+  return result;
+}
+
+// a + b exactly, when |a| >= |b|
+static inline struct doubleDouble ddQuickTwoSum( double a, double b )
+{
+  struct doubleDouble result;
+  result.hi = a + b;
+  result.lo = b - ( result.hi - a );
+  return result;
+}
+
+// a * b exactly, as a double-double, using Dekker's split so no FMA is needed
+static inline struct doubleDouble ddTwoProd( double a, double b )
+{
+  const double splitter = 134217729.0; // 2^27 + 1
+  double aSplit = splitter * a;
+  double aHi = aSplit - ( aSplit - a );
+  double aLo = a - aHi;
+  double bSplit = splitter * b;
+  double bHi = bSplit - ( bSplit - b );
+  double bLo = b - bHi;
+
+  struct doubleDouble result;
+  result.hi = a * b;
+  result.lo = ( ( aHi*bHi - result.hi ) + aHi*bLo + aLo*bHi ) + aLo*bLo;
+  return result;
+}
+
+static inline struct doubleDouble ddAdd( struct doubleDouble a, struct doubleDouble b )
+{
+  struct doubleDouble sum = ddTwoSum( a.hi, b.hi );
+  struct doubleDouble lowSum = ddTwoSum( a.lo, b.lo );
+  sum.lo += lowSum.hi;
+  sum = ddQuickTwoSum( sum.hi, sum.lo );
+  sum.lo += lowSum.lo;
+  return ddQuickTwoSum( sum.hi, sum.lo );
+}
+
+static inline struct doubleDouble ddSub( struct doubleDouble a, struct doubleDouble b )
+{
+  b.hi = -b.hi;
+  b.lo = -b.lo;
+  return ddAdd( a, b );
+}
+
+static inline struct doubleDouble ddMul( struct doubleDouble a, struct doubleDouble b )
+{
+  struct doubleDouble product = ddTwoProd( a.hi, b.hi );
+  product.lo += a.hi*b.lo + a.lo*b.hi;
+  return ddQuickTwoSum( product.hi, product.lo );
+}
+
+/*
+ * function: 
+ *  escapeTimeDoubleDouble
+ * 
+ * description: 
+ *  The mid-depth kernel: the same loop as iterations_at_point(), but in double-double arithmetic, 
+ *    which is roughly twice as many digits as a double for somewhere around ten times the work.
+ *  Like the perturbation kernel, xs and ys are offsets from the image center (DD_CENTER_X, DD_CENTER_Y), 
+ *    since absolute coordinates this deep would already have lost their low digits as doubles.
+ * 
+ * parameters:
+ *  const double * xs: the x offsets of the pixels from the image center
+ *  const double * ys: the y offsets of the pixels from the image center
+ *  int count: how many pixels there are
+ *  int start: unused, always 0, since only double precision renders can be resumed
+ *  int max: max # of recurrence relations to iterate
+ *  double tolerance: unused, the periodicity check doesn't apply here
+ *  int * iters: receives the iteration count for each pixel
+ *  float * magnitudes: if not NULL, receives |z| for each pixel when it escaped, or 0
+ *  double * orbitX: unused, always NULL
+ *  double * orbitY: unused, always NULL
+ * 
+ * returns: 
+ *  void
+ */
+static void escapeTimeDoubleDouble( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  int k;
+  for( k=0 ; k<count ; k++ )
+  {
+    struct doubleDouble offsetX = { xs[k], 0 };
+    struct doubleDouble offsetY = { ys[k], 0 };
+    struct doubleDouble x0 = ddAdd( DD_CENTER_X, offsetX );
+    struct doubleDouble y0 = ddAdd( DD_CENTER_Y, offsetY );
+    struct doubleDouble x = x0;
+    struct doubleDouble y = y0;
+
+    int iter = 0;
+    float magnitude = 0;
+    while( iter < max )
+    {
+      struct doubleDouble xx = ddMul( x, x );
+      struct doubleDouble yy = ddMul( y, y );
+
+      // the escape test doesn't need the low parts
+      if( xx.hi + yy.hi > 4 )
+      {
+        magnitude = (float) sqrt( xx.hi + yy.hi );
+        break;
+      }
+
+      struct doubleDouble xy = ddMul( x, y );
+      x = ddAdd( ddSub( xx, yy ), x0 );
+      y = ddAdd( ddAdd( xy, xy ), y0 );
+
+      iter++;
+    }
+
+    iters[k] = iter;
+    if( magnitudes != NULL )
+    {
+      magnitudes[k] = magnitude;
+    }
+  }
+} // escapeTimeDoubleDouble()
+
+/*
+ * function: 
+ *  escapeTimePerturbation
+ * 
+ * description: 
+ *  The deep-zoom kernel. Instead of absolute coordinates, xs and ys are each pixel's offset (dc) from 
+ *    the image center, and the pixel's orbit is tracked as an offset (d) from the reference orbit Z:
+ *      d' = (2Z + d)d + dc
+ *    which only involves small numbers, so doubles stay accurate however deep the zoom is.
+ *  When the pixel's orbit z = Z + d gets closer to 0 than d itself, or the reference orbit runs out,
+ *    the offset can no longer be trusted to track the reference (a glitch), so the pixel is rebased:
+ *    d becomes z and the reference restarts from its first point, which is 0.
+ *  Iteration counts follow iterations_at_point(), which starts at z = c rather than z = 0.
+ * 
+ * parameters:
+ *  const double * xs: the x offsets of the pixels from the image center
+ *  const double * ys: the y offsets of the pixels from the image center
+ *  int count: how many pixels there are
+ *  int start: unused, always 0, since only double precision renders can be resumed
+ *  int max: max # of recurrence relations to iterate
+ *  double tolerance: unused, the periodicity check doesn't apply here
+ *  int * iters: receives the iteration count for each pixel
+ *  float * magnitudes: if not NULL, receives |z| for each pixel when it escaped, or 0
+ *  double * orbitX: unused, always NULL
+ *  double * orbitY: unused, always NULL
+ * 
+ * returns: 
+ *  void
+ */
+static void escapeTimePerturbation( const double * xs, const double * ys, int count, int start, int max, double tolerance, int * iters, float * magnitudes, double * orbitX, double * orbitY )
+{
+  const double * refX = REFERENCE_ORBIT.x;
+  const double * refY = REFERENCE_ORBIT.y;
+  int refLast = REFERENCE_ORBIT.length - 1;
+  long rebases = 0;
+
+  int k;
+  for( k=0 ; k<count ; k++ )
+  {
+    double dcx = xs[k];
+    double dcy = ys[k];
+
+    // z starts out as c, which is the reference's second point plus dc
+    double dx = dcx;
+    double dy = dcy;
+    int m = 1;
+    int iter = 0;
+    float magnitude = 0;
+
+    // without even a second reference point, start from the beginning of the orbit
+    if( refLast < 1 )
+    {
+      dx = refX[0] + dx;
+      dy = refY[0] + dy;
+      m = 0;
+    }
+
+    while( iter < max )
+    {
+      double zx = refX[m] + dx;
+      double zy = refY[m] + dy;
+      double zMag = zx*zx + zy*zy;
+      if( zMag > 4 )
+      {
+        magnitude = (float) sqrt( zMag );
+        break;
+      }
+
+      if( zMag < dx*dx + dy*dy || m == refLast )
+      {
+        dx = zx;
+        dy = zy;
+        m = 0;
+        rebases++;
+      }
+
+      double ax = 2*refX[m] + dx;
+      double ay = 2*refY[m] + dy;
+      double ndx = ax*dx - ay*dy + dcx;
+      double ndy = ax*dy + ay*dx + dcy;
+      dx = ndx;
+      dy = ndy;
+
+      m++;
+      iter++;
+    }
+
+    iters[k] = iter;
+    if( magnitudes != NULL )
+    {
+      magnitudes[k] = magnitude;
+    }
+  }
+
+  if( rebases > 0 )
+  {
+    atomic_fetch_add( &REBASED_PIXELS, rebases );
+  }
+} // escapeTimePerturbation()
+
+/*
+ * function: 
+ *  hpFromString
+ * 
+ * description: 
+ *  Converts a plain decimal number (an optional sign, digits, and an optional decimal point) 
+ *    into a high-precision number, keeping as many of its digits as the limbs can hold.
+ * 
+ * parameters:
+ *  const char * text: the number to convert
+ *  struct hpNumber * result: receives the converted number
+ * 
+ * returns: 
+ *  bool: false if the text isn't a plain decimal number, otherwise true
+ */
+static bool hpFromString( const char * text, struct hpNumber * result )
+{
+  memset( result, 0, sizeof(*result) );
+
+  const char * p = text;
+  if( *p == '-' || *p == '+' )
+  {
+    result->negative = *p == '-';
+    p++;
+  }
+
+  // the integer part accumulates in limb 0
+  const char * digits = p;
+  while( isdigit( (unsigned char) *p ) )
+  {
+    result->limb[0] = result->limb[0] * 10 + ( *p - '0' );
+    p++;
+  }
+
+  // the fraction is built up from its last digit back: f = ( digit + f ) / 10
+  const char * fraction = NULL;
+  if( *p == '.' )
+  {
+    p++;
+    fraction = p;
+    while( isdigit( (unsigned char) *p ) )
+    {
+      p++;
+    }
+  }
+
+  if( *p != '\0' || p == digits || ( fraction == p && fraction == digits + 1 ) )
+  {
+    return false;
+  }
+
+  if( fraction != NULL )
+  {
+    const char * d;
+    uint32_t fractionLimbs[HP_LIMBS] = { 0 };
+    for( d=p-1 ; d>=fraction ; d-- )
+    {
+      uint64_t remainder = (uint64_t) ( *d - '0' );
+      int i;
+      for( i=1 ; i<HP_LIMBS ; i++ )
+      {
+        uint64_t current = ( remainder << 32 ) | fractionLimbs[i];
+        fractionLimbs[i] = (uint32_t) ( current / 10 );
+        remainder = current % 10;
+      }
+    }
+    memcpy( result->limb + 1, fractionLimbs + 1, ( HP_LIMBS - 1 ) * sizeof(uint32_t) );
+  }
+
+  return true;
+} // hpFromString()
+
+/*
+ * function: 
+ *  hpFromDouble
+ * 
+ * description: 
+ *  Converts a double into a high-precision number. Every double below 2^32 converts exactly.
+ * 
+ * parameters:
+ *  double value: the number to convert
+ *  struct hpNumber * result: receives the converted number
+ * 
+ * returns: 
+ *  void
+ */
+static void hpFromDouble( double value, struct hpNumber * result )
+{
+  memset( result, 0, sizeof(*result) );
+  result->negative = value < 0;
+
+  double remaining = fabs(value);
+  int i;
+  for( i=0 ; i<HP_LIMBS && remaining > 0 ; i++ )
+  {
+    result->limb[i] = (uint32_t) remaining;
+    remaining = ( remaining - result->limb[i] ) * 4294967296.0;
+  }
+} // hpFromDouble()
+
+/*
+ * function: 
+ *  hpToDouble
+ * 
+ * description: 
+ *  Rounds a high-precision number to the nearest-ish double (the lower limbs are truncated).
+ * 
+ * parameters:
+ *  const struct hpNumber * a: the number to convert
+ * 
+ * returns: 
+ *  double: the converted number
+ */
+static double hpToDouble( const struct hpNumber * a )
+{
+  // the first three limbs already hold more bits than a double can
+  double value = a->limb[0] + ldexp( a->limb[1], -32 ) + ldexp( a->limb[2], -64 ) + ldexp( a->limb[3], -96 );
+  return a->negative ? -value : value;
+} // hpToDouble()
+
+/*
+ * function: 
+ *  hpAddMagnitudes, hpSubMagnitudes, hpCompareMagnitudes
+ * 
+ * description: 
+ *  Helpers for hpAdd() and hpSub() that work on the limbs alone, ignoring signs. 
+ *  hpSubMagnitudes() expects the magnitude of a to be at least the magnitude of b.
+ */
+static void hpAddMagnitudes( const uint32_t * a, const uint32_t * b, uint32_t * result )
+{
+  uint64_t carry = 0;
+  int i;
+  for( i=HP_LIMBS-1 ; i>=0 ; i-- )
+  {
+    uint64_t sum = (uint64_t) a[i] + b[i] + carry;
+    result[i] = (uint32_t) sum;
+    carry = sum >> 32;
+  }
+}
+
+static void hpSubMagnitudes( const uint32_t * a, const uint32_t * b, uint32_t * result )
+{
+  int64_t borrow = 0;
+  int i;
+  for( i=HP_LIMBS-1 ; i>=0 ; i-- )
+  {
+    int64_t difference = (int64_t) a[i] - b[i] - borrow;
+    borrow = difference < 0;
+    result[i] = (uint32_t) ( difference + ( borrow << 32 ) );
+  }
+}
+
+static int hpCompareMagnitudes( const uint32_t * a, const uint32_t * b )
+{
+  int i;
+  for( i=0 ; i<HP_LIMBS ; i++ )
+  {
+    if( a[i] != b[i] )
+    {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * function: 
+ *  hpAdd
+ * 
+ * description: 
+ *  Adds two high-precision numbers. result may be the same as either input.
+ * 
+ * parameters:
+ *  const struct hpNumber * a: the first number
+ *  const struct hpNumber * b: the second number
+ *  struct hpNumber * result: receives a + b
+ * 
+ * returns: 
+ *  void
+ */
+static void hpAdd( const struct hpNumber * a, const struct hpNumber * b, struct hpNumber * result )
+{
+  if( a->negative == b->negative )
+  {
+    result->negative = a->negative;
+    hpAddMagnitudes( a->limb, b->limb, result->limb );
+  }
+  else if( hpCompareMagnitudes( a->limb, b->limb ) >= 0 )
+  {
+    result->negative = a->negative;
+    hpSubMagnitudes( a->limb, b->limb, result->limb );
+  }
+  else
+  {
+    result->negative = b->negative;
+    hpSubMagnitudes( b->limb, a->limb, result->limb );
+  }
+} // hpAdd()
+
+/*
+ * function: 
+ *  hpSub
+ * 
+ * description: 
+ *  Subtracts one high-precision number from another. result may be the same as either input.
+ * 
+ * parameters:
+ *  const struct hpNumber * a: the number to subtract from
+ *  const struct hpNumber * b: the number to subtract
+ *  struct hpNumber * result: receives a - b
+ * 
+ * returns: 
+ *  void
+ */
+static void hpSub( const struct hpNumber * a, const struct hpNumber * b, struct hpNumber * result )
+{
+  struct hpNumber negatedB = *b;
+  negatedB.negative = !b->negative;
+  hpAdd( a, &negatedB, result );
+} // hpSub()
+
+/*
+ * function: 
+ *  hpMul
+ * 
+ * description: 
+ *  Multiplies two high-precision numbers with schoolbook long multiplication, truncating the 
+ *    bits that fall below the last limb. result may be the same as either input.
+ * 
+ * parameters:
+ *  const struct hpNumber * a: the first number
+ *  const struct hpNumber * b: the second number
+ *  struct hpNumber * result: receives a * b
+ * 
+ * returns: 
+ *  void
+ */
+static void hpMul( const struct hpNumber * a, const struct hpNumber * b, struct hpNumber * result )
+{
+  // the full product has twice the limbs, with its integer part in product[1]
+  uint32_t product[2*HP_LIMBS] = { 0 };
+  int i,j;
+  for( i=HP_LIMBS-1 ; i>=0 ; i-- )
+  {
+    uint64_t carry = 0;
+    for( j=HP_LIMBS-1 ; j>=0 ; j-- )
+    {
+      uint64_t t = (uint64_t) a->limb[i] * b->limb[j] + product[i+j+1] + carry;
+      product[i+j+1] = (uint32_t) t;
+      carry = t >> 32;
+    }
+    product[i] = (uint32_t) carry;
+  }
+
+  result->negative = a->negative != b->negative;
+  memcpy( result->limb, product + 1, HP_LIMBS * sizeof(uint32_t) );
+} // hpMul()
+
+/*
+Return the number of iterations at point x, y
+in the Mandelbrot space, up to a maximum of max.
+*/
+
+static int iterations_at_point( double x, double y, int max )
+{
+  double x0 = x;
+  double y0 = y;
+
+  int iter = 0;
+
+  while( (x*x + y*y <= 4) && iter < max ) {
+
+    double xt = x*x - y*y + x0;
+    double yt = 2*x*y + y0;
+
+    x = xt;
+    y = yt;
+
+    iter++;
+  }
+
+  return iter;
+}
+
+/*
+Same as iterations_at_point(), but also watches for the orbit settling into a cycle,
+using Brent's method: the orbit point is saved on every power-of-two iteration, and
+if a later point comes back within tolerance of the saved one the orbit is periodic.
+A periodic point never escapes, so max is returned right away.
+*/
+
+static int periodic_iterations_at_point( double x, double y, int max, double tolerance )
+{
+  double x0 = x;
+  double y0 = y;
+  double savedX = x;
+  double savedY = y;
+
+  int iter = 0;
+
+  while( (x*x + y*y <= 4) && iter < max ) {
+
+    double xt = x*x - y*y + x0;
+    double yt = 2*x*y + y0;
+
+    x = xt;
+    y = yt;
+
+    iter++;
+
+    if( fabs(x - savedX) < tolerance && fabs(y - savedY) < tolerance ) {
+      return max;
+    }
+
+    // save a new checkpoint each time iter reaches a power of two
+    if( ( iter & (iter-1) ) == 0 ) {
+      savedX = x;
+      savedY = y;
+    }
+  }
+
+  return iter;
+}
+
+/*
+Same as periodic_iterations_at_point() (or iterations_at_point() when tolerance is 0),
+but carrying on from an orbit point *x, *y that was reached after iter iterations,
+and leaving the last orbit point in *x, *y. When the orbit turns out to be periodic,
+*x and *y are set to NAN, since there's nothing left to carry on from.
+*/
+
+static int orbit_iterations_at_point( double x0, double y0, double * x, double * y, int iter, int max, double tolerance )
+{
+  double zx = *x;
+  double zy = *y;
+  double savedX = zx;
+  double savedY = zy;
+
+  while( (zx*zx + zy*zy <= 4) && iter < max ) {
+
+    double xt = zx*zx - zy*zy + x0;
+    double yt = 2*zx*zy + y0;
+
+    zx = xt;
+    zy = yt;
+
+    iter++;
+
+    if( tolerance > 0 && fabs(zx - savedX) < tolerance && fabs(zy - savedY) < tolerance ) {
+      *x = NAN;
+      *y = NAN;
+      return max;
+    }
+
+    // save a new checkpoint each time iter reaches a power of two
+    if( ( iter & (iter-1) ) == 0 ) {
+      savedX = zx;
+      savedY = zy;
+    }
+  }
+
+  *x = zx;
+  *y = zy;
+  return iter;
+}
+
+/*
+Same as periodic_iterations_at_point() (or iterations_at_point() when tolerance is 0),
+but in single precision, for -p float on shallow views where floats are nearly enough. Also
+sets *magnitude to |z| at the moment the point escaped, or 0 if it didn't.
+*/
+
+static int float_iterations_at_point( float x, float y, int max, float tolerance, float * magnitude )
+{
+  float x0 = x;
+  float y0 = y;
+  float savedX = x;
+  float savedY = y;
+
+  int iter = 0;
+
+  while( (x*x + y*y <= 4) && iter < max ) {
+
+    float xt = x*x - y*y + x0;
+    float yt = 2*x*y + y0;
+
+    x = xt;
+    y = yt;
+
+    iter++;
+
+    if( tolerance > 0 && fabsf(x - savedX) < tolerance && fabsf(y - savedY) < tolerance ) {
+      *magnitude = 0;
+      return max;
+    }
+
+    // save a new checkpoint each time iter reaches a power of two
+    if( ( iter & (iter-1) ) == 0 ) {
+      savedX = x;
+      savedY = y;
+    }
+  }
+
+  *magnitude = iter < max ? sqrtf( x*x + y*y ) : 0;
+  return iter;
+}
+
+/*
+Return |z| after iterating point x, y exactly iters times, the same way
+iterations_at_point() does. Given the count iterations_at_point() returned
+for an escaping point, this is |z| at the moment it escaped.
+*/
+
+static float escape_magnitude_at_point( double x, double y, int iters )
+{
+  double x0 = x;
+  double y0 = y;
+
+  int iter;
+  for( iter=0 ; iter<iters ; iter++ ) {
+
+    double xt = x*x - y*y + x0;
+    double yt = 2*x*y + y0;
+
+    x = xt;
+    y = yt;
   }
 
-  return iteration_to_color(iter,max);
+  return (float) sqrt( x*x + y*y );
 }
 
 /*
@@ -0,0 +1,481 @@
+/*
+ * Name: Matt Hamrick
+ * ID: 1000433109
+ *
+ * Description:
+ *  client for the mandel render server (mandel -D). It asks the server for one image and saves it,
+ *  or, to load the server, opens several connections at once and sends a number of requests down
+ *  each of them without waiting for the answers, then reports how many came back and how long
+ *  they took (the median and 95th percentile latency, and the requests per second).
+ *  It can also cancel every request right after sending it, and ask the server to shut down.
+ *
+ * Ask the server started with ./mandel -D mandel.sock -n 8 for the final image of the series:
+ * ./mandelclient -D mandel.sock -x -.163013 -y -1.03265 -s .000025 -m 7000 -W 600 -H 600 -o mandel.bmp
+ *
+ * 8 connections sending 50 small tiles each, then shut the server down:
+ * ./mandelclient -D mandel.sock -s .01 -x -.7435 -y .1 -W 256 -H 256 -c 8 -N 50 -q
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// enable/disable debug output
+bool DBG = false;
+
+// the server to ask, and the view to ask it for
+const char * SOCKET_PATH = "mandel.sock";
+const char * XCENTER = "0";
+const char * YCENTER = "0";
+const char * SCALE = "4";
+int MAX = 1000;
+int WIDTH = 500;
+int HEIGHT = 500;
+int PRIORITY = 0;
+const char * OUTFILE = "mandel.bmp";
+
+// how many connections to open at once, and how many requests to send down each one
+int CONNECTIONS = 1;
+int REQUESTS = 1;
+
+// enable/disable cancelling every request right after it's sent
+bool CANCEL = false;
+
+// the longest line the server answers with, before the image bytes
+#define REPLY_LENGTH 256
+
+// this struct holds what one connection sent and got back, for the thread that runs it
+struct connectionResults{
+  int number;
+  long * latencies;
+  struct timeval * sent;
+  int ok;
+  int cancelled;
+  int errors;
+  bool failed;
+};
+
+// function declarations (implementations after main())
+void show_help( void );
+static int connectToServer( void );
+void * runConnection( void * );
+static bool readImage( FILE * in, long long bytes, FILE * out );
+static long elapsedUsec( struct timeval * start, struct timeval * end );
+static int compareLongs( const void * a, const void * b );
+
+int main( int argc, char * argv[] )
+{
+  bool shutdownServer = false;
+
+  char c;
+  while( ( c = getopt( argc, argv, "D:x:y:s:m:W:H:P:o:N:c:Xqdh" ) ) != -1 )
+  {
+    switch( c )
+    {
+      case 'D':
+        SOCKET_PATH = optarg;
+        break;
+      case 'x':
+        XCENTER = optarg;
+        break;
+      case 'y':
+        YCENTER = optarg;
+        break;
+      case 's':
+        SCALE = optarg;
+        break;
+      case 'm':
+        MAX = atoi(optarg);
+        break;
+      case 'W':
+        WIDTH = atoi(optarg);
+        break;
+      case 'H':
+        HEIGHT = atoi(optarg);
+        break;
+      case 'P':
+        PRIORITY = atoi(optarg);
+        break;
+      case 'o':
+        OUTFILE = optarg;
+        break;
+      case 'N':
+        REQUESTS = atoi(optarg);
+        break;
+      case 'c':
+        CONNECTIONS = atoi(optarg);
+        break;
+      case 'X':
+        CANCEL = true;
+        break;
+      case 'q':
+        shutdownServer = true;
+        break;
+      case 'd':
+        DBG = true;
+        break;
+      case 'h':
+        show_help();
+        exit(1);
+        break;
+    }
+  }
+
+  if( REQUESTS < 0 || CONNECTIONS < 1 )
+  {
+    printf("Invalid value for parameter -N or -c, please try again. Please use mandelclient -h to see the help output.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct connectionResults * results = calloc( CONNECTIONS, sizeof(struct connectionResults) );
+  pthread_t * threadsArr = calloc( CONNECTIONS, sizeof(pthread_t) );
+  if( results == NULL || threadsArr == NULL )
+  {
+    printf("An error occurred. Please try again\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct timeval runStart;
+  struct timeval runEnd;
+  gettimeofday( &runStart, NULL );
+
+  // every connection gets a thread of its own, so they all keep the server busy at once
+  int i;
+  if( REQUESTS > 0 )
+  {
+    for( i=0 ; i<CONNECTIONS ; i++ )
+    {
+      results[i].number = i+1;
+      if( pthread_create( &threadsArr[i], NULL, runConnection, (void *) &results[i] ) != 0 )
+      {
+        printf("There was an issue creating threads, and the program must exit.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    for( i=0 ; i<CONNECTIONS ; i++ )
+    {
+      pthread_join( threadsArr[i], NULL );
+    }
+  }
+
+  gettimeofday( &runEnd, NULL );
+
+  // put every connection's latencies together for the report
+  int ok = 0, cancelled = 0, errors = 0;
+  bool failed = false;
+  long * latencies = malloc( ( (size_t) CONNECTIONS * REQUESTS + 1 ) * sizeof(long) );
+  if( latencies == NULL )
+  {
+    printf("An error occurred. Please try again\n");
+    exit(EXIT_FAILURE);
+  }
+  for( i=0 ; i<CONNECTIONS && REQUESTS > 0 ; i++ )
+  {
+    memcpy( latencies + ok, results[i].latencies, results[i].ok * sizeof(long) );
+    ok += results[i].ok;
+    cancelled += results[i].cancelled;
+    errors += results[i].errors;
+    failed = failed || results[i].failed;
+    free( results[i].latencies );
+    free( results[i].sent );
+  }
+
+  if( REQUESTS > 0 )
+  {
+    long usec = elapsedUsec( &runStart, &runEnd );
+    printf( "mandelclient: %d ok, %d cancelled, %d errors, time taken (in usec): %ld, %.1f requests/s\n", ok, cancelled, errors, usec,
+      usec > 0 ? ( ok + cancelled ) * 1e6 / usec : 0.0 );
+  }
+  if( ok > 0 )
+  {
+    qsort( latencies, ok, sizeof(long), compareLongs );
+    int rank = ( 95 * ok + 99 ) / 100;
+    printf( "mandelclient: latency (in usec): min %ld, median %ld, p95 %ld, max %ld\n", latencies[0], latencies[(ok-1)/2],
+      latencies[rank-1], latencies[ok-1] );
+  }
+  free( latencies );
+  free( results );
+  free( threadsArr );
+
+  if( shutdownServer )
+  {
+    int fd = connectToServer();
+    if( fd < 0 || write( fd, "SHUTDOWN\n", 9 ) != 9 )
+    {
+      failed = true;
+    }
+    if( fd >= 0 )
+    {
+      close( fd );
+    }
+  }
+
+  exit( failed || errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS );
+}
+
+/*
+ * function:
+ *  show_help
+ *
+ * description:
+ *  prints how to use mandelclient
+ *
+ * parameters:
+ *  none
+ *
+ * returns:
+ *  void
+ */
+void show_help( void )
+{
+  printf("Use: mandelclient [options]\n");
+  printf("Where options are:\n");
+  printf("-D <socket>  The socket the server (mandel -D) is listening on. (default=mandel.sock)\n");
+  printf("-x <coord>   X coordinate of image center point. (default=0)\n");
+  printf("-y <coord>   Y coordinate of image center point. (default=0)\n");
+  printf("-s <scale>   Scale of the image in Mandlebrot coordinates. (default=4)\n");
+  printf("-m <max>     The maximum number of iterations per point. (default=1000)\n");
+  printf("-W <pixels>  Width of the image in pixels. (default=500)\n");
+  printf("-H <pixels>  Height of the image in pixels. (default=500)\n");
+  printf("-P <prio>    Priority of the requests, higher goes first. (default=0)\n");
+  printf("-o <file>    Save the image here, when only one is asked for. (default=mandel.bmp)\n");
+  printf("-N <count>   Number of requests to send down each connection. (default=1)\n");
+  printf("-c <conns>   Number of connections to open at once. (default=1)\n");
+  printf("-X           Cancel every request right after sending it.\n");
+  printf("-q           Ask the server to shut down once the requests are answered.\n");
+  printf("-h           Show this help text.\n");
+}
+
+/*
+ * function:
+ *  connectToServer
+ *
+ * description:
+ *  opens a connection to the server's socket
+ *
+ * parameters:
+ *  none
+ *
+ * returns:
+ *  int: the connected socket, or -1 if the server couldn't be reached
+ */
+static int connectToServer( void )
+{
+  struct sockaddr_un address;
+  memset( &address, 0, sizeof(address) );
+  address.sun_family = AF_UNIX;
+  snprintf( address.sun_path, sizeof(address.sun_path), "%s", SOCKET_PATH );
+
+  int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if( fd < 0 || connect( fd, (struct sockaddr *) &address, sizeof(address) ) != 0 )
+  {
+    fprintf(stderr,"mandelclient: couldn't connect to %s: %s\n",SOCKET_PATH,strerror(errno));
+    if( fd >= 0 )
+    {
+      close( fd );
+    }
+    return -1;
+  }
+  return fd;
+} // connectToServer()
+
+/*
+ * function:
+ *  runConnection
+ *
+ * description:
+ *  Thread entry point for one connection. Sends all REQUESTS requests down it straight away (cancelling
+ *    each one right after with -X), then reads the answers in whatever order they come back, timing
+ *    each request from when it was sent. With a single request in the whole run, its image is saved.
+ *  With -X the server may have finished a request before its CANCEL arrived, in which case the
+ *    answer is the image and the CANCEL gets an error of its own, which isn't counted.
+ *
+ * parameters:
+ *  void * args: void ptr since it's a new thread entry point. The incoming structure is of type connectionResults
+ *
+ * returns:
+ *  void *
+ */
+void * runConnection( void * args )
+{
+  struct connectionResults * results = args;
+  results->latencies = calloc( REQUESTS, sizeof(long) );
+  results->sent = calloc( REQUESTS, sizeof(struct timeval) );
+  int fd = connectToServer();
+  int outFd = fd >= 0 ? dup( fd ) : -1;
+  FILE * in = fd >= 0 ? fdopen( fd, "r" ) : NULL;
+  FILE * out = outFd >= 0 ? fdopen( outFd, "w" ) : NULL;
+  if( results->latencies == NULL || results->sent == NULL || in == NULL || out == NULL )
+  {
+    results->failed = true;
+    return NULL;
+  }
+
+  int i;
+  for( i=0 ; i<REQUESTS ; i++ )
+  {
+    gettimeofday( &results->sent[i], NULL );
+    fprintf( out, "RENDER %d-%d %d %s %s %s %d %d %d\n", results->number, i, PRIORITY, XCENTER, YCENTER, SCALE, MAX, WIDTH, HEIGHT );
+    if( CANCEL )
+    {
+      fprintf( out, "CANCEL %d-%d\n", results->number, i );
+    }
+  }
+  fflush( out );
+
+  char reply[REPLY_LENGTH];
+  int answered = 0;
+  while( answered < REQUESTS && fgets( reply, sizeof(reply), in ) != NULL )
+  {
+    char status[16];
+    int connection, request;
+    long long bytes = 0;
+    struct timeval received;
+    gettimeofday( &received, NULL );
+
+    if( sscanf( reply, "%15s %d-%d %lld", status, &connection, &request, &bytes ) < 3 || request < 0 || request >= REQUESTS )
+    {
+      fprintf(stderr,"mandelclient: unexpected answer from the server: %s",reply);
+      results->failed = true;
+      break;
+    }
+
+    if(DBG)
+    {
+      printf( "DEBUG: runConnection(): connection %d: %s", results->number, reply );
+    }
+
+    if( strcmp( status, "OK" ) == 0 )
+    {
+      FILE * image = NULL;
+      if( CONNECTIONS == 1 && REQUESTS == 1 )
+      {
+        image = fopen( OUTFILE, "wb" );
+        if( image == NULL )
+        {
+          fprintf(stderr,"mandelclient: couldn't write to %s: %s\n",OUTFILE,strerror(errno));
+          results->failed = true;
+        }
+      }
+      bool read = readImage( in, bytes, image );
+      if( image != NULL && fclose( image ) != 0 )
+      {
+        fprintf(stderr,"mandelclient: couldn't write to %s: %s\n",OUTFILE,strerror(errno));
+        results->failed = true;
+      }
+      if( !read )
+      {
+        fprintf(stderr,"mandelclient: the server hung up in the middle of an image\n");
+        results->failed = true;
+        break;
+      }
+      results->latencies[results->ok++] = elapsedUsec( &results->sent[request], &received );
+      answered++;
+    }
+    else if( strcmp( status, "CANCELLED" ) == 0 )
+    {
+      results->cancelled++;
+      answered++;
+    }
+    else if( !( CANCEL && strstr( reply, "no such request" ) != NULL ) )
+    {
+      fprintf(stderr,"mandelclient: %s",reply);
+      results->errors++;
+      answered++;
+    }
+  }
+
+  if( answered < REQUESTS && !results->failed )
+  {
+    fprintf(stderr,"mandelclient: connection %d: the server hung up with %d requests unanswered\n",results->number,REQUESTS-answered);
+    results->failed = true;
+  }
+
+  fclose( in );
+  fclose( out );
+  return NULL;
+} // runConnection()
+
+/*
+ * function:
+ *  readImage
+ *
+ * description:
+ *  reads the bytes of an image the server sent, and saves them if there's somewhere to save them
+ *
+ * parameters:
+ *  FILE * in: the connection
+ *  long long bytes: how many bytes the server said the image is
+ *  FILE * out: where to save it, or NULL to throw it away
+ *
+ * returns:
+ *  bool: true if all the bytes arrived
+ */
+static bool readImage( FILE * in, long long bytes, FILE * out )
+{
+  char buffer[65536];
+  while( bytes > 0 )
+  {
+    size_t wanted = bytes < (long long) sizeof(buffer) ? (size_t) bytes : sizeof(buffer);
+    size_t got = fread( buffer, 1, wanted, in );
+    if( got == 0 )
+    {
+      return false;
+    }
+    if( out != NULL )
+    {
+      fwrite( buffer, 1, got, out );
+    }
+    bytes -= got;
+  }
+  return true;
+} // readImage()
+
+/*
+ * function:
+ *  elapsedUsec
+ *
+ * description:
+ *  the time between two gettimeofday() values, in microseconds
+ *
+ * parameters:
+ *  struct timeval * start: the earlier time
+ *  struct timeval * end: the later time
+ *
+ * returns:
+ *  long: end - start in microseconds
+ */
+static long elapsedUsec( struct timeval * start, struct timeval * end )
+{
+  return ( end->tv_sec - start->tv_sec ) * 1000000L + ( end->tv_usec - start->tv_usec );
+} // elapsedUsec()
+
+/*
+ * function:
+ *  compareLongs
+ *
+ * description:
+ *  qsort() comparison for sorting longs in increasing order
+ *
+ * parameters:
+ *  const void * a, const void * b: the longs to compare
+ *
+ * returns:
+ *  int: negative, 0 or positive as a is less than, equal to or greater than b
+ */
+static int compareLongs( const void * a, const void * b )
+{
+  long x = *(const long *) a;
+  long y = *(const long *) b;
+  return ( x > y ) - ( x < y );
+} // compareLongs()
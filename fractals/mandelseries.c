@@ -5,6 +5,10 @@
  * Description:
  *  runs, in parallel, a user-provided number of child mandel processes to generate 
  *  mandel images, starting with a scale of 2, down to the desired scale amount.
+ *  mandel -Z follows the same zoom path in a single process with one set of threads,
+ *  which avoids starting a new mandel process (and its threads) for every frame. Its
+ *  scales aren't rounded to 6 decimal places the way the ones passed on from here are,
+ *  so its deeper frames can come out slightly different from these.
  * 
  * Mandel command for the final image:
  * ./mandel -s .000025 -y -1.03265 -m 7000 -x -.163013 -W 600 -H 600
@@ -149,8 +153,9 @@ void runSeries( int maxRunningProcs )
   char * bmpExtension = ".bmp";
 
   // this string will hold the output image filename
-  // allocate enough bytes to hold the longest filename: mandel##.bmp\0 = 12 chars + \0
-  char bmpFilename[13];
+  // allocate enough bytes to hold the longest filename: mandel, the frame number (up to the 
+  // 11 characters bmpNum holds, the most an int can take), .bmp and the \0 = 22 chars
+  char bmpFilename[22];
 
   // initialize counter to track how many images have been created
   int bmpCount = 0;
@@ -235,7 +240,7 @@ void runSeries( int maxRunningProcs )
 
           // build the filename to be created and sent to the mandel program
           strcpy( bmpFilename, bmpName );
-          char bmpNum[2];
+          char bmpNum[12];
           sprintf( bmpNum, "%d", bmpCount+1 );
           strcat( bmpFilename, bmpNum );
           strcat( bmpFilename, bmpExtension );